@@ -37,8 +37,7 @@
 // non-inline member fuctions //
 // ************************** //
 
-DL_bar::DL_bar():DL_constraint(),
-  dcdp(1,3), dfdr(3,1) {
+DL_bar::DL_bar():DL_constraint() {
   dim=1;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -98,7 +97,7 @@ void DL_bar::init(DL_dyna* _d, DL_point* _pd,
     }
   }
   if (lv.norm()>DL_constraints->max_error) {
-    DL_dsystem->get_companion()->Msg("Warning: initially invalid bar-constraint.\n Error: %f\n", lv.get(0) );
+    DL_dsystem->get_companion()->Msg("Warning: initially invalid bar-constraint.\n Error: %f\n", DL_value(lv.get(0)) );
   }
 
   DL_point pdw;
@@ -144,42 +143,39 @@ void DL_bar::end_test(void) {
   if (g_is_dyna) ((DL_dyna*)g)->endtest();
 }
 
-boolean DL_bar::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_bar::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf;
-  static DL_largematrix subtemp;
+  DL_jacblock dcdf;
+  DL_subblock subtemp;
   boolean nonzero;
-  dcdf.resize(cc->dim,3);
-  if (nonzero=cc->dCdFq(d,&pd,&dcdf)) dcdf.times(&dfdr,sub);
+  if (nonzero=cc->dCdFq(d,&pd,&dcdf)) dcdf.times(&dfdr,sub,cc->dim);
   if (g_is_dyna) {
    if (nonzero) {
     if (cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) {
-      subtemp.resize(cc->dim,dim);
-      dcdf.times(&dfdr,&subtemp);
-      sub->minusis(&subtemp);
+      dcdf.times(&dfdr,&subtemp,cc->dim);
+      sub->minusis(&subtemp,cc->dim,dim);
     }
    }
    else {
     if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) {
-      dcdf.times(&dfdr,sub);
-      sub->neg();
+      dcdf.times(&dfdr,sub,cc->dim);
+      sub->neg(cc->dim,dim);
     }
    }
   }
   return nonzero;
 }
 
-boolean DL_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dpdFq_(3,3);
   DL_matrix dpdFq;
   DL_matrix ddpdFq;
   if (d==dc) {
@@ -189,8 +185,7 @@ boolean DL_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdFq.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdFq);
       dpdFq.plus(&ddpdFq,&dpdFq);
     }
-    dpdFq_.assign(&dpdFq);
-    dcdp.times(&dpdFq_,dcdfq);
+    dcdp.times(&dpdFq,dcdfq);
     return TRUE;
   }
   if (g==dc) {
@@ -200,20 +195,18 @@ boolean DL_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdFq.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdFq);
       dpdFq.plus(&ddpdFq,&dpdFq);
     }
-    dpdFq_.assign(&dpdFq);
-    dcdp.times(&dpdFq_,dcdfq);
-    dcdfq->neg();
+    dcdp.times(&dpdFq,dcdfq);
+    dcdfq->neg(dim);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_bar::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_bar::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dpdf_(3,3);
   DL_matrix dpdf;
   DL_matrix ddpdf;
   if (d==dc) {
@@ -223,8 +216,7 @@ boolean DL_bar::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdf.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdf);
       dpdf.plus(&ddpdf,&dpdf);
     }
-    dpdf_.assign(&dpdf);
-    dcdp.times(&dpdf_,dcdf);
+    dcdp.times(&dpdf,dcdf);
     return TRUE;
   }
   if (g==dc) {
@@ -234,21 +226,19 @@ boolean DL_bar::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdf.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdf);
       dpdf.plus(&ddpdf,&dpdf);
     }
-    dpdf_.assign(&dpdf);
-    dcdp.times(&dpdf_,dcdf);
-    dcdf->neg();
+    dcdp.times(&dpdf,dcdf);
+    dcdf->neg(dim);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_bar::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_bar::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dpdm_(3,3);
   DL_matrix dpdm;
   DL_matrix ddpdm;
   if (d==dc) {
@@ -258,8 +248,7 @@ boolean DL_bar::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdm.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdm);
       dpdm.plus(&ddpdm,&dpdm);
     }
-    dpdm_.assign(&dpdm);
-    dcdp.times(&dpdm_,dcdm);
+    dcdp.times(&dpdm,dcdm);
     return TRUE;
   }
   if (g==dc) {
@@ -269,21 +258,19 @@ boolean DL_bar::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdm.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdm);
       dpdm.plus(&ddpdm,&dpdm);
     }
-    dpdm_.assign(&dpdm);
-    dcdp.times(&dpdm_,dcdm);
-    dcdm->neg();
+    dcdp.times(&dpdm,dcdm);
+    dcdm->neg(dim);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dpdi_(3,3);
   DL_matrix dpdi;
   DL_matrix ddpdi;
   if (d==dc) {
@@ -293,8 +280,7 @@ boolean DL_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdi.timesis(DL_dsystem->get_integrator()->halfstepsize());
       dpdi.plus(&ddpdi,&dpdi);
     }
-    dpdi_.assign(&dpdi);
-    dcdp.times(&dpdi_,dcdi);
+    dcdp.times(&dpdi,dcdi);
     return TRUE;
   }
   if (g==dc) {
@@ -304,9 +290,8 @@ boolean DL_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdi.timesis(DL_dsystem->get_integrator()->halfstepsize());
       dpdi.plus(&ddpdi,&dpdi);
     }
-    dpdi_.assign(&dpdi);
-    dcdp.times(&dpdi_,dcdi);
-    dcdi->neg();
+    dcdp.times(&dpdi,dcdi);
+    dcdi->neg(dim);
     return TRUE;
   }
   return FALSE;
@@ -338,19 +323,7 @@ void DL_bar::new_frame(void) {
 }
 
 void DL_bar::first_estimate(void) {
-  if (oldF->norm()==0.0) {
-    // constant extrapolation:
-    oldF->assign(F);
-  }
-  else {
-    // linear extrapolation:
-    DL_largevector dF(dim);
-    F->minus(oldF,&dF);
-    oldF->assign(F);
-    dF.timesis(stiffness);
-    F->plusis(&dF);
-  }
-  
+  extrapolate();
   if (check_restrictions()) apply_restrictions(F);
 }
 
@@ -398,8 +371,8 @@ boolean DL_bar::check_restrictions() {
 void DL_bar::apply_restrictions(DL_largevector* lv) {
   DL_vector force;
   force.init(lv->get(0)*dfdr.get(0,0),
-             lv->get(0)*dfdr.get(0,1),
-	     lv->get(0)*dfdr.get(0,2));
+             lv->get(0)*dfdr.get(1,0),
+	     lv->get(0)*dfdr.get(2,0));
   d->applyforce(&pd,d,&force);
   if (g_is_dyna) {
     force.neg(&force);
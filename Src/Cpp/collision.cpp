@@ -35,14 +35,31 @@
 #include "constraint_manager.h"
 #include "force_drawer.h"
 
+static DL_pool* DL_collision_pool() {
+  static DL_pool pool(sizeof(DL_collision));
+  return &pool;
+}
+
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
+void* DL_collision::operator new(size_t s) {
+  // (descendants of DL_collision have a different size, and simply
+  //  use the heap)
+  if (s==sizeof(DL_collision)) return DL_collision_pool()->alloc();
+  return ::operator new(s);
+}
+
+void DL_collision::operator delete(void *p, size_t s) {
+  if (s==sizeof(DL_collision)) DL_collision_pool()->free(p);
+  else ::operator delete(p);
+}
+
 DL_collision::DL_collision(DL_geo *_g0, DL_point *_p0,
                            DL_geo *_g1, DL_point *_p1,
                            DL_vector *_n, int mode):
-                   DL_constraint(),dcdX(1,3),dXdR(3,1) {
+                   DL_constraint() {
   dim=1;
   oldF->resize(dim); oldF->makezero();
   F->resize(dim); F->makezero();
@@ -146,26 +163,26 @@ void DL_collision::end_test(void) {
   if (g1_is_dyna) ((DL_dyna*)g1)->endtest();
 }
 
-boolean DL_collision::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_collision::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
   boolean nonzero=FALSE;
-  DL_largematrix dcdx(cc->dim,3); dcdx.makezero();
+  DL_jacblock dcdx; dcdx.makezero(cc->dim);
   if (g0_is_dyna) nonzero=cc->dCdFq((DL_dyna*)g0,&p0,&dcdx);
   if (g1_is_dyna) {
-    DL_largematrix dcdx1(cc->dim,3);
+    DL_jacblock dcdx1;
     if (cc->dCdFq((DL_dyna*)g1,&p1,&dcdx1)) {
-      dcdx.minusis(&dcdx1);
+      dcdx.minusis(&dcdx1,cc->dim);
       nonzero=TRUE;
     }
   }
   if (nonzero) {
-    DL_largematrix dcdrsub(cc->dim,1);
-    dcdx.times(&dXdR,&dcdrsub);
-    sub->setsubmatrix(0,0,&dcdrsub);
+    DL_fixmat<DL_MAXCDIM,1> dcdrsub;
+    dcdx.times(&dXdR,&dcdrsub,cc->dim);
+    sub->setsubmatrix(0,0,&dcdrsub,cc->dim);
   }
   if (dim==1) return nonzero;
   
@@ -173,60 +190,54 @@ boolean DL_collision::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
     if (cc->dCdI((DL_dyna*)g0,&p0,&dcdx)) nonzero=TRUE;
   }
   if (g1_is_dyna) {
-    DL_largematrix dcdx1(cc->dim,3);
+    DL_jacblock dcdx1;
     if (cc->dCdI((DL_dyna*)g1,&p1,&dcdx1)) {
-      dcdx.minusis(&dcdx1);
+      dcdx.minusis(&dcdx1,cc->dim);
       nonzero=TRUE;
     }
   }
   if (nonzero) {
-    DL_largematrix dcdrsub(cc->dim,1);
-    dcdx.times(&dXdR,&dcdrsub);
-    sub->setsubmatrix(0,1,&dcdrsub);
+    DL_fixmat<DL_MAXCDIM,1> dcdrsub;
+    dcdx.times(&dXdR,&dcdrsub,cc->dim);
+    sub->setsubmatrix(0,1,&dcdrsub,cc->dim);
   }
   return nonzero;
 }
 
-boolean DL_collision::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_collision::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
   if (dc==g0) {// which implies g0_is_dyna; there is an effect on C through g0
-    DL_largematrix dvdf(3,3);
     DL_matrix ddpdf;
     dc->ddpdfq(&p0,pc,&ddpdf);
-    dvdf.assign(&ddpdf);
-    dvdf.neg();
+    ddpdf.timesis(-1.0);
     if (dim==1)
-      dcdX.times(&dvdf,dcdfq);
+      dcdX.times(&ddpdf,dcdfq);
     else {
-      DL_largematrix dcdfqsub(1,3);
-      dcdX.times(&dvdf,&dcdfqsub);
+      DL_fixmat<1,3> dcdfqsub;
+      dcdX.times(&ddpdf,&dcdfqsub);
       dcdfq->setsubmatrix(0,0,&dcdfqsub);
       dc->dpdfq(&p0,pc,&ddpdf);
-      dvdf.assign(&ddpdf);
-      dvdf.neg();
-      dcdX.times(&dvdf,&dcdfqsub);
+      ddpdf.timesis(-1.0);
+      dcdX.times(&ddpdf,&dcdfqsub);
       dcdfq->setsubmatrix(1,0,&dcdfqsub);
     }
     return TRUE;
   }
   if (dc==g1) {// which implies g1_is_dyna; there is an effect on C through g1
-    DL_largematrix dvdf(3,3);
     DL_matrix ddpdf;
     dc->ddpdfq(&p1,pc,&ddpdf);
-    dvdf.assign(&ddpdf);
     if (dim==1)
-      dcdX.times(&dvdf,dcdfq);
+      dcdX.times(&ddpdf,dcdfq);
     else {
-      DL_largematrix dcdfqsub(1,3);
-      dcdX.times(&dvdf,&dcdfqsub);
+      DL_fixmat<1,3> dcdfqsub;
+      dcdX.times(&ddpdf,&dcdfqsub);
       dcdfq->setsubmatrix(0,0,&dcdfqsub);
       dc->dpdfq(&p1,pc,&ddpdf);
-      dvdf.assign(&ddpdf);
-      dcdX.times(&dvdf,&dcdfqsub);
+      dcdX.times(&ddpdf,&dcdfqsub);
       dcdfq->setsubmatrix(1,0,&dcdfqsub);
     }
     return TRUE;
@@ -234,45 +245,39 @@ boolean DL_collision::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
   return FALSE;
 }
 
-boolean DL_collision::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_collision::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
   if (dc==g0) {// which implies g0_is_dyna; there is an effect on C through g0
-    DL_largematrix dvdf(3,3);
     DL_matrix ddpdf;
     dc->ddpdF(&p0,&ddpdf);
-    dvdf.assign(&ddpdf);
-    dvdf.neg();
+    ddpdf.timesis(-1.0);
     if (dim==1)
-      dcdX.times(&dvdf,dcdf);
+      dcdX.times(&ddpdf,dcdf);
     else {
-      DL_largematrix dcdfsub(1,3);
-      dcdX.times(&dvdf,&dcdfsub);
+      DL_fixmat<1,3> dcdfsub;
+      dcdX.times(&ddpdf,&dcdfsub);
       dcdf->setsubmatrix(0,0,&dcdfsub);
       dc->dpdF(&p0,&ddpdf);
-      dvdf.assign(&ddpdf);
-      dvdf.neg();
-      dcdX.times(&dvdf,&dcdfsub);
+      ddpdf.timesis(-1.0);
+      dcdX.times(&ddpdf,&dcdfsub);
       dcdf->setsubmatrix(1,0,&dcdfsub);
     }
     return TRUE;
   }
   if (dc==g1) {// which implies g1_is_dyna; there is an effect on C through g1
-    DL_largematrix dvdf(3,3);
     DL_matrix ddpdf;
     dc->ddpdF(&p1,&ddpdf);
-    dvdf.assign(&ddpdf);
     if (dim==1)
-      dcdX.times(&dvdf,dcdf);
+      dcdX.times(&ddpdf,dcdf);
     else {
-      DL_largematrix dcdfsub(1,3);
-      dcdX.times(&dvdf,&dcdfsub);
+      DL_fixmat<1,3> dcdfsub;
+      dcdX.times(&ddpdf,&dcdfsub);
       dcdf->setsubmatrix(0,0,&dcdfsub);
       dc->dpdF(&p1,&ddpdf);
-      dvdf.assign(&ddpdf);
-      dcdX.times(&dvdf,&dcdfsub);
+      dcdX.times(&ddpdf,&dcdfsub);
       dcdf->setsubmatrix(1,0,&dcdfsub);
     }
     return TRUE;
@@ -280,46 +285,40 @@ boolean DL_collision::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
   return FALSE;
 }
 
-boolean DL_collision::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_collision::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
   if (dc==g0) {// which implies g0_is_dyna; there is an effect on C through g0
-    DL_largematrix dvdm(3,3);
     DL_matrix ddpdm;
     dc->ddpdM(&p0,&ddpdm);
-    dvdm.assign(&ddpdm);
-    dvdm.neg();
+    ddpdm.timesis(-1.0);
     if (dim==1)
-      dcdX.times(&dvdm,dcdm);
+      dcdX.times(&ddpdm,dcdm);
     else {
-      DL_largematrix dcdmsub(1,3);
-      dcdX.times(&dvdm,&dcdmsub);
+      DL_fixmat<1,3> dcdmsub;
+      dcdX.times(&ddpdm,&dcdmsub);
       dcdm->setsubmatrix(0,0,&dcdmsub);
       dc->dpdM(&p0,&ddpdm);
-      dvdm.assign(&ddpdm);
-      dvdm.neg();
-      dcdX.times(&dvdm,&dcdmsub);
+      ddpdm.timesis(-1.0);
+      dcdX.times(&ddpdm,&dcdmsub);
       dcdm->setsubmatrix(1,0,&dcdmsub);
     }
     return TRUE;
   }
   if (dc==g1) {// which implies g1_is_dyna; there is an effect on C through g1
-    DL_largematrix dvdm(3,3);
     DL_matrix ddpdm;
     dc->ddpdM(&p1,&ddpdm);
-    dvdm.assign(&ddpdm);
     if (dim==1)
-      dcdX.times(&dvdm,dcdm);
+      dcdX.times(&ddpdm,dcdm);
     else {
-      DL_largematrix dcdmsub(1,3);
-      dcdX.times(&dvdm,&dcdmsub);
+      DL_fixmat<1,3> dcdmsub;
+      dcdX.times(&ddpdm,&dcdmsub);
       dcdm->setsubmatrix(0,0,&dcdmsub);
       dc->dpdM(&p1,&ddpdm);
-      dvdm.assign(&ddpdm);
-      dcdX.times(&dvdm,&dcdmsub);
+      dcdX.times(&ddpdm,&dcdmsub);
       dcdm->setsubmatrix(1,0,&dcdmsub);
     }
     return TRUE;
@@ -327,46 +326,40 @@ boolean DL_collision::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
   return FALSE;
 }
 
-boolean DL_collision::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_collision::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
   if (dc==g0) {// which implies g0_is_dyna; there is an effect on C through g0
-    DL_largematrix dvdI(3,3);
     DL_matrix ddpdi;
     dc->ddpdi(&p0,pc,&ddpdi);
-    dvdI.assign(&ddpdi);
-    dvdI.neg();
+    ddpdi.timesis(-1.0);
     if (dim==1)
-      dcdX.times(&dvdI,dcdi);
+      dcdX.times(&ddpdi,dcdi);
     else {
-      DL_largematrix dcdisub(1,3);
-      dcdX.times(&dvdI,&dcdisub);
+      DL_fixmat<1,3> dcdisub;
+      dcdX.times(&ddpdi,&dcdisub);
       dcdi->setsubmatrix(0,0,&dcdisub);
       dc->dpdi(&p0,pc,&ddpdi);
-      dvdI.assign(&ddpdi);
-      dvdI.neg();
-      dcdX.times(&dvdI,&dcdisub);
+      ddpdi.timesis(-1.0);
+      dcdX.times(&ddpdi,&dcdisub);
       dcdi->setsubmatrix(1,0,&dcdisub);
     }
     return TRUE;
   }
   if (dc==g1) {// which implies g1_is_dyna; there is an effect on C through g1
-    DL_largematrix dvdI(3,3);
     DL_matrix ddpdi;
     dc->ddpdi(&p1,pc,&ddpdi);
-    dvdI.assign(&ddpdi);
     if (dim==1)
-      dcdX.times(&dvdI,dcdi);
+      dcdX.times(&ddpdi,dcdi);
     else {
-      DL_largematrix dcdisub(1,3);
-      dcdX.times(&dvdI,&dcdisub);
+      DL_fixmat<1,3> dcdisub;
+      dcdX.times(&ddpdi,&dcdisub);
       dcdi->setsubmatrix(0,0,&dcdisub);
       dc->dpdi(&p1,pc,&ddpdi);
-      dvdI.assign(&ddpdi);
-      dcdX.times(&dvdI,&dcdisub);
+      dcdX.times(&ddpdi,&dcdisub);
       dcdi->setsubmatrix(1,0,&dcdisub);
     }
     return TRUE;
@@ -438,3 +431,17 @@ void DL_collision::post_processing(void) {
   
   delete this;
 }
+
+void DL_collision::remap(DL_dyna *from, DL_dyna *to, DL_matrix *R, DL_vector *o) {
+  DL_point p;
+  if (g0==from) {
+    R->times(&p0,&p);
+    p.plus(o,&p0);
+    g0=to;
+  }
+  if (g1==from) {
+    R->times(&p1,&p);
+    p.plus(o,&p1);
+    g1=to;
+  }
+}
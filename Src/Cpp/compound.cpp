@@ -0,0 +1,367 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename     : compound.cpp
+// description	: non-inline methods of class DL_compound
+//
+
+#include "compound.h"
+#include "dyna_system.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+DL_compound::DL_compound(int n, DL_dyna **m, int *p, DL_connector **w):
+                   DL_dyna() {
+  int i;
+  DL_Scalar l;
+  nrmembers=n;
+  member=new DL_dyna*[n];
+  parent=new int[n];
+  weld=new DL_connector*[n];
+  for (i=0;i<n;i++) {
+    member[i]=m[i];
+    parent[i]=p[i];
+    weld[i]=w[i];
+  }
+  wP=new DL_vector[n];
+  wK=new DL_vector[n];
+  remapped=NULL;
+  remapdyna=NULL;
+  nrremapped=size_remapped=0;
+  splitpending=FALSE;
+  // the welds have just been checked by the constraint manager:
+  lastload=0;
+  for (i=1;i<n;i++) {
+    l=weld[i]->load_fraction();
+    if (l>lastload) lastload=l;
+  }
+  combine();
+}
+
+DL_compound::~DL_compound() {
+  delete[] member;
+  delete[] parent;
+  delete[] weld;
+  delete[] wP;
+  delete[] wK;
+  if (size_remapped>0) {
+    delete[] remapped;
+    delete[] remapdyna;
+  }
+}
+
+void DL_compound::combine(void) {
+  int i;
+  DL_dyna *d;
+  DL_Scalar m,s,totm=0,vd=0;
+  DL_vector r,t,v,L,Jc;
+  DL_point z;
+  DL_matrix I,Id,T,A,At;
+
+  // the centre of mass, the velocity and the velocity damping are
+  // the averages weighted by mass:
+  z.init(0,0,0);
+  v.init(0,0,0);
+  for (i=0;i<nrmembers;i++) {
+    d=member[i];
+    m=d->totalmass;
+    d->mstate.z.tovector(&r);
+    r.timesis(m);
+    z.plusis(&r);
+    d->mstate.v.times(m,&r);
+    v.plusis(&r);
+    totm+=m;
+    vd+=m*d->velodamping;
+  }
+  z.timesis(1.0/totm);
+  v.timesis(1.0/totm);
+  vd/=totm;
+
+  // the inertia tensor and the angular momentum about the centre of
+  // mass (the angular velocities have the sign used by the dynas, see
+  // DL_geo::get_velocity, so the momentum of mass m at r is m v x r):
+  I.makezero();
+  L.init(0,0,0);
+  for (i=0;i<nrmembers;i++) {
+    d=member[i];
+    m=d->totalmass;
+    T.assign(d->mstate.get_A());
+    T.c0.timesis(d->J.x);
+    T.c1.timesis(d->J.y);
+    T.c2.timesis(d->J.z);
+    T.timestranspose(d->mstate.get_A(),&Id); // A diag(J) A^T
+    I.plusis(&Id);
+    Id.times(&(d->mstate.w),&t);
+    L.plusis(&t);
+    d->mstate.z.minus(&z,&r);
+    T.tensor(&r,&r);
+    T.timesis(-m);
+    s=m*r.inprod(&r);
+    T.c0.x+=s; T.c1.y+=s; T.c2.z+=s;
+    I.plusis(&T);
+    d->mstate.v.crossprod(&r,&t);
+    t.timesis(m);
+    L.plusis(&t);
+  }
+
+  // the principal axes are the orientation of the compound (jacobi
+  // gives I=A diag(Jc) A^T, with A a product of rotations):
+  I.jacobi(&A,&Jc);
+  set_mass(totm);
+  set_inertiatensor(Jc.x,Jc.y,Jc.z);
+  set_velodamping(vd);
+  mstate.z.assign(&z);
+  mstate.v.assign(&v);
+  mstate.set_A(&A);
+  mstate.A2q();
+  A.diag_transpose_vec(&Jinv,&L,&t);
+  A.times(&t,&(mstate.w));
+  nextmstate.assign(&mstate);
+  mstateimp.assign(&mstate);
+  Fuptodate=Muptodate=FALSE;
+
+  // the places of the members in the compound, and their (now rigid)
+  // motion:
+  A.transpose(&At);
+  for (i=0;i<nrmembers;i++) {
+    d=member[i];
+    At.times(d->mstate.get_A(),&(d->cA));
+    d->mstate.z.minus(&z,&r);
+    At.times(&r,&(d->cpos));
+    d->compound=this;
+    d->follow(&mstate,&(d->mstate));
+    d->nextmstate.assign(&(d->mstate));
+    d->mstateimp.assign(&(d->mstate));
+    d->matrixcache1empty=d->matrixcache2empty=TRUE;
+  }
+}
+
+void DL_compound::remap(DL_constraint *constr, DL_dyna *d) {
+  if (nrremapped==size_remapped) {
+    // have to increase the size of the arrays:
+    DL_constraint* *newremapped=new DL_constraint*[2*size_remapped+10];
+    DL_dyna* *newremapdyna=new DL_dyna*[2*size_remapped+10];
+    for (int i=0;i<nrremapped;i++) {
+      newremapped[i]=remapped[i];
+      newremapdyna[i]=remapdyna[i];
+    }
+    if (size_remapped>0) {
+      delete[] remapped;
+      delete[] remapdyna;
+    }
+    size_remapped=2*size_remapped+10;
+    remapped=newremapped;
+    remapdyna=newremapdyna;
+  }
+  remapped[nrremapped]=constr;
+  remapdyna[nrremapped]=d;
+  nrremapped++;
+  constr->remap(d,this,&(d->cA),&(d->cpos));
+  constr->nrremaps++;
+}
+
+void DL_compound::unremap(DL_constraint *constr) {
+  DL_matrix R;
+  DL_vector o;
+  DL_dyna *d;
+  int i=0;
+  while (i<nrremapped) {
+    if (remapped[i]==constr) {
+      d=remapdyna[i];
+      d->cA.transpose(&R);
+      R.times(&(d->cpos),&o);
+      o.neg(&o);
+      constr->remap(this,d,&R,&o);
+      constr->nrremaps--;
+      nrremapped--;
+      remapped[i]=remapped[nrremapped];
+      remapdyna[i]=remapdyna[nrremapped];
+    }
+    else i++;
+  }
+}
+
+void DL_compound::probe_loads(DL_constraint *constr, DL_vector *p,
+			      DL_vector *k) {
+  DL_vector f,m,i,t;
+  DL_matrix iq;
+  DL_dyna *d,*next;
+  DL_matrix *A=mstate.get_A();
+  DL_Scalar h=DL_dsystem->get_integrator()->stepsize();
+  DL_dyna::probing=TRUE;
+  constr->apply_restrictions(constr->get_restriction());
+  DL_dyna::probing=FALSE;
+  boolean imp=get_probe(&f,&m,&i,&iq);
+  f.times(h,p);
+  m.times(h,k);
+  if (imp) {
+    // the moments of the impulses are linear in their (local) points:
+    p->plusis(&i);
+    iq.c0.crossprod(&(A->c0),&t); k->plusis(&t);
+    iq.c1.crossprod(&(A->c1),&t); k->plusis(&t);
+    iq.c2.crossprod(&(A->c2),&t); k->plusis(&t);
+  }
+  // clear the probe loads of this and the other dynas of the constraint:
+  d=firstprobed;
+  while (d) {
+    next=d->get_nextprobed();
+    d->clear_probe();
+    d=next;
+  }
+  firstprobed=NULL;
+}
+
+void DL_compound::book_loads(DL_constraint *constr) {
+  DL_vector p,k,r,t;
+  DL_dyna *d;
+  DL_Scalar hinv=1.0/DL_dsystem->get_integrator()->stepsize();
+  for (int i=0;i<nrremapped;i++) {
+    if (remapped[i]!=constr) continue;
+    d=remapdyna[i];
+    probe_loads(constr,&p,&k);
+    // as if applied to the member (see DL_dyna::compound_impulse), with
+    // the angular impulse about its centre of mass:
+    mstate.get_A()->times(&(d->cpos),&r);
+    p.crossprod(&r,&t);
+    k.minusis(&t);
+    p.timesis(hinv);
+    k.timesis(hinv);
+    d->F.plusis(&p);
+    d->M.plusis(&k);
+  }
+}
+
+DL_Scalar DL_compound::weld_load(void) {
+  // The welds give each member the impulse and angular impulse it
+  // needs to follow the compound over this frame, on top of the loads
+  // on the member (kept in its F and M, see DL_dyna::compound_force)
+  // and on the compound through the constraints remapped from it. The
+  // members form a tree, so what weld i gives is the total need of the
+  // members on its side. The angular impulses are about the centre of
+  // mass at the start of the frame.
+  int i;
+  DL_dyna *d;
+  DL_Scalar m,l,lf=0;
+  DL_Scalar h=DL_dsystem->get_integrator()->stepsize();
+  DL_vector r0,r1,a1,v0,v1,t,u,p,k;
+  DL_matrix B;
+  DL_point pw,wp;
+  DL_matrix *A0=mstate.get_A();
+  DL_matrix *A1;
+
+  integrate();
+  A1=nextmstate.get_A();
+  for (i=0;i<nrmembers;i++) {
+    d=member[i];
+    d->probenr=i;
+    m=d->totalmass;
+    // the member's centre of mass and its velocity at the start and
+    // at the end of the frame:
+    A0->times(&(d->cpos),&r0);
+    r0.crossprod(&(mstate.w),&v0);
+    v0.plusis(&(mstate.v));
+    A1->times(&(d->cpos),&a1);
+    a1.crossprod(&(nextmstate.w),&v1);
+    v1.plusis(&(nextmstate.v));
+    nextmstate.z.minus(&(mstate.z),&r1);
+    r1.plusis(&a1);
+    // the change in momentum, minus the impulse of the loads:
+    v1.minus(&v0,&(wP[i]));
+    wP[i].timesis(m);
+    d->F.times(h,&t);
+    wP[i].minusis(&t);
+    // the same for the angular momentum:
+    A1->times(&(d->cA),&B);
+    B.diag_transpose_vec(&(d->J),&(nextmstate.w),&t);
+    B.times(&t,&(wK[i]));
+    v1.crossprod(&r1,&t);
+    t.timesis(m);
+    wK[i].plusis(&t);
+    A0->times(&(d->cA),&B);
+    B.diag_transpose_vec(&(d->J),&(mstate.w),&t);
+    B.times(&t,&u);
+    wK[i].minusis(&u);
+    v0.crossprod(&r0,&t);
+    t.timesis(m);
+    wK[i].minusis(&t);
+    d->F.crossprod(&r0,&t);
+    t.plusis(&(d->M));
+    t.timesis(h);
+    wK[i].minusis(&t);
+  }
+  for (i=0;i<nrremapped;i++) {
+    probe_loads(remapped[i],&p,&k);
+    wP[remapdyna[i]->probenr].minusis(&p);
+    wK[remapdyna[i]->probenr].minusis(&k);
+  }
+  // from the leaves inward:
+  for (i=nrmembers-1;i>0;i--) {
+    // the angular impulse about the point of the weld:
+    weld[i]->myptp->get_dyna_point(&pw);
+    weld[i]->myptp->get_dyna()->to_world(&pw,&wp);
+    wp.minus(&(mstate.z),&r0);
+    wP[i].crossprod(&r0,&t);
+    wK[i].minus(&t,&k);
+    wP[i].times(1.0/h,&p);
+    k.timesis(1.0/h);
+    l=weld[i]->load_fraction(&p,&k);
+    if (l>lf) lf=l;
+    wP[parent[i]].plusis(&(wP[i]));
+    wK[parent[i]].plusis(&(wK[i]));
+  }
+  l=0.5*(lf+lastload);
+  lastload=lf;
+  return l;
+}
+
+void DL_compound::split(boolean prepared) {
+  DL_dyna *d;
+  int i;
+  if (!prepared) integrate();
+  for (i=0;i<nrmembers;i++) {
+    d=member[i];
+    d->compound=NULL;
+    d->follow(&mstate,&(d->mstate));
+    if (prepared) {
+      // the loads applied since are in F and M (see
+      // DL_dyna::compound_force):
+      d->mstateimp.assign(&(d->mstate));
+      d->Fuptodate=d->Muptodate=FALSE;
+    }
+    else {
+      // the member continues with the motion of the compound over
+      // this frame, which includes the loads of the welds:
+      d->follow(&mstateimp,&(d->mstateimp));
+      d->follow(&nextmstate,&(d->nextmstate));
+      d->Fuptodate=d->Muptodate=TRUE;
+    }
+    d->matrixcache1empty=d->matrixcache2empty=TRUE;
+  }
+  while (nrremapped>0) unremap(remapped[nrremapped-1]);
+}
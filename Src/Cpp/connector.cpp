@@ -108,3 +108,20 @@ boolean DL_connector::check_restrictions() {
   }
   return TRUE;
 }
+
+DL_Scalar DL_connector::load_fraction(DL_vector *f, DL_vector *t) {
+  DL_Scalar l, lf=0;
+  if (myptp->maxforce>0) lf=f->norm()/myptp->maxforce;
+  if (myorient->maxtorque>0) {
+    l=t->norm()/myorient->maxtorque;
+    if (l>lf) lf=l;
+  }
+  return lf;
+}
+
+DL_Scalar DL_connector::load_fraction() {
+  DL_vector f,t;
+  myptp->reactionforce(&f);
+  myorient->reactiontorque(&t);
+  return load_fraction(&f,&t);
+}
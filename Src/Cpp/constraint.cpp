@@ -34,30 +34,36 @@
 
 #include "constraint.h"
 #include "constraint_manager.h"
+#include "snapshot.h"
+
+// the number of constraints created so far:
+static long DL_nrconstraints_created=0;
 
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
 DL_constraint::DL_constraint():DL_ListElem(),DL_force_drawable() {
-  index=0;
+  index=colour=0;
+  serial=DL_nrconstraints_created++;
   stiffness=1.0;
+  extrapolation=linear_estimate;
+  nrhistory=0;
   dim=0;
-  F=new DL_largevector(dim);
-  oldF=new DL_largevector(dim);
-  Fsave=new DL_largevector(dim);
+  F=&Fstore;
+  oldF=&oldFstore;
+  Fsave=&Fsavestore;
   active=initialised=testing=FALSE;
   veloterms=FALSE;
   veloterms_free=TRUE;
   nr_osc=4;
   max_osc=8;
+  setaside=NULL;
+  nrremaps=0;
 }
 
 DL_constraint::~DL_constraint(void) {
   deactivate();
-  delete Fsave;
-  delete oldF;
-  delete F;
 }
 
 void DL_constraint::init(void) {
@@ -142,9 +148,10 @@ void DL_constraint::activate(void) {
     return;
   }
   if (DL_constraints) {
-     DL_constraints->add(this);
-     reset();
-     active=TRUE;
+     if (DL_constraints->add(this)) {
+       reset();
+       active=TRUE;
+     }
   }
   else
      DL_dsystem->get_companion()->Msg("Can't activate constraint because there is no constraint manager!\n");
@@ -170,7 +177,7 @@ void DL_constraint::end_test(void) {
   testing=FALSE;
 }
 
-boolean DL_constraint::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_constraint::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
@@ -181,7 +188,7 @@ boolean DL_constraint::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
   return FALSE;
 }
 
-boolean DL_constraint::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_constraint::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
@@ -193,7 +200,7 @@ boolean DL_constraint::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
   return FALSE;
 }
 
-boolean DL_constraint::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_constraint::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
@@ -204,7 +211,7 @@ boolean DL_constraint::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
   return FALSE;
 }
 
-boolean DL_constraint::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_constraint::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
@@ -216,7 +223,7 @@ boolean DL_constraint::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
   return FALSE;
 }
 
-boolean DL_constraint::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_constraint::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
@@ -228,23 +235,81 @@ boolean DL_constraint::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
   return FALSE;
 }
 
+static void DL_plusistimes(DL_largevector *lv, DL_jacblock *m,
+			   DL_vector *v, int n) {
+  // lv+=m*v, for the first n rows of m
+  for (int r=0;r<n;r++)
+    lv->set(r,lv->get(r)+m->get(r,0)*v->x+m->get(r,1)*v->y+m->get(r,2)*v->z);
+}
+
+void DL_constraint::probe_error(DL_dyna *dc, DL_largevector *lv) {
+// add the change in constraint error caused by the probe loads of the
+// dyna to lv
+  DL_vector f,m,i;
+  DL_matrix iq;
+  DL_jacblock dcdx,dcdx0;
+  DL_point q;
+  if (!dc->is_probed()) return;
+  boolean imp=dc->get_probe(&f,&m,&i,&iq);
+  if (dCdF(dc,&dcdx)) DL_plusistimes(lv,&dcdx,&f,dim);
+  if (dCdM(dc,&dcdx)) DL_plusistimes(lv,&dcdx,&m,dim);
+  if (!imp) return;
+  // dCdI is linear in the point of application: its part for the
+  // origin applies to the total impulse, and its parts per coordinate
+  // to the moments:
+  q.init(0,0,0);
+  if (!dCdI(dc,&q,&dcdx0)) return;
+  DL_plusistimes(lv,&dcdx0,&i,dim);
+  q.init(1,0,0); dCdI(dc,&q,&dcdx);
+  dcdx.minusis(&dcdx0,dim); DL_plusistimes(lv,&dcdx,&(iq.c0),dim);
+  q.init(0,1,0); dCdI(dc,&q,&dcdx);
+  dcdx.minusis(&dcdx0,dim); DL_plusistimes(lv,&dcdx,&(iq.c1),dim);
+  q.init(0,0,1); dCdI(dc,&q,&dcdx);
+  dcdx.minusis(&dcdx0,dim); DL_plusistimes(lv,&dcdx,&(iq.c2),dim);
+}
+
 void DL_constraint::new_frame(void) {
   detect_osc();
 }
 
-void DL_constraint::first_estimate(void) {
-  static DL_largevector dF(dim);
-  if (oldF->norm()==0.0) {
-    // constant extrapolation:
-    oldF->assign(F);
-  }
-  else {
-    // linear extrapolation:
-    F->minus(oldF,&dF);
-    oldF->assign(F);
-    dF.timesis(stiffness);
-    F->plusis(&dF);
+void DL_constraint::extrapolate(void) {
+  // the restriction values of the last three frames are f, f1 and f2;
+  // the increment is scaled by the stiffness, and by the ratio r of the
+  // new and the old stepsize:
+  DL_m_integrator *integrator=DL_dsystem->get_integrator();
+  DL_Scalar r=integrator->stepsize()/integrator->old_stepsize();
+  DL_Scalar sr=stiffness*r;
+  DL_Scalar sq=0.5*stiffness*r*(r+1);
+  DL_Scalar f,f1,f2;
+  int i;
+  DL_extrapolation e=extrapolation;
+  if ((e==quadratic_estimate) && (nrhistory<2)) e=linear_estimate;
+  if ((e==linear_estimate) && (oldF->norm()==0.0)) e=constant_estimate;
+  // (f2 is kept in every mode, so extrapolation can be switched to
+  // quadratic_estimate at any time):
+  old2F.resize(dim);
+  for (i=0;i<dim;i++) {
+    f=F->get(i); f1=oldF->get(i);
+    switch (e) {
+    case constant_estimate:
+      break;
+    case linear_estimate:
+      F->set(i,f+(f-f1)*sr);
+      break;
+    case quadratic_estimate:
+      f2=old2F.get(i);
+      F->set(i,f+(f-f1)*sr+(f-2*f1+f2)*sq);
+      break;
+    }
+    // shift the history:
+    oldF->set(i,f);
+    old2F.set(i,f1);
   }
+  if (nrhistory<2) nrhistory++;
+}
+
+void DL_constraint::first_estimate(void) {
+  extrapolate();
 //   if (check_restrictions()) // removed since first estimate is too much of a
                                // guess and can be way too high (esp. after
 			       // initialization)
@@ -294,6 +359,36 @@ void DL_constraint::post_processing(void) {
   // nothing to do for empty constraint
 }
 
+void DL_constraint::save_state(DL_snapshot *snap) {
+  // the dimension is stored to detect restoring into a different
+  // kind of constraint
+  snap->put((DL_Scalar)dim);
+  snap->put(F);
+  snap->put(oldF);
+  // old2F is only used (by quadratic_estimate) with two frames of history:
+  snap->put((DL_Scalar)nrhistory);
+  if (nrhistory==2) snap->put(&old2F);
+  snap->put((DL_Scalar)veloterms);
+  snap->put((DL_Scalar)nr_osc);
+}
+
+void DL_constraint::restore_state(DL_snapshot *snap) {
+  if ((int)DL_value(snap->get())!=dim) {
+    snap->fail();
+    return;
+  }
+  snap->get(F);
+  snap->get(oldF);
+  nrhistory=(int)DL_value(snap->get());
+  if (nrhistory==2) {
+    old2F.resize(dim);
+    snap->get(&old2F);
+  }
+  veloterms=(boolean)DL_value(snap->get());
+  nr_osc=(int)DL_value(snap->get());
+  testing=FALSE;
+}
+
 void DL_constraint::reset_undo(void){
   F->neg(F);
   apply_restrictions(F);
@@ -33,8 +33,10 @@
 
 #include "constraint_manager.h"
 #include "dyna_system.h"
+#include "compound.h"
 #include "euler.h"
 #include "NaN.h"
+#include "snapshot.h"
 
 //#define DCDR
 //#define DEBUG
@@ -42,29 +44,48 @@
 // pointer to the one and only constraint manager:
 DL_constraint_manager* DL_constraints=NULL;
 
+// ************************** //
+// class DL_constraint_pair   //
+// ************************** //
+
+static DL_pool* DL_constraint_pair_pool() {
+  static DL_pool pool(sizeof(DL_constraint_pair),256);
+  return &pool;
+}
+
+void* DL_constraint_pair::operator new(size_t s) {
+  if (s==sizeof(DL_constraint_pair)) return DL_constraint_pair_pool()->alloc();
+  return ::operator new(s);
+}
+
+void DL_constraint_pair::operator delete(void *p, size_t s) {
+  if (s==sizeof(DL_constraint_pair)) DL_constraint_pair_pool()->free(p);
+  else ::operator delete(p);
+}
+
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
 void DL_constraint_manager::calc_all_errors(DL_largevector *lv) {
-  static DL_largevector err;
+  // the constraints write their errors straight into their part of lv:
+  DL_largevector err;
   DL_constraint *constr=(DL_constraint *)c->getfirst();
   while (constr) {
-    err.resize(constr->dim);
+    err.view(lv,constr->index,constr->dim);
     constr->get_error(&err);
-    lv->setsubvector(constr->index,&err);
     constr=(DL_constraint*)c->getnext(constr);
   }
 }
 
 boolean DL_constraint_manager::apply_all_restriction_changes(DL_largevector *lv) {
-  static DL_largevector restr;
+  // the constraints read their restriction changes straight from lv:
+  DL_largevector restr;
   DL_constraint *next_c,*constr=(DL_constraint *)c->getfirst();
   // first see if no reactionforces become too large:
   while (constr) {
     next_c=(DL_constraint*)c->getnext(constr);
-    restr.resize(constr->dim);
-    lv->getsubvector(constr->index,&restr);
+    restr.view(lv,constr->index,constr->dim);
     constr->test_restriction_changes(&restr);
     constr=next_c;
   }
@@ -74,14 +95,18 @@ boolean DL_constraint_manager::apply_all_restriction_changes(DL_largevector *lv)
     redo_index_administration();
     
     // then recalculate dCdR:
-    calc_dCdR_full();
+    if (mfbuilt) {
+      find_dynas();
+      c_changed=FALSE;
+    }
+    else calc_dCdR_full();
+    relaxvalid=FALSE;
     return TRUE;
   }
   else { // everything ok: really apply the changes:
     constr=(DL_constraint *)c->getfirst();
     while (constr) {
-      restr.resize(constr->dim);
-      lv->getsubvector(constr->index,&restr);
+      restr.view(lv,constr->index,constr->dim);
       constr->apply_restriction_changes(&restr);
       constr=(DL_constraint*)c->getnext(constr);
     }
@@ -89,23 +114,66 @@ boolean DL_constraint_manager::apply_all_restriction_changes(DL_largevector *lv)
   }
 }
 
-void DL_constraint_manager::add(DL_constraint *constr) {
+boolean DL_constraint_manager::add(DL_constraint *constr) {
+  if (constr->dim>DL_MAXCDIM) {
+    // the Jacobian blocks (DL_jacblock, DL_subblock) are fixed in size:
+    DL_dsystem->get_companion()->Msg("Error: constraint_manager::add: constraint dimension %d exceeds DL_MAXCDIM (%d), constraint refused\n",
+				     constr->dim, DL_MAXCDIM);
+    return FALSE;
+  }
   c->addelem(constr);
   if (show_con_forces) constr->show_forces();
   else constr->hide_forces();
   c_changed=TRUE;
+  // while there are compounds, the new constraint may have to be set
+  // aside or remapped (see settle_new_constraints):
+  if (DL_dsystem->get_compounds()->length()>0) {
+    if (nrnewcons==size_newcons) {
+      // have to increase the size of newcons:
+      DL_constraint* *nc=new DL_constraint*[2*size_newcons+10];
+      for (int i=0;i<nrnewcons;i++) nc[i]=newcons[i];
+      if (size_newcons>0) delete[] newcons;
+      size_newcons=2*size_newcons+10;
+      newcons=nc;
+    }
+    newcons[nrnewcons++]=constr;
+  }
+  return TRUE;
 }
 
 void DL_constraint_manager::del(DL_constraint *constr) {
+  int i;
   constr->hide_forces();
+  if (constr->setaside) {
+    // it is not in the list, but in that of its compound:
+    constr->setaside->aside.remelem(constr);
+    constr->setaside=NULL;
+    return;
+  }
   c->remelem(constr);
   c_changed=TRUE;
+  for (i=0;i<nrnewcons;i++) {
+    if (newcons[i]==constr) newcons[i--]=newcons[--nrnewcons];
+  }
+  if (constr->nrremaps>0) {
+    // move it back to the members of the compounds it was remapped to
+    // (keeping the loads of collisions for the estimates of the loads
+    // on the welds, see DL_compound::weld_load):
+    DL_compound *cc=(DL_compound*)DL_dsystem->get_compounds()->getfirst();
+    while (cc && constr->nrremaps>0) {
+      if (constr->is_collision()) cc->book_loads(constr);
+      cc->unremap(constr);
+      cc=(DL_compound*)DL_dsystem->get_compounds()->getnext(cc);
+    }
+  }
 }
 
 void DL_constraint_manager::satisfy() {
   static DL_largevector dC;
   int i, nr_collisionloops=0;
+  boolean nodCdR;
 
+  if (nrnewcons>0) settle_new_constraints();
   if (c_changed) redo_index_administration();
   dC.resize(totdim);
 
@@ -144,8 +212,13 @@ void DL_constraint_manager::satisfy() {
 //      DL_dsystem->update_dyna_companions();
       DL_dsystem->get_companion()->do_collision_detection();
     }
+    if (nrnewcons>0) settle_new_constraints();
     
-    if (c->length()==0) return;  // no constraints to satisfy
+    if (c->length()==0) {  // no constraints to satisfy
+      // (but there may be collisions set aside in compounds):
+      for (i=0;i<nrcollisions;i++) collisions[i]->post_processing();
+      return;
+    }
 
     if (c_changed) {  // redo index administration:
       redo_index_administration();
@@ -161,7 +234,18 @@ void DL_constraint_manager::satisfy() {
       }
     }
     if (error>max_error) {  // recalculate dCdR
-      if (c_changed) { // have to rebuild dCdR from scratch
+      // (matrix_free needs the analytical derivatives to derive the
+      // errors from the probe loads; without them dCdR is built):
+      nodCdR=(matrix_free && analytical) || relaxing;
+      if (nodCdR!=mfbuilt) c_changed=TRUE;
+      if (nodCdR) {
+        if (c_changed) {
+	  find_dynas();
+	  c_changed=FALSE;
+	  mfbuilt=TRUE;
+	}
+      }
+      else if (c_changed) { // have to rebuild dCdR from scratch
         calc_dCdR_full();
         dCdRToGo=NrSkip;
 	// calc_dCdR_full might have permutated constraints:
@@ -177,7 +261,9 @@ void DL_constraint_manager::satisfy() {
 	}
         else dCdRToGo--;
       }
-      iterate(&dC);
+      if (relaxing) iterate_relaxation(&dC);
+      else if (nodCdR) iterate_matrix_free(&dC);
+      else iterate(&dC);
     }
     // delete collision constraints here
     for (i=0;i<nrcollisions;i++) collisions[i]->post_processing();
@@ -198,20 +284,129 @@ if ((nrcollisions>0) || (nr_collisionloops>0)) {
 }
 */
   
+  nrframes++;
+  if ((nriter<=1) && (error<=max_error)) nrquick++;
+
   do_post_processing();
 }
 
+void DL_constraint_manager::analyse_tree() {
+  // number the constraints (those with a zero dimension have no blocks
+  // in dCdR) and give their blocks and the pairs in cp to the solver:
+  int nrblocks=0;
+  DL_constraint *cc=(DL_constraint *)c->getfirst();
+  while (cc) {
+    if (cc->dim>0) nrblocks++;
+    cc=(DL_constraint*)c->getnext(cc);
+  }
+  tree.init(nrblocks,totdim);
+  nrblocks=0;
+  cc=(DL_constraint *)c->getfirst();
+  while (cc) {
+    if (cc->dim>0) tree.setblock(nrblocks++,cc->index,cc->dim);
+    cc=(DL_constraint*)c->getnext(cc);
+  }
+  DL_constraint_pair *cpe=(DL_constraint_pair*)cp.getfirst();
+  while (cpe) {
+    if ((cpe->cc->dim>0) && (cpe->cf->dim>0))
+      tree.connect(cpe->cc->index,cpe->cf->index);
+    cpe=(DL_constraint_pair*)cp.getnext(cpe);
+  }
+  // a block banded dCdR (a chain) is eliminated in its sorted order:
+  banded=(tree.get_blockband()<=DL_MAXBLOCKBAND);
+  if (banded || tree_elimination) tree.analyse(!banded);
+  tree_valid=TRUE;
+}
+
+void DL_constraint_manager::broyden_solve(DL_largevector *x, DL_largevector *b,
+					  boolean usetree) {
+// x:=H b, with H the inverse of dCdR (as given by the decomposition)
+// followed by the Broyden updates
+  int i;
+  if (usetree) tree.solve(x,b);
+  else dCdR->solve(x,b);
+  for (i=0;i<nrbroyden;i++)
+    x->plusistimes(broyden_s[i].inprod(x),&broyden_u[i]);
+}
+
 void DL_constraint_manager::iterate(DL_largevector *dC) {
   static DL_largevector dR;
+  static DL_largevector z;
+  boolean singular=FALSE;
+  boolean secant;       // do Broyden updates
+  boolean stepknown=FALSE; // does dR already hold the next step
+  boolean rebuilt;
+  DL_Scalar sz,ss,sHy;
+  int s;
   first_error=error;
-  boolean singular=dCdR->prep_for_solve();
+  relaxvalid=FALSE;
+  // the tree elimination is used as long as it works; after a singular
+  // diagonal block or a divergence the solve methods of dCdR take over
+  // for the rest of the frame:
+  boolean usetree=FALSE;
+  if (broyden && factored) usetree=treefactored;
+  else {
+    if (tree_elimination ||
+	((dCdR->get_solve_method()==lud_bcksub) && !mixed_precision)) {
+      if (!tree_valid) analyse_tree();
+      if (tree_elimination || banded) usetree=tree.factor(dCdR);
+    }
+    if (!usetree) {
+      dCdR->set_mixed_precision(mixed_precision);
+      singular=dCdR->prep_for_solve();
+    }
+    factored=TRUE; treefactored=usetree;
+    nrbroyden=0;
+  }
   dR.resize(dC->get_dim());
+  z.resize(dC->get_dim());
   while ((error>max_error) && (nriter<MaxIter)) {
     nriter++;
-    dC->neg(dC);
-    dCdR->solve(&dR,dC);
+    secant=broyden && (usetree || (dCdR->get_solve_method()==lud_bcksub));
+    if (!stepknown && !usetree && (NrSmooth>0) &&
+	(dCdR->get_solve_method()==conjug_grad)) {
+      // smooth the error by relaxation first: the sweeps quickly remove
+      // the local part of the error, leaving the conjugate gradient
+      // method the global part
+      rebuilt=FALSE;
+      for (s=0;s<NrSmooth;s++) {
+	if (!relaxvalid) prepare_relaxation();
+	if (relax(NULL)) rebuilt=TRUE;
+      }
+      if (rebuilt) {
+	// dCdR has been rebuilt:
+	singular=dCdR->prep_for_solve();
+	factored=TRUE; treefactored=FALSE;
+	nrbroyden=0;
+	dR.resize(totdim);
+	z.resize(totdim);
+	dC->resize(totdim);
+      }
+      calc_all_errors(dC);
+      error=dC->norm();
+      if (error<=max_error) break;
+    }
+    if (!stepknown) {
+      dC->neg(dC);
+      if (secant) broyden_solve(&dR,dC,usetree);
+      else if (usetree) tree.solve(&dR,dC);
+      else dCdR->solve(&dR,dC);
+    }
+    stepknown=FALSE;
     if (apply_all_restriction_changes(&dR)) {
+      // dCdR has been rebuilt:
+      if (usetree) {
+        analyse_tree();
+	if (!(usetree=(tree_elimination || banded) && tree.factor(dCdR))) {
+	  dCdR->set_mixed_precision(mixed_precision);
+	  singular=dCdR->prep_for_solve();
+	}
+      }
+      else if (broyden) singular=dCdR->prep_for_solve();
+      factored=TRUE; treefactored=usetree;
+      nrbroyden=0;
       dR.resize(totdim);
+      z.resize(totdim);
       dC->resize(totdim);
       calc_all_errors(dC);
       error=dC->norm();
@@ -219,7 +414,48 @@ void DL_constraint_manager::iterate(DL_largevector *dC) {
     else {
       calc_all_errors(dC);
       error=dC->norm();
-      if ((error>4*first_error) || NaN(error)) {
+      if ((nrbroyden>0) && ((error>4*first_error) || NaN(error))) {
+	// the updates made things worse: undo the step and go back to
+	// the decomposition itself
+	nrbroyden=0;
+	dR.neg(&dR);
+	apply_all_restriction_changes(&dR);
+	calc_all_errors(dC);
+	error=dC->norm();
+      }
+      else if (usetree && ((error>4*first_error) || NaN(error))) {
+	usetree=treefactored=FALSE;
+	dCdR->set_mixed_precision(mixed_precision);
+	singular=dCdR->prep_for_solve();
+	dR.neg(&dR);
+	apply_all_restriction_changes(&dR);
+	calc_all_errors(dC);
+	error=dC->norm();
+      }
+      else if (secant && (error>max_error) && (nriter<MaxIter) &&
+	       !((error>4*first_error) || NaN(error))) {
+	// Broyden update with the secant (dR, dC-dCold): as dR was
+	// -H dCold, H(dC-dCold)=z+dR with z=H dC. The next step
+	// -H'dC then follows from z as well, so the update costs no
+	// extra solve:
+	broyden_solve(&z,dC,usetree);
+	sz=dR.inprod(&z);
+	ss=dR.inprod(&dR);
+	sHy=sz+ss;
+	if ((nrbroyden<DL_MAXBROYDEN) && (fabs(sHy)>DL_TINY*ss)) {
+	  broyden_s[nrbroyden].resize(totdim);
+	  broyden_u[nrbroyden].resize(totdim);
+	  broyden_s[nrbroyden].assign(&dR);
+	  z.times(-1/sHy,&broyden_u[nrbroyden]);
+	  nrbroyden++;
+	  z.times(sz/sHy-1,&dR);
+	}
+	else z.neg(&dR);
+	stepknown=TRUE;
+	// out of updates: recalculate dCdR next frame
+	if (nrbroyden==DL_MAXBROYDEN) dCdRToGo=0;
+      }
+      else if ((error>4*first_error) || NaN(error)) {
 	// clear divergence: try a more stable solve method
 	switch (dCdR->get_solve_method()) {
 	case lud_bcksub:
@@ -269,16 +505,621 @@ void DL_constraint_manager::iterate(DL_largevector *dC) {
   }
 }
 
+void DL_constraint_manager::clear_probes() {
+  DL_dyna *next,*d=DL_dyna::firstprobed;
+  while (d) {
+    next=d->get_nextprobed();
+    d->clear_probe();
+    d=next;
+  }
+  DL_dyna::firstprobed=NULL;
+}
+
+void DL_constraint_manager::find_dynas() {
+  // apply a restriction vector of all ones to each constraint in turn
+  // while probing, and list the dynas that get probed:
+  static DL_largevector ones;
+  DL_dyna *d;
+  int i,k,n=0,N=c->length();
+  if (size_mfstart<N+1) {
+    if (size_mfstart>0) delete[] mfstart;
+    size_mfstart=N+1;
+    mfstart=new int[size_mfstart];
+  }
+  clear_probes();
+  DL_dyna::probing=TRUE;
+  DL_constraint *constr=(DL_constraint *)c->getfirst();
+  i=0;
+  while (constr) {
+    mfstart[i]=n;
+    if (constr->dim>0) {
+      ones.resize(constr->dim);
+      for (k=0;k<constr->dim;k++) ones.set(k,1.0);
+      constr->apply_restrictions(&ones);
+      for (d=DL_dyna::firstprobed;d;d=d->get_nextprobed()) {
+	if (n==size_mfdyna) { // have to increase the size of mfdyna
+	  DL_dyna* *newmfdyna=new DL_dyna*[2*size_mfdyna+10];
+	  for (k=0;k<n;k++) newmfdyna[k]=mfdyna[k];
+	  if (size_mfdyna>0) delete[] mfdyna;
+	  size_mfdyna=2*size_mfdyna+10;
+	  mfdyna=newmfdyna;
+	}
+	mfdyna[n++]=d;
+      }
+      clear_probes();
+    }
+    constr=(DL_constraint*)c->getnext(constr); i++;
+  }
+  mfstart[N]=n;
+  DL_dyna::probing=FALSE;
+}
+
+void DL_constraint_manager::jacobian_times(DL_largevector *v,
+					   DL_largevector *jv) {
+// jv:=dCdR v, by applying v to the dynas while probing, and letting
+// every constraint work out the change in its error from the probe
+// loads of its dynas
+  DL_largevector sub;
+  DL_constraint *constr;
+  int i,j;
+  DL_dyna::probing=TRUE;
+  constr=(DL_constraint *)c->getfirst();
+  while (constr) {
+    if (constr->dim>0) {
+      sub.view(v,constr->index,constr->dim);
+      constr->apply_restrictions(&sub);
+    }
+    constr=(DL_constraint*)c->getnext(constr);
+  }
+  DL_dyna::probing=FALSE;
+  jv->makezero();
+  constr=(DL_constraint *)c->getfirst();
+  i=0;
+  while (constr) {
+    if (constr->dim>0) {
+      sub.view(jv,constr->index,constr->dim);
+      for (j=mfstart[i];j<mfstart[i+1];j++)
+	constr->probe_error(mfdyna[j],&sub);
+    }
+    constr=(DL_constraint*)c->getnext(constr); i++;
+  }
+  clear_probes();
+}
+
+boolean DL_constraint_manager::bicgstab(DL_largevector *x, DL_largevector *b) {
+// Solves dCdR x=b using BiCGSTAB (the matrix is only used through
+// jacobian_times, two products per iteration)
+// returns if the solution was diverging |dCdR x-b|>|b|
+  static DL_largevector r,rr,p,v,t;
+  int iter=0, itmax=totdim;
+  DL_Scalar rho=1.0, rhoold, alpha=1.0, omega=1.0, den, bnrm;
+
+  x->resize(totdim);
+  x->makezero();
+  r.assign(b);
+  rr.assign(b);
+  p.resize(totdim);
+  v.resize(totdim);
+  t.resize(totdim);
+
+  bnrm=b->norm();
+  if (bnrm==0.0) return FALSE;
+  while (iter<itmax) {
+    ++iter;
+    rhoold=rho;
+    rho=rr.inprod(&r);
+    if (rho==0.0) break; // breakdown: keep what we have
+    if (iter==1) p.assign(&r);
+    else { // p:=r+beta*(p-omega*v)
+      p.plusistimes(-omega,&v);
+      p.timesis((rho/rhoold)*(alpha/omega));
+      p.plusis(&r);
+    }
+    jacobian_times(&p,&v);
+    den=rr.inprod(&v);
+    if (den==0.0) break;
+    alpha=rho/den;
+    x->plusistimes(alpha,&p);
+    r.plusistimes(-alpha,&v);
+    if (r.norm()<=(DL_MFTOL*bnrm)) break;
+    jacobian_times(&r,&t);
+    den=t.inprod(&t);
+    if (den==0.0) break;
+    omega=t.inprod(&r)/den;
+    x->plusistimes(omega,&r);
+    r.plusistimes(-omega,&t);
+    if ((r.norm()<=(DL_MFTOL*bnrm)) || (omega==0.0)) break;
+  }
+  return (r.norm()>bnrm);
+}
+
+void DL_constraint_manager::iterate_matrix_free(DL_largevector *dC) {
+  static DL_largevector dR;
+  boolean diverging;
+  first_error=error;
+  while ((error>max_error) && (nriter<MaxIter)) {
+    nriter++;
+    dC->neg(dC);
+    if (!(diverging=bicgstab(&dR,dC))) {
+      if (apply_all_restriction_changes(&dR)) {
+	// constraints have deleted themselves (and find_dynas has been
+	// redone), so the step was not applied:
+	dC->resize(totdim);
+	calc_all_errors(dC);
+	error=dC->norm();
+	continue;
+      }
+      calc_all_errors(dC);
+      error=dC->norm();
+      if ((error>4*first_error) || NaN(error)) {
+	// clear divergence: undo the step
+	diverging=TRUE;
+	dR.neg(&dR);
+	apply_all_restriction_changes(&dR);
+      }
+    }
+    if (diverging) {
+      // there are no more stable solve methods without dCdR, so build
+      // it for the rest of this frame (the next frame is matrix-free
+      // again, see satisfy):
+      calc_dCdR_full();
+      dC->resize(totdim);
+      calc_all_errors(dC);
+      error=dC->norm();
+      iterate(dC);
+      return;
+    }
+  }
+}
+
+void DL_constraint_manager::colour_by_dynas() {
+  // based on the dynas found by find_dynas, colour the constraints so
+  // that no two constraints of the same colour act on the same dyna
+  // (greedily, in the order of the constraints), and sort them by colour
+  // into relaxorder. As a constraint error only depends on the dynas
+  // the constraint acts on, the constraints of one colour can then be
+  // relaxed independently of each other.
+  int N=c->length();
+  int n=mfstart[N];
+  int i,j,k,d,col,nd=0;
+  DL_constraint *cc;
+
+  // number the dynas:
+  for (j=0;j<n;j++) mfdyna[j]->probenr=-1;
+  for (j=0;j<n;j++)
+    if (mfdyna[j]->probenr<0) mfdyna[j]->probenr=nd++;
+
+  // the constraints by dyna:
+  int *dynastart=new int[nd+1];
+  int *dynacon=new int[n];
+  for (k=0;k<=nd;k++) dynastart[k]=0;
+  for (j=0;j<n;j++) dynastart[mfdyna[j]->probenr+1]++;
+  for (k=0;k<nd;k++) dynastart[k+1]+=dynastart[k];
+  for (i=0;i<N;i++)
+    for (j=mfstart[i];j<mfstart[i+1];j++)
+      dynacon[dynastart[mfdyna[j]->probenr]++]=i;
+  // (the starts have moved to the ends: shift them back)
+  for (k=nd;k>0;k--) dynastart[k]=dynastart[k-1];
+  dynastart[0]=0;
+
+  if (size_relax<N) {
+    if (size_relax>0) {
+      delete[] relaxorder;
+      delete[] relaxcolour;
+      delete[] relaxinv;
+    }
+    size_relax=N;
+    relaxorder=new DL_constraint*[size_relax];
+    relaxcolour=new int[size_relax+1];
+    relaxinv=new DL_subblock[size_relax];
+  }
+
+  // colour (constraints without restrictions are left out):
+  DL_constraint **con=new DL_constraint*[N];
+  int *forbidden=new int[N+1];
+  i=0; cc=(DL_constraint*)c->getfirst();
+  while (cc) {
+    con[i]=cc;
+    cc->colour=-1;
+    forbidden[i]=-1;
+    cc=(DL_constraint*)c->getnext(cc); i++;
+  }
+  forbidden[N]=-1;
+  nrrelaxcolours=0;
+  for (i=0;i<N;i++) {
+    if (con[i]->dim==0) continue;
+    for (j=mfstart[i];j<mfstart[i+1];j++) {
+      d=mfdyna[j]->probenr;
+      for (k=dynastart[d];k<dynastart[d+1];k++) {
+	col=con[dynacon[k]]->colour;
+	if (col>=0) forbidden[col]=i;
+      }
+    }
+    for (col=0;forbidden[col]==i;col++);
+    con[i]->colour=col;
+    if (col>=nrrelaxcolours) nrrelaxcolours=col+1;
+  }
+
+  // sort by colour, keeping the order of the constraints within a colour:
+  for (col=0;col<=nrrelaxcolours;col++) relaxcolour[col]=0;
+  for (i=0;i<N;i++)
+    if (con[i]->colour>=0) relaxcolour[con[i]->colour+1]++;
+  for (col=0;col<nrrelaxcolours;col++) relaxcolour[col+1]+=relaxcolour[col];
+  for (i=0;i<N;i++)
+    if (con[i]->colour>=0) relaxorder[relaxcolour[con[i]->colour]++]=con[i];
+  for (col=nrrelaxcolours;col>0;col--) relaxcolour[col]=relaxcolour[col-1];
+  relaxcolour[0]=0;
+
+  delete[] con; delete[] forbidden;
+  delete[] dynastart; delete[] dynacon;
+}
+
+static boolean DL_invert_block(DL_subblock *m, int n) {
+// inverts the upper left n x n part of m in place using Gauss-Jordan
+// elimination with partial pivoting; a singular block becomes zero
+// (so its constraint is left alone by the relaxation). The pivots are
+// compared with the largest element, as in DL_tree_solver::invert (the
+// entries of dCdR scale with the masses and the stepsize).
+// returns if the block was regular
+  DL_subblock inv;
+  int i,j,k,p;
+  DL_Scalar big,f,mx=0.0;
+  for (i=0;i<n;i++)
+    for (j=0;j<n;j++) {
+      inv.a[i][j]=(i==j ? 1.0 : 0.0);
+      if (fabs(m->a[i][j])>mx) mx=fabs(m->a[i][j]);
+    }
+  DL_Scalar tol=mx*n*DL_SCALAR_EPSILON;
+  for (k=0;k<n;k++) {
+    p=k; big=fabs(m->a[k][k]);
+    for (i=k+1;i<n;i++)
+      if (fabs(m->a[i][k])>big) { big=fabs(m->a[i][k]); p=i; }
+    if ((big<=tol) || (mx==0.0)) {
+      for (i=0;i<n;i++) for (j=0;j<n;j++) m->a[i][j]=0.0;
+      return FALSE;
+    }
+    if (p!=k)
+      for (j=0;j<n;j++) {
+	f=m->a[k][j]; m->a[k][j]=m->a[p][j]; m->a[p][j]=f;
+	f=inv.a[k][j]; inv.a[k][j]=inv.a[p][j]; inv.a[p][j]=f;
+      }
+    f=1.0/m->a[k][k];
+    for (j=0;j<n;j++) { m->a[k][j]*=f; inv.a[k][j]*=f; }
+    for (i=0;i<n;i++)
+      if (i!=k) {
+	f=m->a[i][k];
+	for (j=0;j<n;j++) {
+	  m->a[i][j]-=f*m->a[k][j];
+	  inv.a[i][j]-=f*inv.a[k][j];
+	}
+      }
+  }
+  for (i=0;i<n;i++)
+    for (j=0;j<n;j++) m->a[i][j]=inv.a[i][j];
+  return TRUE;
+}
+
+void DL_constraint_manager::prepare_relaxation() {
+  static DL_largevector org_err;
+  static DL_largevector new_err;
+  DL_largevector restr,err;
+  DL_constraint *constr;
+  int i,j,k,b,e,col,maxdim;
+  boolean empirical=FALSE;
+
+  if (!mfbuilt) find_dynas();
+  colour_by_dynas();
+  int nr=relaxcolour[nrrelaxcolours];
+
+  // the diagonal blocks, analytically where possible:
+  boolean *known=new boolean[nr+1];
+  for (col=0;col<nrrelaxcolours;col++) {
+    b=relaxcolour[col]; e=relaxcolour[col+1];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (e-b>DL_MINPARALLEL)
+#endif
+    for (k=b;k<e;k++)
+      known[k]=analytical && relaxorder[k]->dCdRsub(relaxorder[k],&relaxinv[k]);
+  }
+  for (k=0;k<nr;k++) if (!known[k]) empirical=TRUE;
+
+  if (empirical) {
+    // test the unknown blocks like calc_dCdR_empirical does, probing
+    // restriction component i of all constraints of a colour at once:
+    DL_m_integrator *save_int=DL_dsystem->get_integrator();
+    DL_euler my_int;
+    DL_dsystem->set_integrator(&my_int);
+    org_err.resize(totdim);
+    new_err.resize(totdim);
+    calc_all_errors(&org_err);
+    begin_test();
+    calc_all_errors(&org_err);
+    end_test();
+    for (col=0;col<nrrelaxcolours;col++) {
+      b=relaxcolour[col]; e=relaxcolour[col+1];
+      maxdim=0;
+      for (k=b;k<e;k++)
+	if (!known[k] && (relaxorder[k]->dim>maxdim)) maxdim=relaxorder[k]->dim;
+      for (i=0;i<maxdim;i++) {
+	begin_test();
+	for (k=b;k<e;k++) {
+	  constr=relaxorder[k];
+	  if (known[k] || (constr->dim<=i)) continue;
+	  restr.resize(constr->dim);
+	  restr.makezero();
+	  restr.set(i,1.0);
+	  constr->apply_restriction_changes(&restr);
+	}
+	for (k=b;k<e;k++) {
+	  constr=relaxorder[k];
+	  if (known[k] || (constr->dim<=i)) continue;
+	  err.view(&new_err,constr->index,constr->dim);
+	  constr->get_error(&err);
+	  for (j=0;j<constr->dim;j++)
+	    relaxinv[k].set(j,i,new_err.get(constr->index+j)-
+			        org_err.get(constr->index+j));
+	}
+	end_test();
+      }
+    }
+    DL_dsystem->set_integrator(save_int);
+  }
+  delete[] known;
+
+  // and invert them:
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (nr>DL_MINPARALLEL)
+#endif
+  for (k=0;k<nr;k++) DL_invert_block(&relaxinv[k],relaxorder[k]->dim);
+  relaxvalid=TRUE;
+}
+
+boolean DL_constraint_manager::relax(DL_largevector *total) {
+  static DL_largevector err;
+  static DL_largevector dR;
+  DL_largevector restr;
+  int k,b,e,col;
+
+  err.resize(totdim);
+  dR.resize(totdim);
+  for (col=0;col<nrrelaxcolours;col++) {
+    b=relaxcolour[col]; e=relaxcolour[col+1];
+    // the restriction changes that remove the errors of this colour
+    // (each constraint on its own):
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (e-b>DL_MINPARALLEL)
+#endif
+    for (k=b;k<e;k++) {
+      DL_largevector ce,cr;
+      DL_constraint *cc=relaxorder[k];
+      DL_Scalar s;
+      int i,j;
+      ce.view(&err,cc->index,cc->dim);
+      cr.view(&dR,cc->index,cc->dim);
+      cc->get_error(&ce);
+      for (i=0;i<cc->dim;i++) {
+	s=0.0;
+	for (j=0;j<cc->dim;j++) s+=relaxinv[k].get(i,j)*ce.get(j);
+	cr.set(i,-s);
+      }
+    }
+    // see if no reactionforces become too large (serially: the tests
+    // might delete constraints):
+    for (k=b;k<e;k++) {
+      restr.view(&dR,relaxorder[k]->index,relaxorder[k]->dim);
+      relaxorder[k]->test_restriction_changes(&restr);
+    }
+    if (c_changed) {
+      // one or more constraints deleted themselves: redo the
+      // administration as apply_all_restriction_changes does
+      redo_index_administration();
+      if (mfbuilt) {
+	find_dynas();
+	c_changed=FALSE;
+      }
+      else calc_dCdR_full();
+      relaxvalid=FALSE;
+      return TRUE;
+    }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (e-b>DL_MINPARALLEL)
+#endif
+    for (k=b;k<e;k++) {
+      DL_largevector cr;
+      cr.view(&dR,relaxorder[k]->index,relaxorder[k]->dim);
+      relaxorder[k]->apply_restriction_changes(&cr);
+    }
+  }
+  // every constraint with restrictions has a colour, so dR now holds
+  // the changes of the complete sweep:
+  if (total) total->plusis(&dR);
+  return FALSE;
+}
+
+void DL_constraint_manager::iterate_relaxation(DL_largevector *dC) {
+  static DL_largevector total;
+  int s;
+  boolean changed;
+  first_error=error;
+  relaxvalid=FALSE;
+  while ((error>max_error) && (nriter<MaxIter)) {
+    nriter++;
+    total.resize(totdim);
+    total.makezero();
+    changed=FALSE;
+    for (s=0;(s<NrSweeps) && !changed;s++) {
+      if (!relaxvalid) prepare_relaxation();
+      changed=relax(&total);
+    }
+    dC->resize(totdim);
+    calc_all_errors(dC);
+    error=dC->norm();
+    if (!changed && ((error>4*first_error) || NaN(error))) {
+      // clear divergence: undo the sweeps, and build dCdR for the rest
+      // of this frame (the next frame is solved by relaxation again,
+      // see satisfy):
+      total.neg(&total);
+      apply_all_restriction_changes(&total);
+      calc_dCdR_full();
+      dC->resize(totdim);
+      calc_all_errors(dC);
+      error=dC->norm();
+      iterate(dC);
+      return;
+    }
+  }
+}
+
+int DL_constraint_manager::colour_constraints() {
+  // based on the connectivity info in cp, colour the constraints so that
+  // no constraint error is influenced by two constraints of the same
+  // colour (a distance-2 colouring of the constraint graph, done
+  // greedily in the order of the constraints). The restriction changes
+  // of all constraints of one colour can then be tested at once.
+  // Returns the number of colours, or 0 if cp doesn't give the
+  // structure of dCdR (a constraint without analytical derivatives
+  // doesn't even influence its own error according to cp).
+  // Constraints without restrictions (dim 0, like connectors) are
+  // left out, and get colour -1.
+
+  int N=0;
+  int P=0;
+  int i,j,k,l,col,nrcolours=0;
+  boolean known=TRUE;
+  DL_constraint *cc; DL_constraint_pair *cpe;
+
+  // number the constraints with restrictions sequentially (keeping
+  // the number in colour for now):
+  cc=(DL_constraint*)c->getfirst();
+  while (cc) {
+    if (cc->dim>0) cc->colour=N++;
+    else cc->colour=-1;
+    cc=(DL_constraint*)c->getnext(cc);
+  }
+  DL_constraint **con=new DL_constraint*[N];
+  cc=(DL_constraint*)c->getfirst();
+  while (cc) {
+    if (cc->colour>=0) con[cc->colour]=cc;
+    cc=(DL_constraint*)c->getnext(cc);
+  }
+  cpe=(DL_constraint_pair *)cp.getfirst();
+  while (cpe) {
+    if ((cpe->cc->dim>0) && (cpe->cf->dim>0)) P++;
+    cpe=(DL_constraint_pair *)cp.getnext(cpe);
+  }
+
+  // the pairs by column (the influencing constraint) and by row (the
+  // influenced constraint):
+  int *colstart=new int[N+1];
+  int *rowstart=new int[N+1];
+  int *colrow=new int[P];
+  int *rowcol=new int[P];
+  boolean *diag=new boolean[N];
+  for (i=0;i<=N;i++) colstart[i]=rowstart[i]=0;
+  for (i=0;i<N;i++) diag[i]=FALSE;
+  cpe=(DL_constraint_pair *)cp.getfirst();
+  while (cpe) {
+    if ((cpe->cc->dim>0) && (cpe->cf->dim>0)) {
+      colstart[cpe->cf->colour+1]++;
+      rowstart[cpe->cc->colour+1]++;
+      if (cpe->cc==cpe->cf) diag[cpe->cc->colour]=TRUE;
+    }
+    cpe=(DL_constraint_pair *)cp.getnext(cpe);
+  }
+  for (i=0;i<N;i++) {
+    if (!diag[i]) known=FALSE;
+    colstart[i+1]+=colstart[i];
+    rowstart[i+1]+=rowstart[i];
+  }
+  cpe=(DL_constraint_pair *)cp.getfirst();
+  while (cpe) {
+    if ((cpe->cc->dim>0) && (cpe->cf->dim>0)) {
+      i=cpe->cc->colour; j=cpe->cf->colour;
+      colrow[colstart[j]++]=i;
+      rowcol[rowstart[i]++]=j;
+    }
+    cpe=(DL_constraint_pair *)cp.getnext(cpe);
+  }
+  // (the starts have moved to the ends: shift them back)
+  for (i=N;i>0;i--) {
+    colstart[i]=colstart[i-1];
+    rowstart[i]=rowstart[i-1];
+  }
+  colstart[0]=rowstart[0]=0;
+  for (i=0;i<N;i++) con[i]->colour=-1;
+
+  if (known) {
+    // forbidden[col]==j: colour col is taken by a constraint that
+    // influences the error of a constraint constraint j influences
+    int *forbidden=new int[N];
+    for (i=0;i<N;i++) forbidden[i]=-1;
+    for (j=0;j<N;j++) {
+      for (k=colstart[j];k<colstart[j+1];k++) {
+	i=colrow[k];
+	for (l=rowstart[i];l<rowstart[i+1];l++) {
+	  col=con[rowcol[l]]->colour;
+	  if (col>=0) forbidden[col]=j;
+	}
+      }
+      for (col=0;forbidden[col]==j;col++);
+      con[j]->colour=col;
+      if (col>=nrcolours) nrcolours=col+1;
+    }
+    delete[] forbidden;
+  }
+
+  delete[] con;
+  delete[] colstart; delete[] rowstart;
+  delete[] colrow; delete[] rowcol;
+  delete[] diag;
+  return nrcolours;
+}
+
+// the number of probes (test restriction changes) done in one test:
+// with dual numbers a test can carry one probe per derivative.
+#ifdef DL_DUAL_SCALAR
+#define DL_NRPROBES DL_DUAL_WIDTH
+#else
+#define DL_NRPROBES 1
+#endif
+
 void DL_constraint_manager::calc_dCdR_empirical() {
   static DL_largevector org_err;
   static DL_largevector new_err;
   static DL_largevector err_dif;
   static DL_largevector test_restr;
-  int i;
+  DL_largevector restr;
+  DL_constraint *constr,*cc;
+  DL_constraint_pair *cpe;
+  int i,k,n,r,col,nrcolours;
+  int probecol[DL_NRPROBES], probei[DL_NRPROBES];
+  boolean full, apply;
   
+  for (k=0;k<DL_NRPROBES;k++) probecol[k]=probei[k]=0;
   org_err.resize(totdim);
   new_err.resize(totdim);
   err_dif.resize(totdim);
+  test_restr.resize(totdim);
+
+  // colour the constraints; if cp doesn't tell which constraints
+  // influence each other, each constraint gets its own colour and
+  // each probe yields a full column of dCdR:
+  nrcolours=colour_constraints();
+  full=(nrcolours==0);
+  constr=(DL_constraint *)c->getfirst();
+  while (constr) {
+    if (full) constr->colour=(constr->dim>0 ? nrcolours++ : -1);
+    constr=(DL_constraint*)c->getnext(constr);
+  }
+  // the largest dimension within each colour:
+  int *maxdim=new int[nrcolours];
+  for (col=0;col<nrcolours;col++) maxdim[col]=0;
+  constr=(DL_constraint *)c->getfirst();
+  while (constr) {
+    if ((constr->colour>=0) && (constr->dim>maxdim[constr->colour]))
+      maxdim[constr->colour]=constr->dim;
+    constr=(DL_constraint*)c->getnext(constr);
+  }
 
   // use an Euler-integrator (modified with the discretisation factor)
   // to do the testing:
@@ -288,40 +1129,91 @@ void DL_constraint_manager::calc_dCdR_empirical() {
 
   // first force reintegration with the new integrator
   calc_all_errors(&org_err);
+#ifndef DL_DUAL_SCALAR
   // then establish the baseline
   begin_test();
   calc_all_errors(&org_err);
   end_test();
+#endif
   
-  // then traverse all restrictions of all constraints and apply
-  // a testvector and observe the difference in error it yields
+  // then probe restriction component i of all constraints of a colour
+  // at a time, and observe the change in error this yields. Each probe
+  // is a unit test vector, or, with dual numbers, a zero test vector
+  // of which the derivatives are seeded (so the derivatives of the
+  // errors are exact columns of dCdR):
 
   dCdR->makezero();
-  DL_constraint *constr=(DL_constraint *)c->getfirst();
-  while (constr) {
-    test_restr.resize(constr->dim);
-    test_restr.makezero();
-    for (i=0;i<constr->dim;i++) {
-       begin_test();
-       test_restr.set(i,1.0); // test with unit vector i
-       constr->apply_restriction_changes(&test_restr);
-       calc_all_errors(&new_err);
-       new_err.minus(&org_err,&err_dif);
-       dCdR->setcolumn(constr->index+i,&err_dif);
-       test_restr.set(i,0.0); // make zero vector again
-       end_test();            // restore the state
+  test_restr.makezero();
+  col=i=0; // the next probe
+  while (col<nrcolours) {
+    begin_test();
+    for (n=0;(n<DL_NRPROBES) && (col<nrcolours);n++) {
+      probecol[n]=col; probei[n]=i;
+      constr=(DL_constraint *)c->getfirst();
+      while (constr) {
+	if ((constr->colour==col) && (constr->dim>i))
+#ifdef DL_DUAL_SCALAR
+	  test_restr.set(constr->index+i,DL_dual(0.0,n));
+#else
+	  test_restr.set(constr->index+i,1.0);
+#endif
+	constr=(DL_constraint*)c->getnext(constr);
+      }
+      if (++i==maxdim[col]) { col++; i=0; }
     }
-    constr=(DL_constraint*)c->getnext(constr);
+    constr=(DL_constraint *)c->getfirst();
+    while (constr) {
+      apply=FALSE;
+      for (k=0;k<n;k++)
+	if ((constr->colour==probecol[k]) && (constr->dim>probei[k]))
+	  apply=TRUE;
+      if (apply) {
+	restr.view(&test_restr,constr->index,constr->dim);
+	constr->apply_restriction_changes(&restr);
+      }
+      constr=(DL_constraint*)c->getnext(constr);
+    }
+    calc_all_errors(&new_err);
+    end_test();            // restore the state
+
+    // split the changes in error over the columns of the probes:
+    for (k=0;k<n;k++) {
+#ifdef DL_DUAL_SCALAR
+      for (r=0;r<totdim;r++) err_dif.set(r,new_err.get(r).d[k]);
+#else
+      new_err.minus(&org_err,&err_dif);
+#endif
+      if (full) {
+	constr=(DL_constraint *)c->getfirst();
+	while (constr->colour!=probecol[k])
+	  constr=(DL_constraint*)c->getnext(constr);
+	dCdR->setcolumn(constr->index+probei[k],&err_dif);
+      }
+      else {
+	cpe=(DL_constraint_pair *)cp.getfirst();
+	while (cpe) {
+	  constr=cpe->cf; cc=cpe->cc;
+	  if ((constr->colour==probecol[k]) && (constr->dim>probei[k]))
+	    for (r=cc->index;r<cc->index+cc->dim;r++)
+	      dCdR->set(r,constr->index+probei[k],err_dif.get(r));
+	  cpe=(DL_constraint_pair *)cp.getnext(cpe);
+	}
+      }
+    }
+    test_restr.makezero(); // make zero vector again
   }
+  delete[] maxdim;
 
   // restore the motion integrator:
   DL_dsystem->set_integrator(save_int);
   c_changed=FALSE;
+  factored=FALSE;
                                      #ifdef DCDR
                                        DL_dsystem->get_companion()->Msg("dCdR (empirical)\n");
 				       dCdR->show();
                                      #endif
 }
+#undef DL_NRPROBES
 
 void DL_constraint_manager::calc_dCdR_full(){
   DL_constraint_pair *cpe;
@@ -332,15 +1224,14 @@ void DL_constraint_manager::calc_dCdR_full(){
   // then calculate dCdR analytically and build cp:
   DL_constraint* cc=(DL_constraint *)c->getfirst();
   DL_constraint* cf;
-  DL_largematrix sub;
+  DL_subblock sub;
   int i=0;
   dCdR->resize(totdim,totdim);
   while (cc) {
     cf=(DL_constraint *)c->getfirst();
     while (cf) {
-      sub.resize(cc->dim,cf->dim);
       if (cf->dCdRsub(cc,&sub)) {
-        dCdR->setsubmatrixnonzero(cc->index,cf->index,&sub);
+        dCdR->setsubmatrixnonzero(cc->index,cf->index,cc->dim,cf->dim,&sub);
 	cpe=new DL_constraint_pair(cc,cf);
 	i++;
 	cp.addelem(cpe);
@@ -353,6 +1244,7 @@ void DL_constraint_manager::calc_dCdR_full(){
 //  if (dCdR->get_solve_method()==lud_bcksub) // always sort: sm might change
   sort_constraints();
   dCdR->analyse_structure();
+  tree_valid=FALSE;
                                      #ifdef DCDR
                                        DL_dsystem->get_companion()->Msg("-=-\ndCdR (analytical):\n");
                                        dCdR->show();
@@ -360,22 +1252,23 @@ void DL_constraint_manager::calc_dCdR_full(){
   // if we had to calculate dCdR empirically: do so:
   if (!analytical) calc_dCdR_empirical();
   c_changed=FALSE;
+  factored=FALSE;
+  mfbuilt=FALSE;
 }
 
 void DL_constraint_manager::calc_dCdR_analytical(){
 // using the cp list calculated by calc_dCdR_full, calculate
 // dCdR analytically
 // let the constraints do all of the work...
-  static DL_largematrix sub;
+  DL_subblock sub;
   DL_constraint *cc,*cf;
   DL_constraint_pair *cpe=(DL_constraint_pair*)cp.getfirst();
   dCdR->makezero();
   int i=0;
   while (cpe) {
     cc=cpe->cc; cf=cpe->cf;
-    sub.resize(cc->dim,cf->dim);
     cf->dCdRsub(cc,&sub);
-    dCdR->setsubmatrix(cc->index,cf->index,&sub);
+    dCdR->setsubmatrix(cc->index,cf->index,cc->dim,cf->dim,&sub);
     cpe=(DL_constraint_pair*)cp.getnext(cpe);
     i++;
   }
@@ -384,6 +1277,7 @@ void DL_constraint_manager::calc_dCdR_analytical(){
 				       dCdR->show();
                                      #endif
   c_changed=FALSE;
+  factored=FALSE;
 }
 
 #include "queue.h"
@@ -567,6 +1461,64 @@ void DL_constraint_manager::sort_constraints() {
   delete[] newindex;
 }
 
+static int DL_by_serial(const void *a, const void *b) {
+  long sa=(*(DL_constraint**)a)->serial;
+  long sb=(*(DL_constraint**)b)->serial;
+  return (sa<sb ? -1 : (sa>sb ? 1 : 0));
+}
+
+int DL_constraint_manager::snapshot_order(DL_constraint **order) {
+  // merging and splitting compounds moves constraints around in the
+  // list, so the order of creation is used instead:
+  int n=0;
+  DL_List *l=c;
+  DL_compound *cc=(DL_compound*)DL_dsystem->get_compounds()->getfirst();
+  while (l) {
+    DL_constraint *constr=(DL_constraint *)l->getfirst();
+    while (constr) {
+      if (order) order[n]=constr;
+      n++;
+      constr=(DL_constraint*)l->getnext(constr);
+    }
+    if (cc) {
+      l=&(cc->aside);
+      cc=(DL_compound*)DL_dsystem->get_compounds()->getnext(cc);
+    }
+    else l=NULL;
+  }
+  if (order) qsort(order,n,sizeof(DL_constraint*),DL_by_serial);
+  return n;
+}
+
+void DL_constraint_manager::save_state(DL_snapshot *snap){
+  // snapshots are taken between frames, so there are no collisions
+  // in the list of constraints
+  int i,n=snapshot_order(NULL);
+  DL_constraint* *order=new DL_constraint*[n+1];
+  snapshot_order(order);
+  snap->header()->nrconstraints=n;
+  snap->put((DL_Scalar)nr_cg);
+  for (i=0;i<n;i++) order[i]->save_state(snap);
+  delete[] order;
+}
+
+boolean DL_constraint_manager::restore_state(DL_snapshot *snap){
+  int i,n=snapshot_order(NULL);
+  if (snap->header()->nrconstraints!=n) {
+    snap->fail();
+    return FALSE;
+  }
+  DL_constraint* *order=new DL_constraint*[n+1];
+  snapshot_order(order);
+  nr_cg=(int)DL_value(snap->get());
+  for (i=0;(i<n) && snap->read_ok();i++) order[i]->restore_state(snap);
+  delete[] order;
+  // dCdR belongs to the frame before the restored one (if it was
+  // reused for several frames), so have it recalculated
+  dCdRToGo=0;
+  return snap->read_ok();
+}
+
 void DL_constraint_manager::add_collision(DL_collision *col){
   if (size_collisions==nrcollisions) {
     // have to increase the size of collisions:
@@ -580,6 +1532,285 @@ void DL_constraint_manager::add_collision(DL_collision *col){
   nrcollisions++;
 }
 
+int DL_constraint_manager::touched_dynas(DL_constraint *constr) {
+  // probe the constraint like find_dynas does:
+  static DL_largevector ones;
+  DL_dyna *d;
+  int k,n=0;
+  if (constr->dim==0) return 0;
+  clear_probes();
+  DL_dyna::probing=TRUE;
+  ones.resize(constr->dim);
+  for (k=0;k<constr->dim;k++) ones.set(k,1.0);
+  constr->apply_restrictions(&ones);
+  for (d=DL_dyna::firstprobed;d;d=d->get_nextprobed()) {
+    if (n==size_touched) { // have to increase the size of touched
+      DL_dyna* *newtouched=new DL_dyna*[2*size_touched+10];
+      for (k=0;k<n;k++) newtouched[k]=touched[k];
+      if (size_touched>0) delete[] touched;
+      size_touched=2*size_touched+10;
+      touched=newtouched;
+    }
+    touched[n++]=d;
+  }
+  clear_probes();
+  DL_dyna::probing=FALSE;
+  return n;
+}
+
+void DL_constraint_manager::set_aside(DL_constraint *constr,
+				      DL_compound *cc) {
+  constr->hide_forces();
+  c->remelem(constr);
+  cc->aside.addelem(constr);
+  constr->setaside=cc;
+  c_changed=TRUE;
+}
+
+void DL_constraint_manager::settle_new_constraints() {
+  // a new constraint between members of one compound is set aside
+  // (the compound is split up at the end of the frame, unless it is a
+  // collision), and one that applies to members of compounds is
+  // remapped to them (or has them split up if it cannot be):
+  int i,j,n;
+  boolean internal;
+  DL_constraint *constr;
+  DL_compound *cc;
+  for (i=0;i<nrnewcons;i++) {
+    constr=newcons[i];
+    // a connector acts through its ptp and orientation constraints:
+    if (constr->is_connector())
+      n=touched_dynas(((DL_connector*)constr)->myptp);
+    else n=touched_dynas(constr);
+    internal=(n>=2);
+    cc=NULL;
+    for (j=0;(j<n) && internal;j++) {
+      if (!touched[j]->get_compound()) internal=FALSE;
+      else if (!cc) cc=(DL_compound*)touched[j]->get_compound();
+      else if (touched[j]->get_compound()!=cc) internal=FALSE;
+    }
+    if (internal) {
+      set_aside(constr,cc);
+      if (!constr->is_collision()) cc->splitpending=TRUE;
+    }
+    else if (!constr->is_connector()) {
+      for (j=0;j<n;j++) {
+	cc=(DL_compound*)touched[j]->get_compound();
+	if (!cc) continue;
+	if (constr->remappable()) cc->remap(constr,touched[j]);
+	else cc->splitpending=TRUE;
+      }
+    }
+  }
+  nrnewcons=0;
+}
+
+void DL_constraint_manager::merge_welded() {
+  // the candidate welds: active connectors between two dynas that are
+  // not part of a compound yet, that have been around for a few frames
+  // and carry a modest load:
+  int i,j,k,n,nw=0,nd=0,nc=0;
+  DL_constraint *constr;
+  DL_connector *w;
+  DL_dyna *d0,*d1;
+  if (!merge_welds) return;
+  constr=(DL_constraint*)c->getfirst();
+  while (constr) {
+    if (constr->is_connector()) nc++;
+    constr=(DL_constraint*)c->getnext(constr);
+  }
+  if (nc==0) return;
+  DL_connector* *welds=new DL_connector*[nc];
+  DL_dyna* *wd=new DL_dyna*[2*nc];
+  constr=(DL_constraint*)c->getfirst();
+  while (constr) {
+    if (constr->is_connector()) {
+      w=(DL_connector*)constr;
+      d0=w->myptp->get_dyna();
+      if (w->active && w->myptp->active && w->myorient->active &&
+	  d0 && w->myptp->get_geo() && w->myptp->get_geo()->is_dyna() &&
+	  (w->myptp->get_nrhistory()>=2) &&
+	  (w->myorient->get_nrhistory()>=2) &&
+	  (w->load_fraction()<DL_MERGEFRACTION)) {
+	d1=(DL_dyna*)w->myptp->get_geo();
+	if ((d0!=d1) && !d0->is_compound() && !d1->is_compound() &&
+	    !d0->get_compound() && !d1->get_compound()) {
+	  wd[2*nw]=d0;
+	  wd[2*nw+1]=d1;
+	  welds[nw++]=w;
+	}
+      }
+    }
+    constr=(DL_constraint*)c->getnext(constr);
+  }
+  if (nw==0) {
+    delete[] welds;
+    delete[] wd;
+    return;
+  }
+
+  // number the dynas of the welds (using probenr), and find the groups
+  // they form, keeping the root of each group in group:
+  DL_dyna* *gd=new DL_dyna*[2*nw];
+  int *group=new int[2*nw];
+  int *nrinternal=new int[2*nw];
+  int *size=new int[2*nw];
+  boolean *ok=new boolean[2*nw];
+  for (i=0;i<2*nw;i++) {
+    d0=wd[i];
+    if ((d0->probenr<0) || (d0->probenr>=nd) || (gd[d0->probenr]!=d0)) {
+      d0->probenr=nd;
+      gd[nd]=d0;
+      group[nd]=nd;
+      nrinternal[nd]=0;
+      size[nd]=1;
+      ok[nd]=TRUE;
+      nd++;
+    }
+  }
+  for (i=0;i<nw;i++) {
+    j=wd[2*i]->probenr;
+    while (group[j]!=j) j=group[j];
+    k=wd[2*i+1]->probenr;
+    while (group[k]!=k) k=group[k];
+    if (j==k) ok[j]=FALSE; // a loop
+    else {
+      if (size[j]<size[k]) { n=j; j=k; k=n; }
+      group[k]=j;
+      size[j]+=size[k];
+      ok[j]=ok[j] && ok[k];
+    }
+  }
+  for (i=0;i<nd;i++) {
+    j=i;
+    while (group[j]!=j) j=group[j];
+    group[i]=j;
+  }
+
+  // a group can only be merged if there are no other constraints
+  // between its dynas than the welds, and if all the constraints
+  // between its dynas and the rest can be remapped:
+  constr=(DL_constraint*)c->getfirst();
+  while (constr) {
+    n=touched_dynas(constr);
+    k=-1;
+    for (j=0;j<n;j++) {
+      d0=touched[j];
+      if ((d0->probenr<0) || (d0->probenr>=nd) || (gd[d0->probenr]!=d0)) {
+	k=-2;
+	continue;
+      }
+      if (k==-1) k=group[d0->probenr];
+      else if ((k>=0) && (group[d0->probenr]!=k)) k=-2;
+    }
+    if ((k>=0) && (n>=2)) nrinternal[k]++;
+    else if (!constr->remappable()) {
+      for (j=0;j<n;j++) {
+	d0=touched[j];
+	if ((d0->probenr>=0) && (d0->probenr<nd) && (gd[d0->probenr]==d0))
+	  ok[group[d0->probenr]]=FALSE;
+      }
+    }
+    constr=(DL_constraint*)c->getnext(constr);
+  }
+
+  // merge the groups that pass (each weld has a ptp and an orientation
+  // constraint), with the members in breadth first order:
+  DL_dyna* *member=new DL_dyna*[nd];
+  int *parent=new int[nd];
+  DL_connector* *weld=new DL_connector*[nd];
+  boolean *placed=new boolean[nd];
+  boolean merged=FALSE;
+  DL_compound *cc;
+  for (i=0;i<nd;i++) placed[i]=FALSE;
+  for (i=0;i<nd;i++) {
+    if ((group[i]!=i) || !ok[i] || (nrinternal[i]!=2*(size[i]-1))) continue;
+    member[0]=gd[i];
+    parent[0]=-1;
+    weld[0]=NULL;
+    placed[i]=TRUE;
+    n=1;
+    for (j=0;j<n;j++) {
+      for (k=0;k<nw;k++) {
+	if (wd[2*k]==member[j]) d0=wd[2*k+1];
+	else if (wd[2*k+1]==member[j]) d0=wd[2*k];
+	else continue;
+	if (placed[d0->probenr]) continue;
+	placed[d0->probenr]=TRUE;
+	member[n]=d0;
+	parent[n]=j;
+	weld[n++]=welds[k];
+      }
+    }
+    cc=new DL_compound(n,member,parent,weld);
+    DL_dsystem->add_compound(cc);
+    for (j=1;j<n;j++) {
+      set_aside(weld[j],cc);
+      set_aside(weld[j]->myptp,cc);
+      set_aside(weld[j]->myorient,cc);
+    }
+    merged=TRUE;
+  }
+
+  // remap the constraints between the new compounds and the rest:
+  if (merged) {
+    constr=(DL_constraint*)c->getfirst();
+    while (constr) {
+      n=touched_dynas(constr);
+      for (j=0;j<n;j++) {
+	cc=(DL_compound*)touched[j]->get_compound();
+	if (cc) cc->remap(constr,touched[j]);
+      }
+      constr=(DL_constraint*)c->getnext(constr);
+    }
+  }
+
+  delete[] welds;
+  delete[] wd;
+  delete[] gd;
+  delete[] group;
+  delete[] nrinternal;
+  delete[] size;
+  delete[] ok;
+  delete[] member;
+  delete[] parent;
+  delete[] weld;
+  delete[] placed;
+}
+
+void DL_constraint_manager::split_overloaded() {
+  DL_compound *next,*cc=(DL_compound*)DL_dsystem->get_compounds()->getfirst();
+  while (cc) {
+    next=(DL_compound*)DL_dsystem->get_compounds()->getnext(cc);
+    if (!merge_welds || cc->splitpending ||
+	(cc->weld_load()>DL_SPLITFRACTION)) split_compound(cc,FALSE);
+    cc=next;
+  }
+}
+
+void DL_constraint_manager::split_compounds() {
+  DL_compound *cc;
+  while ((cc=(DL_compound*)DL_dsystem->get_compounds()->getfirst()))
+    split_compound(cc,TRUE);
+}
+
+void DL_constraint_manager::split_compound(DL_compound *cc,
+					   boolean prepared) {
+  DL_constraint *constr;
+  cc->split(prepared);
+  DL_dsystem->rem_compound(cc);
+  // the welds come back without a history (so they are not merged
+  // again straight away):
+  while ((constr=(DL_constraint*)cc->aside.getfirst())) {
+    cc->aside.remelem(constr);
+    constr->setaside=NULL;
+    constr->reset();
+    add(constr);
+  }
+  delete cc;
+  c_changed=TRUE;
+}
+
 void DL_constraint_manager::show_constraint_forces() {
   if (show_con_forces) return;
   DL_constraint *cc=(DL_constraint*)c->getfirst();
@@ -602,16 +1833,23 @@ void DL_constraint_manager::hide_constraint_forces() {
 
 void DL_constraint_manager::solve_using_lud(){
     dCdR->set_min_solve_method(lud_bcksub);
+    relaxing=FALSE;
 }
 
 void DL_constraint_manager::solve_using_cg(){
   dCdR->set_min_solve_method(conjug_grad);
   nr_cg=0;
+  relaxing=FALSE;
 }
 
 void DL_constraint_manager::solve_using_svd(){
   dCdR->set_min_solve_method(svd);
   nr_cg=0;
+  relaxing=FALSE;
+}
+
+void DL_constraint_manager::solve_using_relaxation(){
+  relaxing=TRUE;
 }
 
 #undef DCDR
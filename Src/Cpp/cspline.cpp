@@ -47,9 +47,8 @@ DL_cspline::~DL_cspline(void) {
   if (segment) delete[] segment;
 }
 
-void DL_cspline::init(DL_geo *geo, DL_List *points, boolean _cyclic) {
-  DL_point *p0,*p1,*p2,*p3;
-  int i,n=points->length();
+void DL_cspline::init(DL_geo *geo, DL_point *points, int n, boolean _cyclic) {
+  int i;
   
   if (n<3) {
     DL_dsystem->get_companion()->Msg("Error: cspline::init: a cspline requires at least 3 control points\n cspline curve not initialised\n");
@@ -62,27 +61,22 @@ void DL_cspline::init(DL_geo *geo, DL_List *points, boolean _cyclic) {
   maxparam=(float)( cyclic ? n : n-1 );
   
   // initialise all segments;
-  segment=new DL_csplinesegment[(int)maxparam];
+  segment=new DL_csplinesegment[(int)DL_value(maxparam)];
   
   if (cyclic) {
-    p0=(DL_point*)(points->getfirst());
-    p1=(DL_point*)(points->getnext(p0));
-    p2=(DL_point*)(points->getnext(p1));
-    p3=(DL_point*)(points->getnext(p2));
+    // segment i is determined by control points i..i+3 (wrapping around)
     for (i=0; i<n; i++) {
-      segment[i].init(g,p0,p1,p2,p3);
+      segment[i].init(g,&points[i],&points[(i+1)%n],
+		      &points[(i+2)%n],&points[(i+3)%n]);
       segment[i].set_interval(i,1); // set t and dt
-      p0=p1; p1=p2; p2=p3; p3=(DL_point*)(points->getnext(p2));
-      if (p3==NULL) p3=(DL_point*)(points->getfirst());
     }
   }
   else {
-    p1=p2=(DL_point*)(points->getfirst());
-    p3=(DL_point*)(points->getnext(p2));
+    // segment i is determined by control points i-1..i+2, where the
+    // first and last control points are doubled at the ends
     for (i=0; i<n-1; i++) {
-      p0=p1; p1=p2; p2=p3; p3=(DL_point*)(points->getnext(p2));
-      if (p3==NULL) p3=p2;
-      segment[i].init(g,p0,p1,p2,p3);
+      segment[i].init(g,&points[(i>0 ? i-1 : 0)],&points[i],
+		      &points[i+1],&points[(i+2<n ? i+2 : n-1)]);
       segment[i].set_interval(i,1); // set t and dt
     }
   }
@@ -94,10 +88,10 @@ void DL_cspline::assign(DL_cspline* bs){
     // first delete the old list and make an empty new one:
     int i;
     delete[] segment;
-    segment=new DL_csplinesegment[(int)bs->maxparam];
+    segment=new DL_csplinesegment[(int)DL_value(bs->maxparam)];
 
     // then copy:
-    for (i=0; i<(int)bs->maxparam; i++) {
+    for (i=0; i<(int)DL_value(bs->maxparam); i++) {
       segment[i].assign(&(bs->segment[i]));
     }
 
@@ -111,9 +105,9 @@ boolean DL_cspline::pos(DL_Scalar s, DL_point *p) {
 // whether s is within bounds as return value
   int i; // index specifying correct segment
   if (cyclic) {
-    int sn=(int)floor(s);
-    i=sn%(int)maxparam;
-    if (i<0) i+=(int)maxparam;
+    int sn=(int)DL_value(floor(s));
+    i=sn%(int)DL_value(maxparam);
+    if (i<0) i+=(int)DL_value(maxparam);
     s-=(sn-i);
   }
   else {
@@ -122,11 +116,11 @@ boolean DL_cspline::pos(DL_Scalar s, DL_point *p) {
       return FALSE;
     }
     if (s>maxparam) {
-      segment[(int)maxparam-1].pos(maxparam,p);
+      segment[(int)DL_value(maxparam)-1].pos(maxparam,p);
       return FALSE;
     }
-    i=(int)floor(s);
-    if (i==(int)maxparam) i-=1;
+    i=(int)DL_value(floor(s));
+    if (i==(int)DL_value(maxparam)) i-=1;
   }
   // ok: we're in bounds
   segment[i].pos(s,p);
@@ -138,9 +132,9 @@ boolean DL_cspline::deriv(DL_Scalar s, DL_vector *v){
 // and whether s in within bounds as return value
   int i; // index specifying correct segment
   if (cyclic) {
-    int sn=(int)floor(s);
-    i=sn%(int)maxparam;
-    if (i<0) i+=(int)maxparam;
+    int sn=(int)DL_value(floor(s));
+    i=sn%(int)DL_value(maxparam);
+    if (i<0) i+=(int)DL_value(maxparam);
     s-=(sn-i);
   }
   else {
@@ -149,10 +143,10 @@ boolean DL_cspline::deriv(DL_Scalar s, DL_vector *v){
       return FALSE;
     }
     if (s>maxparam) {
-      segment[(int)maxparam].deriv(maxparam,v);
+      segment[(int)DL_value(maxparam)].deriv(maxparam,v);
       return FALSE;
     }
-    i=(int)floor(s) % (int)maxparam;
+    i=(int)DL_value(floor(s)) % (int)DL_value(maxparam);
   }
   // ok: we're in bounds
   segment[i].deriv(s,v);
@@ -164,9 +158,9 @@ boolean DL_cspline::deriv2(DL_Scalar s, DL_vector *v){
 // and whether s in within bounds as return value
   int i; // index specifying correct segment
   if (cyclic) {
-    int sn=(int)floor(s);
-    i=sn%(int)maxparam;
-    if (i<0) i+=(int)maxparam;
+    int sn=(int)DL_value(floor(s));
+    i=sn%(int)DL_value(maxparam);
+    if (i<0) i+=(int)DL_value(maxparam);
     s-=(sn-i);
   }
   else {
@@ -175,10 +169,10 @@ boolean DL_cspline::deriv2(DL_Scalar s, DL_vector *v){
       return FALSE;
     }
     if (s>maxparam) {
-      segment[(int)maxparam].deriv2(maxparam,v);
+      segment[(int)DL_value(maxparam)].deriv2(maxparam,v);
       return FALSE;
     }
-    i=(int)floor(s) % (int)maxparam;
+    i=(int)DL_value(floor(s)) % (int)DL_value(maxparam);
   }
   // ok: we're in bounds
   segment[i].deriv2(s,v);
@@ -231,7 +225,7 @@ DL_Scalar DL_cspline::closeto(DL_point *p) {
 }
 
 void DL_cspline::update_control_point(int i, DL_point *pn){
-  int j,segm,M=(int)maxparam;
+  int j,segm,M=(int)DL_value(maxparam);
   if ((i<0) || (i> (cyclic ? M-1 : M))) {
     DL_dsystem->get_companion()->Msg("Warning: DL_cspline::update_control_point(int,DL_point): index out of range\n");
     return;
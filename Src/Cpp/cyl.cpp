@@ -32,13 +32,13 @@
 
 #include "dyna_system.h"
 #include "cyl.h"
+#include "snapshot.h"
 
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
-DL_cyl::DL_cyl():DL_constraint(),
-  dcdp0(2,3),dcdp1(2,3),df0dR(3,2),df1dR(3,2) {
+DL_cyl::DL_cyl():DL_constraint() {
   dim=4;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -100,7 +100,7 @@ void DL_cyl::init(DL_dyna* _d, DL_point* _pd0, DL_point *_pd1,
   get_error(&lv);
   if (lv.norm()!=0.0) {
     DL_dsystem->get_companion()->Msg("Warning: initially invalid cylinder constraint.\n Error: (%f,%f,%f,%f)\n",
-				  lv.get(0), lv.get(1), lv.get(2), lv.get(3) );
+				  DL_value(lv.get(0)), DL_value(lv.get(1)), DL_value(lv.get(2)), DL_value(lv.get(3)) );
   }
 }
 
@@ -142,65 +142,56 @@ void DL_cyl::end_test(void) {
   if (g_is_dyna) ((DL_dyna*)g)->endtest();
 }
 
-boolean DL_cyl::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_cyl::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf0;
-  static DL_largematrix dcdf1;
-  static DL_largematrix subtemp;
-  static DL_largematrix tmp;
+  DL_jacblock dcdf0;
+  DL_jacblock dcdf1;
+  DL_subblock subtemp;
+  DL_fixmat<DL_MAXCDIM,2> tmp;
   boolean nonzero;
-  dcdf0.resize(cc->dim,3);
   if (nonzero=cc->dCdFq(d,&pd0,&dcdf0)) {
-    dcdf1.resize(cc->dim,3);
-    tmp.resize(cc->dim,2);
-    dcdf0.times(&df0dR,&tmp);
-    sub->setsubmatrix(0,0,&tmp);
+    dcdf0.times(&df0dR,&tmp,cc->dim);
+    sub->setsubmatrix(0,0,&tmp,cc->dim);
     cc->dCdFq(d,&pd1,&dcdf1);
-    dcdf1.times(&df1dR,&tmp);
-    sub->setsubmatrix(0,2,&tmp);
+    dcdf1.times(&df1dR,&tmp,cc->dim);
+    sub->setsubmatrix(0,2,&tmp,cc->dim);
   }
   if (g_is_dyna) {
    if (nonzero) {
     if (cc->dCdFq((DL_dyna*)g,&pg0,&dcdf0)) {
-      dcdf1.resize(cc->dim,3);
-      subtemp.resize(cc->dim,dim);
-      tmp.resize(cc->dim,2);
-      dcdf0.times(&df0dR,&tmp);
-      subtemp.setsubmatrix(0,0,&tmp);
+      dcdf0.times(&df0dR,&tmp,cc->dim);
+      subtemp.setsubmatrix(0,0,&tmp,cc->dim);
       cc->dCdFq((DL_dyna*)g,&pg1,&dcdf1);
-      dcdf1.times(&df1dR,&tmp);
-      subtemp.setsubmatrix(0,2,&tmp);
-      sub->minusis(&subtemp);
+      dcdf1.times(&df1dR,&tmp,cc->dim);
+      subtemp.setsubmatrix(0,2,&tmp,cc->dim);
+      sub->minusis(&subtemp,cc->dim,dim);
     }
    }
    else {
     if (nonzero=cc->dCdFq((DL_dyna*)g,&pg0,&dcdf0)) {
-      dcdf1.resize(cc->dim,3);
-      tmp.resize(cc->dim,2);
-      dcdf0.times(&df0dR,&tmp);
-      sub->setsubmatrix(0,0,&tmp);
+      dcdf0.times(&df0dR,&tmp,cc->dim);
+      sub->setsubmatrix(0,0,&tmp,cc->dim);
       cc->dCdFq((DL_dyna*)g,&pg1,&dcdf1);
-      dcdf1.times(&df1dR,&tmp);
-      sub->setsubmatrix(0,2,&tmp);
-      sub->neg();
+      dcdf1.times(&df1dR,&tmp,cc->dim);
+      sub->setsubmatrix(0,2,&tmp,cc->dim);
+      sub->neg(cc->dim,dim);
     }
    }
   }
   return nonzero;
 }
 
-boolean DL_cyl::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_cyl::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
-  static DL_largematrix dcIdf(2,3);
+  DL_fixmat<2,3> dcIdf;
   DL_matrix dpdX;
   DL_matrix ddpdX;
 
@@ -211,8 +202,7 @@ boolean DL_cyl::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp0.times(&dpdf,&dcIdf);
+    dcdp0.times(&dpdX,&dcIdf);
     dcdfq->setsubmatrix(0,0,&dcIdf);
     
     dc->dpdfq(&pd1,pc,&dpdX);
@@ -221,8 +211,7 @@ boolean DL_cyl::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdfq->setsubmatrix(2,0,&dcIdf);
     
     return TRUE;
@@ -234,8 +223,7 @@ boolean DL_cyl::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp0.times(&dpdf,&dcIdf);
+    dcdp0.times(&dpdX,&dcIdf);
     dcdfq->setsubmatrix(0,0,&dcIdf);
     
     dc->dpdfq(&pg1,pc,&dpdX);
@@ -244,23 +232,21 @@ boolean DL_cyl::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdfq->setsubmatrix(2,0,&dcIdf);
     
-    dcdfq->neg();    
+    dcdfq->neg(dim);    
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_cyl::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_cyl::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
-  static DL_largematrix dcIdf(2,3);
+  DL_fixmat<2,3> dcIdf;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -270,8 +256,7 @@ boolean DL_cyl::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp0.times(&dpdf,&dcIdf);
+    dcdp0.times(&dpdX,&dcIdf);
     dcdf->setsubmatrix(0,0,&dcIdf);
     
     dc->dpdF(&pd1,&dpdX);
@@ -280,8 +265,7 @@ boolean DL_cyl::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdf->setsubmatrix(2,0,&dcIdf);
     
     return TRUE;
@@ -293,8 +277,7 @@ boolean DL_cyl::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp0.times(&dpdf,&dcIdf);
+    dcdp0.times(&dpdX,&dcIdf);
     dcdf->setsubmatrix(0,0,&dcIdf);
     
     dc->dpdF(&pg1,&dpdX);
@@ -303,24 +286,22 @@ boolean DL_cyl::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdf->setsubmatrix(2,0,&dcIdf);
     
-    dcdf->neg();    
+    dcdf->neg(dim);    
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_cyl::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_cyl::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dpdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dpdm(3,3);
-  static DL_largematrix dcIdm(2,3);
+  DL_fixmat<2,3> dcIdm;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -330,8 +311,7 @@ boolean DL_cyl::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp0.times(&dpdm,&dcIdm);
+    dcdp0.times(&dpdX,&dcIdm);
     dcdm->setsubmatrix(0,0,&dcIdm);
     
     dc->dpdM(&pd1,&dpdX);
@@ -340,8 +320,7 @@ boolean DL_cyl::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp1.times(&dpdm,&dcIdm);
+    dcdp1.times(&dpdX,&dcIdm);
     dcdm->setsubmatrix(2,0,&dcIdm);
     
     return TRUE;
@@ -353,8 +332,7 @@ boolean DL_cyl::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp0.times(&dpdm,&dcIdm);
+    dcdp0.times(&dpdX,&dcIdm);
     dcdm->setsubmatrix(0,0,&dcIdm);
     
     dc->dpdM(&pg1,&dpdX);
@@ -363,24 +341,22 @@ boolean DL_cyl::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp1.times(&dpdm,&dcIdm);
+    dcdp1.times(&dpdX,&dcIdm);
     dcdm->setsubmatrix(2,0,&dcIdm);
     
-    dcdm->neg();    
+    dcdm->neg(dim);    
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_cyl::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_cyl::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dpdi(3,3);
-  static DL_largematrix dcIdi(2,3);
+  DL_fixmat<2,3> dcIdi;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -390,8 +366,7 @@ boolean DL_cyl::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp0.times(&dpdi,&dcIdi);
+    dcdp0.times(&dpdX,&dcIdi);
     dcdi->setsubmatrix(0,0,&dcIdi);
     
     dc->dpdi(&pd1,pc,&dpdX);
@@ -400,8 +375,7 @@ boolean DL_cyl::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp1.times(&dpdi,&dcIdi);
+    dcdp1.times(&dpdX,&dcIdi);
     dcdi->setsubmatrix(2,0,&dcIdi);
     
     return TRUE;
@@ -413,8 +387,7 @@ boolean DL_cyl::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp0.times(&dpdi,&dcIdi);
+    dcdp0.times(&dpdX,&dcIdi);
     dcdi->setsubmatrix(0,0,&dcIdi);
     
     dc->dpdi(&pg1,pc,&dpdX);
@@ -423,11 +396,10 @@ boolean DL_cyl::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp1.times(&dpdi,&dcIdi);
+    dcdp1.times(&dpdX,&dcIdi);
     dcdi->setsubmatrix(2,0,&dcIdi);
     
-    dcdi->neg();    
+    dcdi->neg(dim);    
     return TRUE;
   }
   return FALSE;
@@ -581,3 +553,14 @@ void DL_cyl::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_cyl::save_state(DL_snapshot *snap) {
+  DL_constraint::save_state(snap);
+  // the local coordinate system, which is rotated along with l each frame:
+  snap->put(&l); snap->put(&x); snap->put(&y);
+}
+
+void DL_cyl::restore_state(DL_snapshot *snap) {
+  DL_constraint::restore_state(snap);
+  snap->get(&l); snap->get(&x); snap->get(&y);
+}
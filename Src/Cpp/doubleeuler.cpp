@@ -53,13 +53,11 @@ void DL_double_euler::integrate(DL_supvec *y, DL_dyna *d, DL_supvec *ny) {
   DL_supvec k1, k2;
 
   d->ode(y,&k1,dfh);
-  k1.times(halfh,ny);
-  ny->plusis(y);
+  ny->plustimes(y,halfh,&k1);
   ny->q2A(d);
 
   d->ode(ny,&k2,dfh);
-  k2.timesis(halfh);
-  ny->plusis(&k2);
+  ny->plustimes(ny,halfh,&k2);
   ny->q2A(d);
 }
 
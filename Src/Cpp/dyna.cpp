@@ -32,33 +32,37 @@
 
 #include "dyna.h"
 #include "dyna_system.h"
+#include "snapshot.h"
 
 //#define DEBUG
 //#define DEBUG2
 
+// the probing administration (see DL_constraint_manager::matrix_free):
+boolean  DL_dyna::probing=FALSE;
+DL_dyna* DL_dyna::firstprobed=NULL;
+
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
 void DL_dyna::assign(DL_dyna* d, void *comp) {
   if (d) {
+    void *oldcomp=get_companion();
     DL_geo::assign(d,comp);
+    if (DL_dsystem) DL_dsystem->reindex_dyna(this,oldcomp);
     oneD=d->oneD;
     J.assign(&(d->J)); 
     Jinv.assign(&(d->Jinv)); 
     F.assign(&(d->F));
     M.assign(&(d->M));
-    // assign the forces list:
+    // assign the forces array:
     {
-      forces.delete_all();
-      DL_Mpair *tmp=(DL_Mpair*)d->forces.getfirst();
-      while (tmp) {
-        DL_Mpair *tmp2=new DL_Mpair;
-	tmp2->force.assign(&(tmp->force));
-	tmp2->rho.assign(&(tmp->rho));
-	forces.addelem(tmp2);
-	tmp=(DL_Mpair*)(d->forces.getnext(tmp));
+      if (maxforces<d->nforces) grow_forces(d->nforces);
+      for (int i=0;i<d->nforces;i++) {
+	forces[i].force.assign(&(d->forces[i].force));
+	forces[i].rho.assign(&(d->forces[i].rho));
       }
+      nforces=d->nforces;
     }
     nextmstate.assign(&(d->nextmstate));
     mstateimp.assign(&(d->mstateimp));
@@ -71,6 +75,18 @@ void DL_dyna::assign(DL_dyna* d, void *comp) {
 }
 
 void DL_dyna::prepare_for_next_frame(void) {
+  if (compound) {
+    // the compound has been prepared already: just follow it
+    follow(&(compound->mstate),&mstate);
+    nextmstate.assign(&mstate);
+    mstateimp.assign(&mstate);
+    Fuptodate=Muptodate=FALSE;
+    F.init(0,0,0); M.init(0,0,0);
+    nforces=0;
+    matrixcache1empty=matrixcache2empty=TRUE;
+    return;
+  }
+
   // integrate the motion state to obtain nextmstate
   integrate();  
 
@@ -80,7 +96,7 @@ void DL_dyna::prepare_for_next_frame(void) {
   mstate.assign(&nextmstate);
   Fuptodate=Muptodate=FALSE;
   F.init(0,0,0); M.init(0,0,0);
-  forces.delete_all();
+  nforces=0;
   matrixcache1empty=matrixcache2empty=TRUE;
 
   // apply velocity damping.
@@ -97,9 +113,9 @@ void DL_dyna::prepare_for_next_frame(void) {
   dystem->get_companion()->Msg("center of mass of %s: %f %f %f\n", getname(), mstate.z.x, mstate.z.y, mstate.z.z );
   dystem->get_companion()->Msg("orientation of %s:\n %f %f %f\n %f %f %f\n %f %f %f\n",
       getname(),
-      mstate.A.c0->x, mstate.A.c1->x, mstate.A.c2->x,
-      mstate.A.c0->y, mstate.A.c1->y, mstate.A.c2->y,
-      mstate.A.c0->z, mstate.A.c1->z, mstate.A.c2->z
+      mstate.get_A()->c0->x, mstate.get_A()->c1->x, mstate.get_A()->c2->x,
+      mstate.get_A()->c0->y, mstate.get_A()->c1->y, mstate.get_A()->c2->y,
+      mstate.get_A()->c0->z, mstate.get_A()->c1->z, mstate.get_A()->c2->z
      );
 #endif
 }
@@ -112,21 +128,12 @@ void DL_dyna::begintest(void) {
   FuptodateSave=Fuptodate;
   MuptodateSave=Muptodate;
   mstateimpSave.assign(&mstateimp);
-  if (Fuptodate || Muptodate) {
-    mstateSave.assign(&nextmstate);
-    // save the forces list:
-    {
-      forcesSave.delete_all();
-      DL_Mpair *tmp=(DL_Mpair*)forces.getfirst();
-      while (tmp) {
-        DL_Mpair *tmp2=new DL_Mpair;
-	tmp2->force.assign(&(tmp->force));
-	tmp2->rho.assign(&(tmp->rho));
-	forcesSave.addelem(tmp2);
-	tmp=(DL_Mpair*)forces.getnext(tmp);
-      }
-    }    
-  }
+  // the pairs in the forces array are not changed during testing
+  // (see applyforce), so remembering their number is enough:
+  nforcesSave=nforces;
+  if (Fuptodate || Muptodate) mstateSave.assign(&nextmstate);
+  // the loads are passed on to the compound:
+  if (compound) compound->begintest();
 }
 
 void DL_dyna::endtest(void) {
@@ -137,28 +144,127 @@ void DL_dyna::endtest(void) {
   Fuptodate=FuptodateSave;
   Muptodate=MuptodateSave;
   mstateimp.assign(&mstateimpSave);
-  if (Fuptodate || Muptodate) {
-    nextmstate.assign(&mstateSave);
-    // restore the forces list:
-    {
-      forces.delete_all();
-      DL_Mpair *tmp=(DL_Mpair*)forcesSave.getfirst();
-      while (tmp) {
-        DL_Mpair *tmp2=new DL_Mpair;
-	tmp2->force.assign(&(tmp->force));
-	tmp2->rho.assign(&(tmp->rho));
-	forces.addelem(tmp2);
-	tmp=(DL_Mpair*)forcesSave.getnext(tmp);
-      }
-    }    
+  nforces=nforcesSave; // forget the pairs added during the test
+  if (Fuptodate || Muptodate) nextmstate.assign(&mstateSave);
+  if (compound) compound->endtest();
+}
+
+void DL_dyna::follow(DL_supvec *cs, DL_supvec *s) {
+  DL_vector r;
+  DL_matrix A;
+  cs->get_A()->times(&cpos,&r);
+  cs->z.plus(&r,&(s->z));
+  r.crossprod(&(cs->w),&(s->v));
+  s->v.plusis(&(cs->v));
+  s->w.assign(&(cs->w));
+  cs->get_A()->times(&cA,&A);
+  s->set_A(&A);
+  s->A2q();
+}
+
+void DL_dyna::follow_compound(void) {
+  compound->integrate();
+  follow(&(compound->nextmstate),&nextmstate);
+  follow(&(compound->mstateimp),&mstateimp);
+}
+
+void DL_dyna::compound_force(DL_point *p, DL_vector *f) {
+  DL_point pc;
+  DL_vector r,t;
+  // keep the totals (the torque based on the current orientation):
+  F.plusis(f);
+  mstate.get_A()->times(p,&pc);
+  pc.tovector(&r);
+  f->crossprod(&r,&t);
+  M.plusis(&t);
+  // and apply the force to the same point of the compound:
+  cA.times(p,&pc);
+  pc.plusis(&cpos);
+  compound->applyforce(&pc,compound,f);
+}
+
+void DL_dyna::compound_impulse(DL_point *p, DL_vector *i) {
+  DL_point pc;
+  DL_vector r,t;
+  DL_Scalar hinv=1.0/DL_dsystem->get_integrator()->stepsize();
+  i->times(hinv,&t);
+  F.plusis(&t);
+  mstate.get_A()->times(p,&pc);
+  pc.tovector(&r);
+  i->crossprod(&r,&t);
+  t.timesis(hinv);
+  M.plusis(&t);
+  cA.times(p,&pc);
+  pc.plusis(&cpos);
+  compound->applyimpulse(&pc,compound,i);
+}
+
+void DL_dyna::grow_forces(int n) {
+  // double the size of the forces array (at least to n pairs), copying
+  // the pairs in use. The array is never shrunk, so this only happens
+  // in the first frames that have more force application points than
+  // the dyna has seen before.
+  int newmax=2*maxforces;
+  if (newmax<n) newmax=n;
+  DL_Mpair *newforces=new DL_Mpair[newmax];
+  for (int i=0;i<nforces;i++) {
+    newforces[i].force.assign(&(forces[i].force));
+    newforces[i].rho.assign(&(forces[i].rho));
+  }
+  if (forces!=forcesbuf) delete [] forces;
+  forces=newforces;
+  maxforces=newmax;
+}
+
+void DL_dyna::save_state(DL_snapshot *snap) {
+  int i;
+  snap->put(&mstate);
+  snap->put(&nextmstate);
+  snap->put(&mstateimp);
+  snap->put(&F);
+  snap->put(&M);
+  snap->put(&Fexternal);
+  snap->put((DL_Scalar)Fuptodate);
+  snap->put((DL_Scalar)Muptodate);
+  // the forces applied (by the user) since the last frame:
+  snap->put((DL_Scalar)nforces);
+  for (i=0;i<nforces;i++) {
+    snap->put(&(forces[i].force));
+    snap->put(&(forces[i].rho));
   }
 }
 
+void DL_dyna::restore_state(DL_snapshot *snap) {
+  int i,n;
+  snap->get(&mstate);
+  snap->get(&nextmstate);
+  snap->get(&mstateimp);
+  snap->get(&F);
+  snap->get(&M);
+  snap->get(&Fexternal);
+  Fuptodate=(boolean)DL_value(snap->get());
+  Muptodate=(boolean)DL_value(snap->get());
+  n=(int)DL_value(snap->get());
+  if ((n<0) || !snap->read_ok()) {
+    snap->fail();
+    return;
+  }
+  nforces=0;
+  if (n>maxforces) grow_forces(n);
+  for (i=0;i<n;i++) {
+    snap->get(&(forces[i].force));
+    snap->get(&(forces[i].rho));
+  }
+  nforces=n;
+  testing=FALSE;
+  matrixcache1empty=matrixcache2empty=TRUE;
+}
+
 DL_Scalar DL_dyna::kinenergy(void) {
   DL_vector vtmp;
-  vtmp.x=mstate.A.c0.inprod(&(mstate.w));
-  vtmp.y=mstate.A.c1.inprod(&(mstate.w));
-  vtmp.z=mstate.A.c2.inprod(&(mstate.w));
+  vtmp.x=mstate.get_A()->c0.inprod(&(mstate.w));
+  vtmp.y=mstate.get_A()->c1.inprod(&(mstate.w));
+  vtmp.z=mstate.get_A()->c2.inprod(&(mstate.w));
   // vtmp=A^T*omega
   return 0.5*(totalmass*mstate.v.inprod(&(mstate.v))+
               vtmp.x*vtmp.x*J.x+
@@ -178,9 +284,9 @@ DL_Scalar DL_dyna::totenergy(void) {
 
 DL_Scalar DL_dyna::impkinenergy(void) {
   DL_vector vtmp;
-  vtmp.x=mstateimp.A.c0.inprod(&(mstateimp.w));
-  vtmp.y=mstateimp.A.c1.inprod(&(mstateimp.w));
-  vtmp.z=mstateimp.A.c2.inprod(&(mstateimp.w));
+  vtmp.x=mstateimp.get_A()->c0.inprod(&(mstateimp.w));
+  vtmp.y=mstateimp.get_A()->c1.inprod(&(mstateimp.w));
+  vtmp.z=mstateimp.get_A()->c2.inprod(&(mstateimp.w));
   // vtmp=A^T*omega
   return 0.5*(mstateimp.v.inprod(&(mstateimp.v))*totalmass+
               vtmp.x*vtmp.x*J.x+
@@ -201,9 +307,9 @@ DL_Scalar DL_dyna::imptotenergy(void) {
 DL_Scalar DL_dyna::newkinenergy(void) {
   DL_vector vtmp;
   integrate();
-  vtmp.x=nextmstate.A.c0.inprod(&(nextmstate.w));
-  vtmp.y=nextmstate.A.c1.inprod(&(nextmstate.w));
-  vtmp.z=nextmstate.A.c2.inprod(&(nextmstate.w));
+  vtmp.x=nextmstate.get_A()->c0.inprod(&(nextmstate.w));
+  vtmp.y=nextmstate.get_A()->c1.inprod(&(nextmstate.w));
+  vtmp.z=nextmstate.get_A()->c2.inprod(&(nextmstate.w));
   // vtmp=A^T*omega
   return 0.5*(totalmass*nextmstate.v.inprod(&(nextmstate.v))+
               vtmp.x*vtmp.x*J.x+
@@ -33,6 +33,8 @@
 #include "dyna.h"
 #include "dyna_system.h"
 #include "constraint_manager.h"
+#include "compound.h"
+#include "snapshot.h"
 
 // pointer to the one and only dyna_system:
 DL_dyna_system* DL_dsystem=NULL;
@@ -63,34 +65,57 @@ void DL_dyna_system::get_gravity(DL_vector *g) {
 }
 
 DL_geo* DL_dyna_system::register_geo(void *comp){
-  // traverse the geos-list to see if we already have a geo listed
-  // with comp as its companion. If so: return a reference to this geo,
+  // look up if we already have a geo listed with comp as its
+  // companion. If so: return a reference to this geo,
   // if not: create a new geo as companion for comp and add it to the
   // list (and return a reference to it).
   if (!comp) return NULL;
-  DL_geo *g=(DL_geo*)geos.getfirst();
-  while (g) {
-    if (g->get_companion()==comp) return g;
-    g=(DL_geo*)geos.getnext(g);
-  }
+  DL_geo *g=(DL_geo*)geoindex.find(comp);
+  if (g) return g;
   g=new DL_geo(comp);
   companion->get_first_geo_info(g);
   geos.addelem(g);
+  geoindex.insert(comp,g);
   return g;
 }
 
 void DL_dyna_system::remove_geo(DL_geo *g){
+  // only remove geos that are actually registered (removing an
+  // element that is not in the list would corrupt the list)
+  if (!g) return;
+  if (geoindex.find(g->get_companion())!=g) return;
+  geoindex.remove(g->get_companion());
   geos.remelem(g);
 }
 
+DL_geo* DL_dyna_system::find_geo(void *comp){
+  return (DL_geo*)geoindex.find(comp);
+}
+
 void DL_dyna_system::register_dyna(DL_dyna *d){
   dynas.addelem(d);
+  if (d->get_companion()) dynaindex.insert(d->get_companion(),d);
 }
 
 void DL_dyna_system::remove_dyna(DL_dyna *d){
+  // a dyna that is part of a compound should not be moved by it anymore:
+  if (d->get_compound() && DL_constraints)
+    DL_constraints->split_compound((DL_compound*)d->get_compound(),TRUE);
+  if (dynaindex.find(d->get_companion())==d)
+    dynaindex.remove(d->get_companion());
   dynas.remelem(d);
 }
 
+DL_dyna* DL_dyna_system::find_dyna(void *comp){
+  return (DL_dyna*)dynaindex.find(comp);
+}
+
+void DL_dyna_system::reindex_dyna(DL_dyna *d, void *oldcomp){
+  if (oldcomp==d->get_companion()) return;
+  if (dynaindex.find(oldcomp)==d) dynaindex.remove(oldcomp);
+  if (d->get_companion()) dynaindex.insert(d->get_companion(),d);
+}
+
 void DL_dyna_system::add_controller(DL_controller *c) {
   if (show_con_forces) c->show_forces();
   else c->hide_forces();
@@ -101,6 +126,14 @@ void DL_dyna_system::rem_controller(DL_controller *c) {
   controllers.remelem(c);
 }
 
+void DL_dyna_system::add_compound(DL_dyna *d) {
+  compounds.addelem(d);
+}
+
+void DL_dyna_system::rem_compound(DL_dyna *d) {
+  compounds.remelem(d);
+}
+
 void DL_dyna_system::update_dyna_companions(void) {
   DL_dyna *d=(DL_dyna*)dynas.getfirst();
   while (d) {
@@ -109,6 +142,61 @@ void DL_dyna_system::update_dyna_companions(void) {
   }
 }
 
+void DL_dyna_system::save_state(DL_snapshot *snap) {
+  // the members of compounds follow them, so their states (and the
+  // constraints set aside) describe the scene as it would be without
+  // compounds, and the snapshot can be taken without disturbing them:
+  DL_snapshot_header *hd=snap->header();
+  hd->frame_nr=frame_nr;
+  hd->time=curtime;
+  if (integrator) {
+    hd->h=integrator->stepsize();
+    hd->oldh=integrator->old_stepsize();
+  }
+  hd->nrdynas=dynas.length();
+  DL_dyna *d=(DL_dyna*)dynas.getfirst();
+  while (d) {
+    d->save_state(snap);
+    d=(DL_dyna*)dynas.getnext(d);
+  }
+  if (DL_constraints) DL_constraints->save_state(snap);
+  else hd->nrconstraints=0;
+}
+
+boolean DL_dyna_system::restore_state(DL_snapshot *snap) {
+  // the snapshot can only be restored into the same scene: the same
+  // dynas and active constraints, created in the same order. It is
+  // restored into the scene without compounds (they are merged again
+  // a few frames later):
+  if (DL_constraints) DL_constraints->split_compounds();
+  DL_snapshot_header *hd=snap->header();
+  int nrc=(DL_constraints ? DL_constraints->get_nr_constraints() : 0);
+  if ((hd->nrdynas!=dynas.length()) || (hd->nrconstraints!=nrc)) {
+    companion->Msg("Error: snapshot of %d dynas and %d constraints does not match the\n       current %d dynas and %d constraints; not restored.\n",
+		   hd->nrdynas, hd->nrconstraints, dynas.length(), nrc);
+    return FALSE;
+  }
+  frame_nr=hd->frame_nr;
+  curtime=hd->time;
+  if (integrator) {
+    integrator->set_stepsize(hd->oldh);
+    integrator->shift_stepsize();
+    integrator->set_stepsize(hd->h);
+  }
+  DL_dyna *d=(DL_dyna*)dynas.getfirst();
+  while (d && snap->read_ok()) {
+    d->restore_state(snap);
+    d=(DL_dyna*)dynas.getnext(d);
+  }
+  if (DL_constraints && snap->read_ok()) DL_constraints->restore_state(snap);
+  if (!snap->read_ok()) {
+    companion->Msg("Error: snapshot does not match the current scene; it has only been\n       partially restored.\n");
+    return FALSE;
+  }
+  update_dyna_companions();
+  return TRUE;
+}
+
 void DL_dyna_system::dynamics(void) {
   DL_controller *con=(DL_controller*)controllers.getfirst();
   while(con) {
@@ -127,13 +215,24 @@ void DL_dyna_system::dynamics(void) {
     g=(DL_geo*)geos.getnext(g);
   }
   
-  if (DL_constraints) DL_constraints->satisfy();
+  if (DL_constraints) {
+    DL_constraints->satisfy();
+    DL_constraints->split_overloaded();
+  }
 
+  // the dynas that are part of a compound follow it, so the compounds
+  // go first:
+  d=(DL_dyna*)compounds.getfirst();
+  while (d) {
+    d->prepare_for_next_frame();
+    d=(DL_dyna*)compounds.getnext(d);
+  }
   d=(DL_dyna*)dynas.getfirst();
   while (d) {
     d->prepare_for_next_frame();
     d=(DL_dyna*)dynas.getnext(d);
   }
+  if (DL_constraints) DL_constraints->merge_welded();
   update_dyna_companions();
 
   if ((gravity.x!=0.0)||(gravity.y!=0.0)||(gravity.z!=0.0)) {
@@ -177,6 +276,11 @@ void DL_dyna_system::set_integrator(DL_m_integrator *i) {
       d->reintegrate();
       d=(DL_dyna*)dynas.getnext(d);
     }
+    d=(DL_dyna*)compounds.getfirst();
+    while (d) {
+      d->reintegrate();
+      d=(DL_dyna*)compounds.getnext(d);
+    }
   }
 }
 
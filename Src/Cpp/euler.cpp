@@ -50,8 +50,7 @@ void DL_euler::set_stepsize(DL_Scalar newh) {
 
 void DL_euler::integrate(DL_supvec *y, DL_dyna *d, DL_supvec *ny) {
   d->ode(y,ny,dfh);
-  ny->timesis(h);
-  ny->plusis(y);
+  ny->plustimes(y,h,ny);
   ny->q2A(d);
 }
 
@@ -38,7 +38,7 @@
 // ************************** //
  
 void DL_geo::move(DL_point *newpos, DL_matrix *neworient){
-  DL_matrix Ad;
+  DL_matrix Ad,Atmp;
   DL_vector vtmp;
   DL_Scalar h=DL_dsystem->get_integrator()->stepsize();
   DL_Scalar oldh=DL_dsystem->get_integrator()->old_stepsize();
@@ -61,26 +61,26 @@ void DL_geo::move(DL_point *newpos, DL_matrix *neworient){
   vtmp.minus(&(mstate.v),&(nextmstate.v));
 
   if (h==oldh) {
-    neworient->minus(&(mstate.A),&Ad);
-    mstate.A.assign(&(nextmstate.A));
-    mstate.w.init(Ad.c0.z*mstate.A.c0.y+Ad.c1.z*mstate.A.c1.y+Ad.c2.z*mstate.A.c2.y,
-	  	  Ad.c0.x*mstate.A.c0.z+Ad.c1.x*mstate.A.c1.z+Ad.c2.x*mstate.A.c2.z,
-		  Ad.c0.y*mstate.A.c0.x+Ad.c1.y*mstate.A.c1.x+Ad.c2.y*mstate.A.c2.x);
+    neworient->minus(mstate.get_A(),&Ad);
+    mstate.set_A(nextmstate.get_A());
+    mstate.w.init(Ad.c0.z*mstate.get_A()->c0.y+Ad.c1.z*mstate.get_A()->c1.y+Ad.c2.z*mstate.get_A()->c2.y,
+	  	  Ad.c0.x*mstate.get_A()->c0.z+Ad.c1.x*mstate.get_A()->c1.z+Ad.c2.x*mstate.get_A()->c2.z,
+		  Ad.c0.y*mstate.get_A()->c0.x+Ad.c1.y*mstate.get_A()->c1.x+Ad.c2.y*mstate.get_A()->c2.x);
     mstate.w.timesis(0.5/h);
   }
   else {
-    nextmstate.A.minus(&(mstate.A),&(mstate.A));
-    mstate.A.timesis(h/((h+oldh)*oldh));
-    neworient->minus(&(nextmstate.A),&Ad);
+    nextmstate.get_A()->minus(mstate.get_A(),&Atmp);
+    Atmp.timesis(h/((h+oldh)*oldh));
+    neworient->minus(nextmstate.get_A(),&Ad);
     Ad.timesis(oldh/((h+oldh)*h));
-    Ad.plusis(&(mstate.A));
-    mstate.A.assign(&(nextmstate.A));
-    mstate.w.init(Ad.c0.z*mstate.A.c0.y+Ad.c1.z*mstate.A.c1.y+Ad.c2.z*mstate.A.c2.y,
-	  	  Ad.c0.x*mstate.A.c0.z+Ad.c1.x*mstate.A.c1.z+Ad.c2.x*mstate.A.c2.z,
-		  Ad.c0.y*mstate.A.c0.x+Ad.c1.y*mstate.A.c1.x+Ad.c2.y*mstate.A.c2.x);
+    Ad.plusis(&Atmp);
+    mstate.set_A(nextmstate.get_A());
+    mstate.w.init(Ad.c0.z*mstate.get_A()->c0.y+Ad.c1.z*mstate.get_A()->c1.y+Ad.c2.z*mstate.get_A()->c2.y,
+	  	  Ad.c0.x*mstate.get_A()->c0.z+Ad.c1.x*mstate.get_A()->c1.z+Ad.c2.x*mstate.get_A()->c2.z,
+		  Ad.c0.y*mstate.get_A()->c0.x+Ad.c1.y*mstate.get_A()->c1.x+Ad.c2.y*mstate.get_A()->c2.x);
   }
-  nextmstate.A.assign(neworient);
-  nextmstate.A.minus(&(mstate.A),&Ad);
+  nextmstate.set_A(neworient);
+  nextmstate.get_A()->minus(mstate.get_A(),&Ad);
   vtmp.init(Ad.c0.z*neworient->c0.y+Ad.c1.z*neworient->c1.y+Ad.c2.z*neworient->c2.y,
 	    Ad.c0.x*neworient->c0.z+Ad.c1.x*neworient->c1.z+Ad.c2.x*neworient->c2.z,
             Ad.c0.y*neworient->c0.x+Ad.c1.y*neworient->c1.x+Ad.c2.y*neworient->c2.x);
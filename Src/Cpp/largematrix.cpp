@@ -31,11 +31,56 @@
 //
 
 #include "largematrix.h"
+#include "NaN.h"
 //#define DEBUG
 
-// use pivoting in LU decomposition/backward substitution or not:
+// use the (unblocked, implicitly scaled) pivoting LU decomposition and
+// backward substitution for both dense and banded matrices. Otherwise
+// dense matrices use a blocked decomposition with partial pivoting, and
+// banded ones are decomposed without pivoting (keeping the band):
 //#define PIVOT
 
+// the number of columns decomposed at a time by the blocked ludcmp(),
+// and the block sizes used by the blocked matrix product:
+#define DL_LUBLOCK 32
+#define DL_GEMMBLOCK 64
+
+#ifdef DL_LAPACK
+#ifdef DL_DUAL_SCALAR
+#error the BLAS and LAPACK routines do not work on dual numbers
+#endif
+// use the (Fortran) BLAS and LAPACK routines for dense matrices:
+extern "C" {
+  void dgemm_(const char*,const char*,const int*,const int*,const int*,
+	      const double*,const double*,const int*,const double*,const int*,
+	      const double*,double*,const int*);
+  void dgetrf_(const int*,const int*,double*,const int*,int*,int*);
+  void dgetrs_(const char*,const int*,const int*,const double*,const int*,
+	       const int*,double*,const int*,int*);
+  void sgemm_(const char*,const char*,const int*,const int*,const int*,
+	      const float*,const float*,const int*,const float*,const int*,
+	      const float*,float*,const int*);
+  void sgetrf_(const int*,const int*,float*,const int*,int*,int*);
+  void sgetrs_(const char*,const int*,const int*,const float*,const int*,
+	       const int*,float*,const int*,int*);
+}
+#ifdef DL_SINGLE_PRECISION
+#define DL_GEMM  sgemm_
+#define DL_GETRF sgetrf_
+#define DL_GETRS sgetrs_
+#else
+#define DL_GEMM  dgemm_
+#define DL_GETRF dgetrf_
+#define DL_GETRS dgetrs_
+#endif
+#endif
+
+DL_pool* DL_smallmatrix_pool() {
+  // (constructed on first use, so it outlives all matrices using it)
+  static DL_pool pool(DL_SMALLMATRIX*sizeof(DL_Scalar));
+  return &pool;
+}
+
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
@@ -56,6 +101,15 @@ void DL_largematrix::assign(DL_largematrix *lm) {
   rep=lm->rep;
   sm=lm->sm;
   min_sm=lm->min_sm;
+  mixed=lm->mixed;
+  lumixed=lm->lumixed;
+  mixedstalled=lm->mixedstalled;
+  anorm=lm->anorm;
+  if (lumixed && ((rep==lud) || (rep==ludb))) {
+    if (!luf) luf=new float[nrelem];
+    for (i=0;i<nrelem;i++) luf[i]=lm->luf[i];
+    return;
+  }
   switch (lm->rep) {
   case full: break;
   case riss:
@@ -68,18 +122,13 @@ void DL_largematrix::assign(DL_largematrix *lm) {
     for (i=0; i<nrnonzero; i++) ijami[i]=lm->ijami[i];
     break;
   case lud:
-    rep=lud;
-    if (!lu) lu=new DL_Scalar[nrelem];
-    for (i=0;i<nrelem;i++) lu[i]=lm->lu[i];
-    if (!indx) indx=new int[nrrows];
-    for (i=0;i<nrrows;i++) indx[i]=lm->indx[i];
-    break;
   case ludb:
-    rep=ludb;
     if (!lu) lu=new DL_Scalar[nrelem];
     for (i=0;i<nrelem;i++) lu[i]=lm->lu[i];
-    if (!indx) indx=new int[nrrows];
-    for (i=0;i<nrrows;i++) indx[i]=lm->indx[i];
+    if (lm->indx) {
+      if (!indx) indx=new int[nrrows];
+      for (i=0;i<nrrows;i++) indx[i]=lm->indx[i];
+    }
     break;
   case svdcmpd:
     rep=svdcmpd;
@@ -124,7 +173,6 @@ void DL_largematrix::full2riss() {
 
 #ifdef PIVOT
 
-#define TINY 1.0e-10
 int DL_largematrix::ludcmp(){
 // Calculates the LU-decomposion of the matrix. The lower and
 // upper matrices are stored in a, while the permutation vector
@@ -151,7 +199,7 @@ int DL_largematrix::ludcmp(){
     big=0.0;
     for(j=0;j<nrcols;j++)
       if ((temp=fabs(a[nrcols_i+j])) > big) big=temp;
-    if (big<TINY) {
+    if (big<DL_TINY) {
       delete[] indx; indx=NULL;
       return i;
     }
@@ -197,7 +245,7 @@ int DL_largematrix::ludcmp(){
 	  vv.set(imax,vv.get(j));
       }
       indx[j]=imax;
-      if (lu[nrcols_j_j] == 0.0) lu[nrcols_j_j]=TINY;
+      if (lu[nrcols_j_j] == 0.0) lu[nrcols_j_j]=DL_TINY;
       if (j!=nrcols-1) {
           dum=1.0/(lu[nrcols_j_j]);
 	  int nrcols_i_j=nrcols*(j+1)+j;
@@ -238,7 +286,7 @@ int DL_largematrix::ludcmpbw(){
     for(j=lb;j<ub;j++) {
       if ((temp=fabs(a[nrcols_i+j])) > big) big=temp;
     }
-    if (big<TINY) {
+    if (big<DL_TINY) {
       delete[] indx; indx=NULL;
       return i;
     }
@@ -290,7 +338,7 @@ int DL_largematrix::ludcmpbw(){
       vv.set(imax,vv.get(j));
     }
     indx[j]=imax;
-    if (lu[nrcols_j_j] == 0.0) lu[nrcols_j_j]=TINY;
+    if (lu[nrcols_j_j] == 0.0) lu[nrcols_j_j]=DL_TINY;
     if (j+1!=nrcols) {
       dum=1.0/(lu[nrcols_j_j]);
       int nrcols_i_j=(j+1)*nrcols+j;
@@ -304,7 +352,6 @@ int DL_largematrix::ludcmpbw(){
   rep=ludb;
   return -1;
 }
-#undef TINY
 
 void DL_largematrix::lubksb(DL_largevector *x, DL_largevector *b){
 // Using the LU decomposition stored in this matrix, solves x from
@@ -369,10 +416,14 @@ void DL_largematrix::lubksbbw(DL_largevector *x,DL_largevector *b){
 
 #else  // notdef PIVOT
 
-#define TINY 1.0e-10
 int DL_largematrix::ludcmp(){
-// Calculates the LU-decomposion of the matrix. The lower and
-// upper matrices are stored in lu
+// Calculates the LU-decomposion of the matrix with partial pivoting.
+// The lower and upper matrices are stored in lu, the row interchanges
+// in indx (row j was interchanged with row indx[j]) and d is the sign
+// of the permutation (used in determinant determination).
+// Blocks of DL_LUBLOCK columns are decomposed at a time, after which
+// the rest of the matrix is updated row by row, so the work is done in
+// long contiguous (vectorisable) loops that run over cached data.
 
 // If the decomposition went ok, a negative integer is returned.
 // Otherwise the index of the offending row is returned. In the latter
@@ -380,39 +431,61 @@ int DL_largematrix::ludcmp(){
 
 // PRE: nrrows==nrcols && rep==full
 
-  int i, j, k;
-  DL_Scalar sum,dum;
+  int i, j, k, kb, nb, imax;
+  DL_Scalar big, temp, dum;
   if (!lu) lu=new DL_Scalar[nrelem];
+  if (!indx) indx=new int[nrcols];
+  for (i=0;i<nrelem;i++) lu[i]=a[i];
+  d=1.0;
 
-  int nrcols_i=0;   // INV: nrcols_i==nrcols*i
-  int nrcols_j_j=0; // INV: nrcols_j_j==nrcols*j+j
-  
-  for(j=0;j<nrcols;j++) {
-    nrcols_i=0;
-    for(i=0;i<=j;i++) {
-      int nrcols_k_j=j;   // INV: nrcols_k_j==nrcols*k+j
-      sum=a[nrcols_i+j];
-      for(k=0;k<i;k++) {
-	sum-=lu[nrcols_i+k]*lu[nrcols_k_j];
-	nrcols_k_j+=nrcols;
+#ifdef DL_LAPACK
+  // LAPACK works on column major matrices, so it decomposes the
+  // transpose, which lubksb() takes into account:
+  int info;
+  DL_GETRF(&nrcols,&nrcols,lu,&nrcols,indx,&info);
+  for (j=0;j<nrcols;j++) {
+    if (fabs(lu[j*(nrcols+1)])<DL_TINY) return j;
+    if (indx[j]!=j+1) d=-d;
+  }
+#else
+  for (kb=0;kb<nrcols;kb+=DL_LUBLOCK) {
+    nb=min(DL_LUBLOCK,nrcols-kb);
+    // decompose the columns kb..kb+nb-1:
+    for (j=kb;j<kb+nb;j++) {
+      big=0.0; imax=j;
+      for (i=j;i<nrcols;i++)
+	if ((temp=fabs(lu[i*nrcols+j]))>big) { big=temp; imax=i; }
+      if (big<DL_TINY) return j;
+      indx[j]=imax;
+      if (imax!=j) {
+	DL_Scalar *ri=lu+imax*nrcols, *rj=lu+j*nrcols;
+	for (k=0;k<nrcols;k++) { temp=ri[k]; ri[k]=rj[k]; rj[k]=temp; }
+	d=-d;
       }
-      lu[nrcols_i+j]=sum;
-      nrcols_i+=nrcols;
-    }      
-    if (fabs(lu[nrcols_j_j]) < TINY) return j;
-    dum=1.0/lu[nrcols_j_j];
-    for (i=j+1;i<nrcols;i++) {
-      int nrcols_k_j=j;
-      sum=a[nrcols_i+j];
-      for (k=0;k<j;k++) {
-	sum-=lu[nrcols_i+k]*lu[nrcols_k_j];
-	nrcols_k_j+=nrcols;
+      DL_Scalar *rj=lu+j*nrcols;
+      dum=1.0/rj[j];
+      for (i=j+1;i<nrcols;i++) {
+	DL_Scalar *ri=lu+i*nrcols;
+	ri[j]*=dum;
+	DL_plus_times(kb+nb-j-1,-ri[j],rj+j+1,ri+j+1);
       }
-      lu[nrcols_i+j]=sum*dum;
-      nrcols_i+=nrcols;
     }
-    nrcols_j_j+=nrcols+1;
+    if (kb+nb==nrcols) break;
+    // the rows of U to the right of the block:
+    for (j=kb+1;j<kb+nb;j++) {
+      DL_Scalar *rj=lu+j*nrcols;
+      for (k=kb;k<j;k++)
+	DL_plus_times(nrcols-kb-nb,-rj[k],lu+k*nrcols+kb+nb,rj+kb+nb);
+    }
+    // and update the rest of the matrix with the product of the block's
+    // columns of L and rows of U:
+    for (i=kb+nb;i<nrcols;i++) {
+      DL_Scalar *ri=lu+i*nrcols;
+      for (k=kb;k<kb+nb;k++)
+	DL_plus_times(nrcols-kb-nb,-ri[k],lu+k*nrcols+kb+nb,ri+kb+nb);
+    }
   }
+#endif
   rep=lud;
   return -1;
 }
@@ -444,7 +517,7 @@ int DL_largematrix::ludcmpbw(){
       lu[nrcols_i+j]=sum;
       nrcols_i+=nrcols;
     }      
-    if (fabs(lu[nrcols_j_j]) < TINY) return j;
+    if (fabs(lu[nrcols_j_j]) < DL_TINY) return j;
     dum=1.0/lu[nrcols_j_j];
     ub=min(nrcols,j+bandw+1);
     for (i=j+1;i<ub;i++) {
@@ -463,20 +536,31 @@ int DL_largematrix::ludcmpbw(){
   return -1;
 }
 
-#undef TINY
 
 void DL_largematrix::lubksb(DL_largevector *x, DL_largevector *b){
 // Using the LU decomposition stored in this matrix, solves x from
 // self x=b.
 
-// PRE: nrrows==nrcols==b->dim && rep==ludb
+// PRE: nrrows==nrcols==b->dim && rep==lud
 
-  DL_Scalar sum;
-  int i,j,nrcols_i=nrcols; // INV: nrcols_i == nrcols*i
+  int i, j;
+  DL_Scalar sum, temp;
+
+  for (i=0;i<nrcols;i++) x->set(i,b->get(i));
+#ifdef DL_LAPACK
+  int info, one=1;
+  DL_GETRS("T",&nrcols,&one,lu,&nrcols,indx,x->v,&nrcols,&info);
+#else
+  for (i=0;i<nrcols;i++) {
+    j=indx[i];
+    if (j!=i) {
+      temp=x->get(i); x->set(i,x->get(j)); x->set(j,temp);
+    }
+  }
 
-  x->set(0,b->get(0));
+  int nrcols_i=nrcols; // INV: nrcols_i == nrcols*i
   for(i=1;i<nrcols;i++) {
-    sum=b->get(i);
+    sum=x->get(i);
     for(j=0;j<i;j++) sum-=lu[nrcols_i+j]*x->get(j);
     x->set(i,sum);
     nrcols_i+=nrcols;
@@ -486,8 +570,9 @@ void DL_largematrix::lubksb(DL_largevector *x, DL_largevector *b){
     nrcols_i-=nrcols;
     sum=x->get(i);
     for(j=i+1;j<nrcols;j++) sum-=lu[nrcols_i+j]*x->get(j);
-    x->set(i,((DL_Scalar)sum)/lu[nrcols_i+i]);
+    x->set(i,sum/lu[nrcols_i+i]);
   }
+#endif
 }
 
 void DL_largematrix::lubksbbw(DL_largevector *x, DL_largevector *b){
@@ -519,11 +604,183 @@ void DL_largematrix::lubksbbw(DL_largevector *x, DL_largevector *b){
   
 #endif //def PIVOT
 
+int DL_largematrix::ludcmpf(){
+// Calculates the LU-decomposion of the matrix in single precision
+// (without pivoting). The lower and upper matrices are stored in luf,
+// which is meant to be used by refine(), which recovers the accuracy
+// of the double precision solution.
+
+// If the decomposition went ok, a negative integer is returned.
+// Otherwise the index of the offending row is returned (this includes
+// pivots that are small compared to the single precision accuracy)
+
+// PRE: nrrows==nrcols && rep==full
+
+  int i, j, k, lb, ub;
+  int bw=(((bandw<0) || (2*bandw>nrrows)) ? nrcols : bandw);
+  float sum,dum;
+
+  // the infinity norm, which also tells if the matrix fits in a float:
+  anorm=0.0;
+  int nrcols_i=0;   // INV: nrcols_i==nrcols*i
+  for (i=0;i<nrrows;i++) {
+    sum=0.0;
+    lb=max(0,i-bw);
+    ub=min(nrcols,i+bw+1);
+    for (j=lb;j<ub;j++) sum+=fabs(DL_value(a[nrcols_i+j]));
+    if (sum>anorm) anorm=sum;
+    nrcols_i+=nrcols;
+  }
+  if (anorm>FLT_MAX) return 0;
+  float tiny=FLT_EPSILON*DL_value(anorm);
+
+  if (!luf) luf=new float[nrelem];
+  for(i=0;i<nrelem;i++) luf[i]=0.0;
+
+  int nrcols_j_j=0; // INV: nrcols_j_j==nrcols*j+j
+  for(j=0;j<nrcols;j++) {
+    lb=max(0,j-bw);
+    nrcols_i=lb*nrcols;
+    for(i=lb;i<=j;i++) {
+      int nrcols_k_j=lb*nrcols+j;   // INV: nrcols_k_j==nrcols*k+j
+      sum=(float)DL_value(a[nrcols_i+j]);
+      for(k=lb;k<i;k++) {
+	sum-=luf[nrcols_i+k]*luf[nrcols_k_j];
+	nrcols_k_j+=nrcols;
+      }
+      luf[nrcols_i+j]=sum;
+      nrcols_i+=nrcols;
+    }      
+    if (!(fabs(luf[nrcols_j_j]) >= tiny)) return j;
+    dum=1.0f/luf[nrcols_j_j];
+    ub=min(nrcols,j+bw+1);
+    for (i=j+1;i<ub;i++) {
+      int nrcols_k_j=lb*nrcols+j;
+      sum=(float)DL_value(a[nrcols_i+j]);
+      for (k=lb;k<j;k++) {
+	sum-=luf[nrcols_i+k]*luf[nrcols_k_j];
+	nrcols_k_j+=nrcols;
+      }
+      luf[nrcols_i+j]=sum*dum;
+      nrcols_i+=nrcols;
+    }
+    nrcols_j_j+=nrcols+1;
+  }
+  rep=(bw<nrcols ? ludb : lud);
+  return -1;
+}
+
+void DL_largematrix::lubksbf(DL_largevector *x, DL_largevector *b){
+// Using the single precision LU decomposition stored in this matrix,
+// solves x from self x=b (the substitutions themselves are done in
+// DL_Scalar precision).
+
+// PRE: nrrows==nrcols==b->dim && (rep==lud || rep==ludb) && lumixed
+
+  int i, j, ub;
+  int bw=(rep==ludb ? bandw : nrcols);
+  DL_Scalar sum;
+
+  int nrcols_i=0; // INV: nrcols_i == nrcols*i
+
+  for(i=0;i<nrcols;i++) {
+    sum=b->get(i);
+    for(j=max(0,i-bw);j<i;j++) sum-=luf[nrcols_i+j]*x->get(j);
+    x->set(i,sum);
+    nrcols_i+=nrcols;
+  }
+  
+  for (i=nrcols-1;i>=0;i--) {
+    nrcols_i-=nrcols;
+    sum=x->get(i);
+    ub=min(nrcols,i+bw+1);
+    for(j=i+1;j<ub;j++) sum-=luf[nrcols_i+j]*x->get(j);
+    x->set(i,sum/luf[nrcols_i+i]);
+  }
+}
+
+#define MAXREFINE 10
+boolean DL_largematrix::refine(DL_largevector *x, DL_largevector *b){
+// Solves x from self x=b using the single precision LU decomposition,
+// followed by iterative refinement with the residual b-self x
+// calculated in DL_Scalar precision, until the residual is as small as
+// that of a DL_Scalar precision decomposition would be.
+// Returns if this succeeded, FALSE if the refinement stalled (in which
+// case x is undefined).
+
+// PRE: nrrows==nrcols==b->dim && (rep==lud || rep==ludb) && lumixed
+
+  static DL_largevector r, dx;
+  int i, j, lb, ub, iter;
+  int bw=(rep==ludb ? bandw : nrcols);
+  DL_Scalar sum, rnrm, xnrm, prevrnrm=0.0;
+  DL_Scalar tol=anorm*DL_SCALAR_EPSILON*sqrt((DL_Scalar)nrcols);
+
+  r.resize(nrrows);
+  dx.resize(nrrows);
+  lubksbf(x,b);
+  for (iter=0;iter<MAXREFINE;iter++) {
+    // r:=b-self x (the infinity norms of r and x are used for the test)
+    rnrm=xnrm=0.0;
+    int nrcols_i=0; // INV: nrcols_i == nrcols*i
+    for (i=0;i<nrrows;i++) {
+      sum=b->get(i);
+      lb=max(0,i-bw);
+      ub=min(nrcols,i+bw+1);
+      for (j=lb;j<ub;j++) sum-=a[nrcols_i+j]*x->get(j);
+      r.set(i,sum);
+      if (fabs(sum)>rnrm) rnrm=fabs(sum);
+      if (fabs(x->get(i))>xnrm) xnrm=fabs(x->get(i));
+      nrcols_i+=nrcols;
+    }
+    if (rnrm<=tol*xnrm) return TRUE;
+    // the residual should at least halve each step:
+    if (NaN(rnrm) || ((iter>0) && (rnrm>0.5*prevrnrm))) return FALSE;
+    prevrnrm=rnrm;
+    lubksbf(&dx,&r);
+    x->plusis(&dx);
+  }
+  return FALSE;
+}
+#undef MAXREFINE
+
+void DL_largematrix::timesblocked(DL_largematrix *lm, DL_largematrix *nlm) {
+// the matrix product for larger matrices (see times()): nlm:=self lm.
+// Blocks of rows of nlm are accumulated from blocks of lm's rows, so
+// the blocks involved stay in the cache. Each element still gets the
+// same products added in the same order as in the straightforward
+// product.
+//PRE: see times() && nlm!=self && nlm!=lm
+#ifdef DL_LAPACK
+  // column major BLAS: nlm^T:=lm^T self^T
+  DL_Scalar one=1.0, zero=0.0;
+  DL_GEMM("N","N",&(lm->nrcols),&nrrows,&nrcols,&one,lm->a,&(lm->nrcols),
+	  a,&nrcols,&zero,nlm->a,&(nlm->nrcols));
+#else
+  int ib,kb,jb,i,k,iub,kub,jn;
+  for (i=0;i<nlm->nrelem;i++) nlm->a[i]=0.0;
+  for (ib=0;ib<nrrows;ib+=DL_GEMMBLOCK) {
+    iub=min(nrrows,ib+DL_GEMMBLOCK);
+    for (kb=0;kb<nrcols;kb+=DL_GEMMBLOCK) {
+      kub=min(nrcols,kb+DL_GEMMBLOCK);
+      for (jb=0;jb<lm->nrcols;jb+=4*DL_GEMMBLOCK) {
+	jn=min(lm->nrcols-jb,4*DL_GEMMBLOCK);
+	for (i=ib;i<iub;i++) {
+	  DL_Scalar *ai=a+i*nrcols, *ci=nlm->a+i*nlm->nrcols+jb;
+	  for (k=kb;k<kub;k++)
+	    DL_plus_times(jn,ai[k],lm->a+k*lm->nrcols+jb,ci);
+	}
+      }
+    }
+  }
+#endif
+}
+
 DL_Scalar DL_largematrix::det() {
 // Calculates the determinant of the matrix using the LU decomposition.
 //PRE: nrcols=nrrows
   DL_Scalar det=d;
-  if ((rep!=lud) && (rep!=ludb)) {
+  if (((rep!=lud) && (rep!=ludb)) || lumixed) {
     representation org_rep=rep;
     ludcmp();
     rep=org_rep;
@@ -560,9 +817,9 @@ boolean DL_largematrix::conjug_gradient(DL_largevector *x, DL_largevector *b){
     ++iter;
     asolve(&rr,&zz);
     bknum=z.inprod(&rr);
-    if (iter==1) {
-      p.assign(&z);
-      pp.assign(&zz);
+    if (iter==1) { // z and zz are overwritten below, so no need to copy
+      p.swap(&z);
+      pp.swap(&zz);
     }
     else {
       bk=bknum/bkden;
@@ -589,24 +846,25 @@ boolean DL_largematrix::conjug_gradient(DL_largevector *x, DL_largevector *b){
   return (r.norm()>bnrm);
 }
 
-static DL_Scalar at,bt,ct;
-#define PYTHAG(a,b) ((at=fabs(a)) > (bt=fabs(b)) ? \
-(ct=bt/at,at*sqrt(1.0+ct*ct)) : (bt ? (ct=at/bt,bt*sqrt(1.0+ct*ct)): 0.0))
-
-#define SIGN(a,b) ((b) >= 0.0 ? fabs(a) : -fabs(a))
+#define MAXSWEEPS 30
 int DL_largematrix::svdcmp(){
 // calculates an singular value decompisition of this matrix:
 // A=U w V^T
-// where U is nrrows x nrcols and has orthonormal columns (stored in a)
+// where U is nrrows x nrcols and has orthonormal columns (stored in u)
 // where w is nrcols x nrcols diagonal with the singular values
 // where V is nrcols x nrcols and has orthonormal columns
+// The singular values are sorted in decreasing order.
+// This uses one-sided Jacobi rotations: pairs of columns of A are
+// rotated until they are all orthogonal (their norms are then the
+// singular values), applying the same rotations to V. Each step
+// handles nrcols/2 disjoint pairs (in round-robin order, so every
+// pair is handled once per sweep), which are independent, so they can
+// be done in parallel (if compiled with OpenMP).
 // pre: nrrows>=nrcols && rep==full
 // returns te number of singular values after postprocessing w to
 // nullify too small elements in w
-  int flag,i,its,j,jj,k,l,nm;
-  DL_Scalar c,f,h,s,x,y,z;
-  DL_Scalar anorm=0.0,g=0.0,scale=0.0;
-  DL_Scalar *rv1;
+  int i,j,k,m,sweep,step,rotated;
+  DL_Scalar anrm2=0.0, colnrm2;
 
   if (nrrows < nrcols) {
     DL_dsystem->get_companion()->Msg("Error: DL_largematrix::svdcmp: more columns than rows!\n");
@@ -617,302 +875,134 @@ int DL_largematrix::svdcmp(){
   if (!u) u=new DL_Scalar[nrelem];
   if (!w) w=new DL_Scalar[nrcols];
   if (!v) v=new DL_Scalar[nrcols*nrcols];
-  rv1=new DL_Scalar[nrcols];
 
-  for (i=0;i<nrelem;i++) u[i]=a[i];
-  for (i=0;i<nrcols;i++) {
-    l=i+1;
-    rv1[i]=scale*g;
-    g=s=scale=0.0;
-    if (i < nrrows) {
-      register int k_nrcols_i=i*(nrcols+1);
-      for (k=i;k<nrrows;k++) {
-	scale += fabs(u[k_nrcols_i]);
-	k_nrcols_i+=nrcols;
-      }
-      if (scale) {
-	k_nrcols_i=i*(nrcols+1);
-	for (k=i;k<nrrows;k++) {
-	  u[k_nrcols_i] /= scale;
-	  s += u[k_nrcols_i]*u[k_nrcols_i];
-	  k_nrcols_i+=nrcols;
-	}
-	f=u[i*nrcols+i];
-	g = -SIGN(sqrt(s),f);
-	h=f*g-s;
-	u[i*nrcols+i]=f-g;
-	if (i != nrcols-1) {
-	  register int j_i=1; // j_i==j-i;
-	  for (j=l;j<nrcols;j++) {
-	    k_nrcols_i=i*(nrcols+1);
-	    for (s=0.0,k=i;k<nrrows;k++) {
-	      s += u[k_nrcols_i]*u[k_nrcols_i+j_i];
-	      k_nrcols_i+=nrcols;
-	    }
-	    f=s/h;
-	    k_nrcols_i=i*(nrcols+1);
-	    for (k=i;k<nrrows;k++) {
-	      u[k_nrcols_i+j_i] += f*u[k_nrcols_i];
-	      k_nrcols_i+=nrcols;
-	    }
-	    j_i++;
-	  }
-	}
-	k_nrcols_i=i*(nrcols+1);
-	for (k=i;k<nrrows;k++) {
-	  u[k_nrcols_i] *= scale;
-	  k_nrcols_i+=nrcols;
-	}
+  // work on the transposes, so the columns of U and V are contiguous:
+  DL_Scalar *ut=new DL_Scalar[nrelem];
+  DL_Scalar *vt=new DL_Scalar[nrcols*nrcols];
+  for (i=0;i<nrrows;i++)
+    for (j=0;j<nrcols;j++) ut[j*nrrows+i]=a[i*nrcols+j];
+  for (i=0;i<nrcols*nrcols;i++) vt[i]=0.0;
+  for (i=0;i<nrcols;i++) vt[i*(nrcols+1)]=1.0;
+  // the squared column norms (kept up to date during a sweep):
+  DL_Scalar *n2=new DL_Scalar[nrcols];
+  for (j=0;j<nrcols;j++) {
+    n2[j]=0.0;
+    for (i=0;i<nrrows;i++) n2[j]+=ut[j*nrrows+i]*ut[j*nrrows+i];
+    anrm2+=n2[j];
+  }
+  // columns smaller than this are zero up to the precision (they stem
+  // from redundant constraints) and are not rotated any further:
+  colnrm2=DL_SCALAR_EPSILON*DL_SCALAR_EPSILON*anrm2;
+
+  m=nrcols+(nrcols&1); // the round-robin schedule needs an even number
+  for (sweep=0,rotated=1;rotated && (sweep<MAXSWEEPS);sweep++) {
+    rotated=0;
+    if (sweep>0) { // recalculate the norms to avoid drift
+      for (j=0;j<nrcols;j++) {
+	n2[j]=0.0;
+	for (i=0;i<nrrows;i++) n2[j]+=ut[j*nrrows+i]*ut[j*nrrows+i];
       }
     }
-    w[i]=scale*g;
-    g=s=scale=0.0;
-    if ((i < nrrows) && (l != nrcols)) {
-      register int i_nrcols=i*nrcols;
-      for (k=l;k<nrcols;k++) scale += fabs(u[i_nrcols+k]);
-      if (scale) {
-	for (k=l;k<nrcols;k++) {
-	  u[i_nrcols+k] /= scale;
-	  s += u[i_nrcols+k]*u[i_nrcols+k];
+    for (step=0;step<m-1;step++) {
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:rotated) schedule(static) if (nrelem>10000)
+#endif
+      for (k=0;k<m/2;k++) {
+	int p=(k==0 ? m-1 : (step+k)%(m-1)), q=(step-k+m-1)%(m-1), r;
+	if ((p>=nrcols) || (q>=nrcols)) continue;
+	DL_Scalar *up=ut+p*nrrows, *uq=ut+q*nrrows;
+	DL_Scalar *vp=vt+p*nrcols, *vq=vt+q*nrcols;
+	DL_Scalar alpha=n2[p], beta=n2[q], gamma=0.0, zeta, t, c, s, x, y;
+	if ((alpha<=colnrm2) || (beta<=colnrm2)) continue;
+	for (r=0;r<nrrows;r++) gamma+=up[r]*uq[r];
+	// skip columns that are orthogonal up to the precision:
+	if (!(fabs(gamma)>DL_SCALAR_EPSILON*sqrt(alpha*beta))) continue;
+	rotated++;
+	zeta=(beta-alpha)/(2.0*gamma);
+	t=(zeta>=0.0 ? 1.0 : -1.0)/(fabs(zeta)+sqrt(1.0+zeta*zeta));
+	c=1.0/sqrt(1.0+t*t);
+	s=c*t;
+	n2[p]=alpha-t*gamma;
+	n2[q]=beta+t*gamma;
+	for (r=0;r<nrrows;r++) {
+	  x=up[r]; y=uq[r];
+	  up[r]=c*x-s*y;
+	  uq[r]=s*x+c*y;
 	}
-	f=u[i_nrcols+l];
-	g = -SIGN(sqrt(s),f);
-	h=f*g-s;
-	u[i_nrcols+l]=f-g;
-	for (k=l;k<nrcols;k++) rv1[k]=u[i_nrcols+k]/h;
-	if (l != nrrows) {
-	  register int j_nrcols=l*nrcols;
-	  for (j=l;j<nrrows;j++) {
-	    for (s=0.0,k=l;k<nrcols;k++) s += u[j_nrcols+k]*u[i_nrcols+k];
-	    for (k=l;k<nrcols;k++) u[j_nrcols+k] += s*rv1[k];
-	    j_nrcols+=nrcols;
-	  }
+	for (r=0;r<nrcols;r++) {
+	  x=vp[r]; y=vq[r];
+	  vp[r]=c*x-s*y;
+	  vq[r]=s*x+c*y;
 	}
-	for (k=l;k<nrcols;k++) u[i_nrcols+k] *= scale;
       }
     }
-    anorm=max(anorm,(fabs(w[i])+fabs(rv1[i])));
   }
-  register int i_nrcols=nrcols*nrcols;
-  for (i=nrcols-1;i>=0;i--) {
-    i_nrcols-=nrcols;
-    if (l < nrcols) {
-      if (g) {
-	register int j_nrcols_i=l*nrcols+i;
-	register int i_nrcols_l=i_nrcols+l;
-	register int j_l=0; // j_l==j-l;
-	for (j=l;j<nrcols;j++) {
-	  v[j_nrcols_i]=(u[i_nrcols_l+j_l]/u[i_nrcols_l])/g;
-	  j_nrcols_i+=nrcols;
-	  j_l++;
-	}
-	register int j_i=1;;
-	for (j=l;j<nrcols;j++) {
-	  register int k_nrcols_j=l*nrcols+j;
-	  for (s=0.0,k=l;k<nrcols;k++) {
-	    s += u[i_nrcols+k]*v[k_nrcols_j];
-	    k_nrcols_j+=nrcols;
-	  }
-	  register int k_nrcols_i=l*nrcols+i;
-	  for (k=l;k<nrcols;k++) {
-	    v[k_nrcols_i+j_i] += s*v[k_nrcols_i];
-	    k_nrcols_i+=nrcols;
-	  }
-	  j_i++;
-	}
-      }
-      register int j_nrcols_i=l*nrcols+i;
-      for (j=l;j<nrcols;j++) {
-	v[i_nrcols+j]=v[j_nrcols_i]=0.0;
-	j_nrcols_i+=nrcols;
-      }
-    }
-    v[i_nrcols+i]=1.0;
-    g=rv1[i];
-    l=i;
+  if (rotated)
+    DL_dsystem->get_companion()->Msg("Warning: DL_largematrix::svdcmp: no convergence in %d sweeps\n",MAXSWEEPS);
+
+  // the singular values are the norms of the columns; store them (and
+  // the normalised columns of U and V) in decreasing order:
+  int *order=new int[nrcols];
+  DL_Scalar *norms=new DL_Scalar[nrcols];
+  for (j=0;j<nrcols;j++) {
+    DL_Scalar n2=0.0;
+    for (i=0;i<nrrows;i++) n2+=ut[j*nrrows+i]*ut[j*nrrows+i];
+    norms[j]=sqrt(n2);
+    order[j]=j;
   }
-  i_nrcols=nrcols*nrcols;
-  for (i=nrcols-1;i>=0;i--) {
-    i_nrcols-=nrcols;
-    l=i+1;
-    g=w[i];
-    if (l < nrcols)
-      for (j=l;j<nrcols;j++) u[i_nrcols+j]=0.0;
-    if (g) {
-      g=1.0/g;
-      if (l != nrcols) {
-	register int j_i=1; // j_i==j-i;
-	for (j=l;j<nrcols;j++) {
-	  register int k_nrcols_i=l*nrcols+i;
-	  for (s=0.0,k=l;k<nrrows;k++) {
-	    s += u[k_nrcols_i]*u[k_nrcols_i+j_i];
-	    k_nrcols_i+=nrcols;
-	  }
-	  f=(s/u[i_nrcols+i])*g;
-	  k_nrcols_i=i_nrcols+i;
-	  for (k=i;k<nrrows;k++) {
-	    u[k_nrcols_i+j_i] += f*u[k_nrcols_i];
-	    k_nrcols_i+=nrcols;
-	  }
-	  j_i++;
-	}
-      }
-      register int j_nrcols_i=i_nrcols+i;
-      for (j=i;j<nrrows;j++) {
-	u[j_nrcols_i] *= g;
-	j_nrcols_i+=nrcols;
-      }
-    }
-    else {
-      register int j_nrcols_i=i_nrcols+i;
-      for (j=i;j<nrrows;j++) {
-	u[j_nrcols_i]=0.0;
-	j_nrcols_i+=nrcols;
-      }
-    }
-    ++u[i_nrcols+i];
+  for (j=1;j<nrcols;j++) { // insertion sort (stable)
+    int oj=order[j];
+    for (k=j;(k>0) && (norms[order[k-1]]<norms[oj]);k--) order[k]=order[k-1];
+    order[k]=oj;
   }
-  for (k=nrcols-1;k>=0;k--) {
-    for (its=1;its<=30;its++) {
-      flag=1;
-      for (l=k;l>0;l--) {
-	nm=l-1;
-	if (fabs(rv1[l])+anorm == anorm) {
-	  flag=0;
-	  break;
-	}
-	if (fabs(w[nm])+anorm == anorm) break;
-      }
-      if (flag) {
-	c=0.0;
-	s=1.0;
-	for (i=l;i<=k;i++) {
-	  f=s*rv1[i];
-	  if (fabs(f)+anorm != anorm) {
-	    g=w[i];
-	    h=PYTHAG(f,g);
-	    w[i]=h;
-	    h=1.0/h;
-	    c=g*h;
-	    s=(-f*h);
-	    register int j_nrcols=0;
-	    for (j=0;j<nrrows;j++) {
-	      y=u[j_nrcols+nm];
-	      z=u[j_nrcols+i];
-	      u[j_nrcols+nm]=y*c+z*s;
-	      u[j_nrcols+i]=z*c-y*s;
-	      j_nrcols+=nrcols;
-	    }
-	  }
-	}
-      }
-      z=w[k];
-      if (l == k) {
-	if (z < 0.0) {
-	  w[k] = -z;
-	  register int j_nrcols_k=k;
-	  for (j=0;j<nrcols;j++) {
-	    v[j_nrcols_k]=(-v[j_nrcols_k]);
-	    j_nrcols_k+=nrcols;
-	  }
-	}
-	break;
-      }
-      if (its == 30) {
-	DL_dsystem->get_companion()->Msg("Warning: DL_largematrix::svdcmp: no convergence in 30 iterations\n");
-      }
-      x=w[l];
-      nm=k-1;
-      y=w[nm];
-      g=rv1[nm];
-      h=rv1[k];
-      f=((y-z)*(y+z)+(g-h)*(g+h))/(2.0*h*y);
-      g=PYTHAG(f,1.0);
-      f=((x-z)*(x+z)+h*((y/(f+SIGN(g,f)))-h))/x;
-      c=s=1.0;
-      for (j=l;j<=nm;j++) {
-	i=j+1;
-	g=rv1[i];
-	y=w[i];
-	h=s*g;
-	g=c*g;
-	z=PYTHAG(f,h);
-	rv1[j]=z;
-	c=f/z;
-	s=h/z;
-	f=x*c+g*s;
-	g=g*c-x*s;
-	h=y*s;
-	y=y*c;
-	register int jj_nrcols=0;
-	for (jj=0;jj<nrcols;jj++) {
-	  x=v[jj_nrcols+j];
-	  z=v[jj_nrcols+i];
-	  v[jj_nrcols+j]=x*c+z*s;
-	  v[jj_nrcols+i]=z*c-x*s;
-	  jj_nrcols+=nrcols;
-	}
-	z=PYTHAG(f,h);
-	w[j]=z;
-	if (z) {
-	  z=1.0/z;
-	  c=f*z;
-	  s=h*z;
-	}
-	f=(c*g)+(s*y);
-	x=(c*y)-(s*g);
-	jj_nrcols=0;
-	for (jj=0;jj<nrrows;jj++) {
-	  y=u[jj_nrcols+j];
-	  z=u[jj_nrcols+i];
-	  u[jj_nrcols+j]=y*c+z*s;
-	  u[jj_nrcols+i]=z*c-y*s;
-	  jj_nrcols+=nrcols;
-	}
-      }
-      rv1[l]=0.0;
-      rv1[k]=f;
-      w[k]=x;
-    }
+  for (j=0;j<nrcols;j++) {
+    int oj=order[j];
+    DL_Scalar f=(norms[oj]>0.0 ? 1.0/norms[oj] : 0.0);
+    w[j]=norms[oj];
+    for (i=0;i<nrrows;i++) u[i*nrcols+j]=ut[oj*nrrows+i]*f;
+    for (i=0;i<nrcols;i++) v[i*nrcols+j]=vt[oj*nrcols+i];
   }
-  delete[] rv1;
-  // post process w:
-  DL_Scalar biggest=0.0;
-  for (i=0;i<nrelem;i+=nrcols+1) if (fabs(a[i])>biggest) biggest=fabs(a[i]);
-  // biggest is now the largest magnitude on A's diagonal
-#define TINY 1.0e-10
-  biggest*=TINY;
-#undef TINY
-  for (jj=0,i=0;i<nrcols;i++) if (fabs(w[i])<biggest) { w[i]=0.0; jj++; }
-if (jj>0) {
-  DL_dsystem->get_companion()->Msg("svdcomp: %d singularities\n", jj );
+  delete[] n2;
+  delete[] norms;
+  delete[] order;
+  delete[] vt;
+  delete[] ut;
+
+  // post process w: singular values that are tiny compared to the
+  // largest one stem from redundant constraints, and are nullified
+  // (so svbksb() leaves those directions out of the solution):
+  DL_Scalar tol=(nrcols ? w[0] : 0.0)*max(DL_TINY,nrcols*DL_SCALAR_EPSILON);
+  for (k=0,i=0;i<nrcols;i++) if (!(w[i]>tol)) { w[i]=0.0; k++; }
+if (k>0) {
+  DL_dsystem->get_companion()->Msg("svdcomp: %d singularities\n", k );
 }
-  return jj;
+  return k;
 }
-#undef SIGN
-#undef PYTHAG
+#undef MAXSWEEPS
 
 void DL_largematrix::svbksb(DL_largevector *x, DL_largevector *b){
-// solves x from Ax=b using the sv decomposition stored in this matrix
+// solves x from Ax=b using the sv decomposition stored in this matrix,
+// in the least squares sense if A is singular: only the rank (the
+// number of nonzero singular values, which come first) columns of U
+// and V are used
 // pre: rep==svdmpd
-  int i,j;
-  DL_Scalar s, *tmp;
-
-  tmp=new DL_Scalar[nrcols];
-  for (j=0;j<nrcols;j++) {
-    s=0.0;
-    if (w[j]) {
-      for (i=0;i<nrcols;i++) s+=u[i*nrcols+j]*b->get(i);
-      s/=w[j];
-    }
-    tmp[j]=s;
+  int i,j,rank;
+  DL_Scalar *ui;
+
+  for (rank=0;(rank<nrcols) && (w[rank]!=0.0);rank++);
+  DL_largevector tmp(rank); // U^T b, then divided by w
+  tmp.makezero();
+  for (i=0;i<nrrows;i++) {
+    ui=u+i*nrcols;
+    DL_plus_times(rank,b->get(i),ui,tmp.v);
   }
+  for (j=0;j<rank;j++) tmp.v[j]/=w[j];
   for (j=0;j<nrcols;j++) {
-    s=0.0;
-    for (i=0;i<nrcols;i++) s+=v[j*nrcols+i]*tmp[i];
+    DL_Scalar s=0.0;
+    ui=v+j*nrcols;
+    for (i=0;i<rank;i++) s+=ui[i]*tmp.v[i];
     x->set(j,s);
   }
-  delete[] tmp;
 }
 
 void DL_largematrix::show(){
@@ -920,7 +1010,7 @@ void DL_largematrix::show(){
   char s[80],t[160]="";
   for (r=0;r<nrrows;r++) {
     for (c=0;c<nrcols;c++) {
-      sprintf(s, " %f", a[nrcols*r+c]);
+      sprintf(s, " %f", DL_value(a[nrcols*r+c]));
       strcat(t,s);
     }
     strcat(t,"\n");
@@ -946,7 +1036,7 @@ void DL_largematrix::show_all(){
     sprintf(t, "bandw: %d\nlu:\n", bandw );
     for (r=0;r<nrrows;r++) {
       for (c=0;c<nrcols;c++) {
-	sprintf(s, " %f", lu[nrcols*r+c]);
+	sprintf(s, " %f", DL_value(lu[nrcols*r+c]));
 	strcat(t,s);
       }
       strcat(t,"\n");
@@ -973,6 +1063,14 @@ void DL_largematrix::set_min_solve_method(solve_method _sm){
   set_solve_method(min_sm);
 }
 
+void DL_largematrix::set_mixed_precision(boolean m){
+// when solving with LU decomposition, decompose in single precision
+// and use iterative refinement to get the DL_Scalar precision solution
+// (if the refinement stalls, the DL_Scalar precision decomposition is
+// used until the matrix is resized)
+  mixed=m;
+}
+
 void DL_largematrix::set_solve_method(solve_method _sm){
   if (nrcols!=nrrows) {
     DL_dsystem->get_companion()->Msg("Warning: DL_largematrix::set_solve_method():\n Can only solve square systems, and this matrix is not square!!!\n");
@@ -1017,6 +1115,15 @@ boolean DL_largematrix::prep_for_solve(){
 // returns if there were any singularities
   switch (sm) {
   case lud_bcksub:
+    lumixed=FALSE;
+    if (mixed && !mixedstalled && (sizeof(DL_Scalar)>sizeof(float))) {
+      if (ludcmpf()<0) {
+	lumixed=TRUE;
+	return FALSE;
+      }
+      // the single precision decomposition failed: use DL_Scalars
+      rep=full;
+    }
     if ((2*bandw>nrrows?ludcmp():ludcmpbw())>=0) {
       // ((near) singular value detected)
       set_solve_method(conjug_grad);
@@ -1049,8 +1156,21 @@ boolean DL_largematrix::solve(DL_largevector *x, DL_largevector *b){
       return TRUE;
     }
     return FALSE;
-  case lud: lubksb(x,b); return FALSE;
-  case ludb: lubksbbw(x,b); return FALSE;
+  case lud:
+  case ludb:
+    if (lumixed) {
+      if (refine(x,b)) return FALSE;
+      // refinement stalled: fall back to the DL_Scalar precision
+      // decomposition (prep_for_solve() may switch to conjugate gradient)
+      mixedstalled=TRUE;
+      rep=full;
+      prep_for_solve();
+      solve(x,b);
+      return (sm!=lud_bcksub);
+    }
+    if (rep==lud) lubksb(x,b);
+    else lubksbbw(x,b);
+    return FALSE;
   case svdcmpd: svbksb(x,b); return FALSE;
   }
   return FALSE;
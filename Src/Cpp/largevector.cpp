@@ -40,7 +40,7 @@ void DL_largevector::show(void){
   register int i;
   char s[80],t[80]="";
   for (i=0;i<dim;i++) {
-    sprintf(s," %f", v[i]);
+    sprintf(s," %f", DL_value(v[i]));
     strcat(t,s);
   }
   DL_dsystem->get_companion()->Msg("%s\n",t);
@@ -32,13 +32,13 @@
 
 #include "dyna_system.h"
 #include "linehinge.h"
+#include "snapshot.h"
 
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
-DL_linehinge::DL_linehinge():DL_constraint(),
-  dcdp0(3,3),dcdp1(2,3),df0dR(3,3),df1dR(3,2) {
+DL_linehinge::DL_linehinge():DL_constraint() {
   dim=5;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -104,7 +104,7 @@ void DL_linehinge::init(DL_dyna* _d, DL_point* _pd0, DL_point *_pd1,
   get_error(&lv);
   if (lv.norm()>DL_constraints->max_error) {
     DL_dsystem->get_companion()->Msg("Warning: initially invalid linehinge-constraint\n Error: (%f,%f,%f,%f,%f)\n",
-				  lv.get(0), lv.get(1), lv.get(2), lv.get(3), lv.get(4) );
+				  DL_value(lv.get(0)), DL_value(lv.get(1)), DL_value(lv.get(2)), DL_value(lv.get(3)), DL_value(lv.get(4)) );
   }
 }
 
@@ -154,64 +154,55 @@ void DL_linehinge::end_test(void) {
   if (g_is_dyna) ((DL_dyna*)g)->endtest();
 }
 
-boolean DL_linehinge::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_linehinge::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf;
-  static DL_largematrix tmp;
-  static DL_largematrix subtemp;
-  dcdf.resize(cc->dim,3);
+  DL_jacblock dcdf;
+  DL_fixmat<DL_MAXCDIM,3> tmp;
+  DL_subblock subtemp;
   boolean nonzero;
   if (nonzero=cc->dCdFq(d,&pd0,&dcdf)) {
-    tmp.resize(cc->dim,3);
-    dcdf.times(&df0dR,&tmp);
-    sub->setsubmatrix(0,0,&tmp);
-    tmp.resize(cc->dim,2);
+    dcdf.times(&df0dR,&tmp,cc->dim);
+    sub->setsubmatrix(0,0,&tmp,cc->dim,3);
     cc->dCdFq(d,&pd1,&dcdf);
-    dcdf.times(&df1dR,&tmp);
-    sub->setsubmatrix(0,3,&tmp);
+    dcdf.times(&df1dR,&tmp,cc->dim);
+    sub->setsubmatrix(0,3,&tmp,cc->dim,2);
   }
   if (g_is_dyna) {
    if (nonzero) {
     if (cc->dCdFq((DL_dyna*)g,&pg0,&dcdf)) {
-      subtemp.resize(cc->dim,dim);
-      tmp.resize(cc->dim,3);
-      dcdf.times(&df0dR,&tmp);
-      subtemp.setsubmatrix(0,0,&tmp);
-      tmp.resize(cc->dim,2);
+      dcdf.times(&df0dR,&tmp,cc->dim);
+      subtemp.setsubmatrix(0,0,&tmp,cc->dim,3);
       cc->dCdFq((DL_dyna*)g,&pg1,&dcdf);
-      dcdf.times(&df1dR,&tmp);
-      subtemp.setsubmatrix(0,3,&tmp);
-      sub->minusis(&subtemp);
+      dcdf.times(&df1dR,&tmp,cc->dim);
+      subtemp.setsubmatrix(0,3,&tmp,cc->dim,2);
+      sub->minusis(&subtemp,cc->dim,dim);
     }
    }
    else {
     if (nonzero=cc->dCdFq((DL_dyna*)g,&pg0,&dcdf)) {
-      tmp.resize(cc->dim,3);
-      dcdf.times(&df0dR,&tmp);
-      sub->setsubmatrix(0,0,&tmp);
-      tmp.resize(cc->dim,2);
+      dcdf.times(&df0dR,&tmp,cc->dim);
+      sub->setsubmatrix(0,0,&tmp,cc->dim,3);
       cc->dCdFq((DL_dyna*)g,&pg1,&dcdf);
-      dcdf.times(&df1dR,&tmp);
-      sub->setsubmatrix(0,3,&tmp);
-      sub->neg();
+      dcdf.times(&df1dR,&tmp,cc->dim);
+      sub->setsubmatrix(0,3,&tmp,cc->dim,2);
+      sub->neg(cc->dim,dim);
     }
    }
   }
   return nonzero;
 }
 
-boolean DL_linehinge::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_linehinge::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dpdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
-  static DL_largematrix dcIdf(3,3);
+  DL_fixmat<2,3> dcIdf;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -221,10 +212,7 @@ boolean DL_linehinge::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(3,3);
-    dcdp0.times(&dpdf,&dcIdf);
-    dcdfq->setsubmatrix(0,0,&dcIdf);
+    dcdp0.times(&dpdX,dcdfq);
     
     dc->dpdfq(&pd1,pc,&dpdX);
     if (veloterms) {
@@ -232,9 +220,7 @@ boolean DL_linehinge::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(2,3);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdfq->setsubmatrix(3,0,&dcIdf);
     
     return TRUE;
@@ -246,10 +232,7 @@ boolean DL_linehinge::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(3,3);
-    dcdp0.times(&dpdf,&dcIdf);
-    dcdfq->setsubmatrix(0,0,&dcIdf);
+    dcdp0.times(&dpdX,dcdfq);
     
     dc->dpdfq(&pg1,pc,&dpdX);
     if (veloterms) {
@@ -257,24 +240,21 @@ boolean DL_linehinge::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(2,3);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdfq->setsubmatrix(3,0,&dcIdf);
     
-    dcdfq->neg();    
+    dcdfq->neg(dim);    
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_linehinge::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_linehinge::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
-  static DL_largematrix dcIdf(3,3);
+  DL_fixmat<2,3> dcIdf;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -284,10 +264,7 @@ boolean DL_linehinge::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(3,3);
-    dcdp0.times(&dpdf,&dcIdf);
-    dcdf->setsubmatrix(0,0,&dcIdf);
+    dcdp0.times(&dpdX,dcdf);
     
     dc->dpdF(&pd1,&dpdX);
     if (veloterms) {
@@ -295,9 +272,7 @@ boolean DL_linehinge::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(2,3);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdf->setsubmatrix(3,0,&dcIdf);
     
     return TRUE;
@@ -309,10 +284,7 @@ boolean DL_linehinge::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(3,3);
-    dcdp0.times(&dpdf,&dcIdf);
-    dcdf->setsubmatrix(0,0,&dcIdf);
+    dcdp0.times(&dpdX,dcdf);
     
     dc->dpdF(&pg1,&dpdX);
     if (veloterms) {
@@ -320,25 +292,22 @@ boolean DL_linehinge::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(2,3);
-    dcdp1.times(&dpdf,&dcIdf);
+    dcdp1.times(&dpdX,&dcIdf);
     dcdf->setsubmatrix(3,0,&dcIdf);
     
-    dcdf->neg();    
+    dcdf->neg(dim);    
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_linehinge::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_linehinge::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dpdm(3,3);
-  static DL_largematrix dcIdm(3,3);
+  DL_fixmat<2,3> dcIdm;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -348,10 +317,7 @@ boolean DL_linehinge::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcIdm.resize(3,3);
-    dcdp0.times(&dpdm,&dcIdm);
-    dcdm->setsubmatrix(0,0,&dcIdm);
+    dcdp0.times(&dpdX,dcdm);
     
     dc->dpdM(&pd1,&dpdX);
     if (veloterms) {
@@ -359,9 +325,7 @@ boolean DL_linehinge::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcIdm.resize(2,3);
-    dcdp1.times(&dpdm,&dcIdm);
+    dcdp1.times(&dpdX,&dcIdm);
     dcdm->setsubmatrix(3,0,&dcIdm);
     
     return TRUE;
@@ -373,10 +337,7 @@ boolean DL_linehinge::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcIdm.resize(3,3);
-    dcdp0.times(&dpdm,&dcIdm);
-    dcdm->setsubmatrix(0,0,&dcIdm);
+    dcdp0.times(&dpdX,dcdm);
     
     dc->dpdM(&pg1,&dpdX);
     if (veloterms) {
@@ -384,25 +345,22 @@ boolean DL_linehinge::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcIdm.resize(2,3);
-    dcdp1.times(&dpdm,&dcIdm);
+    dcdp1.times(&dpdX,&dcIdm);
     dcdm->setsubmatrix(3,0,&dcIdm);
     
-    dcdm->neg();    
+    dcdm->neg(dim);    
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_linehinge::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_linehinge::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dpdi(3,3);
-  static DL_largematrix dcIdi(3,3);
+  DL_fixmat<2,3> dcIdi;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -412,10 +370,7 @@ boolean DL_linehinge::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcIdi.resize(3,3);
-    dcdp0.times(&dpdi,&dcIdi);
-    dcdi->setsubmatrix(0,0,&dcIdi);
+    dcdp0.times(&dpdX,dcdi);
     
     dc->dpdi(&pd1,pc,&dpdX);
     if (veloterms) {
@@ -423,9 +378,7 @@ boolean DL_linehinge::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcIdi.resize(2,3);
-    dcdp1.times(&dpdi,&dcIdi);
+    dcdp1.times(&dpdX,&dcIdi);
     dcdi->setsubmatrix(3,0,&dcIdi);
     
     return TRUE;
@@ -437,10 +390,7 @@ boolean DL_linehinge::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcIdi.resize(3,3);
-    dcdp0.times(&dpdi,&dcIdi);
-    dcdi->setsubmatrix(0,0,&dcIdi);
+    dcdp0.times(&dpdX,dcdi);
     
     dc->dpdi(&pg1,pc,&dpdX);
     if (veloterms) {
@@ -448,12 +398,10 @@ boolean DL_linehinge::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcIdi.resize(2,3);
-    dcdp1.times(&dpdi,&dcIdi);
+    dcdp1.times(&dpdX,&dcIdi);
     dcdi->setsubmatrix(3,0,&dcIdi);
     
-    dcdi->neg();    
+    dcdi->neg(dim);    
     return TRUE;
   }
   return FALSE;
@@ -640,3 +588,14 @@ void DL_linehinge::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_linehinge::save_state(DL_snapshot *snap) {
+  DL_constraint::save_state(snap);
+  // the local coordinate system, which is rotated along with l each frame:
+  snap->put(&l); snap->put(&x); snap->put(&y);
+}
+
+void DL_linehinge::restore_state(DL_snapshot *snap) {
+  DL_constraint::restore_state(snap);
+  snap->get(&l); snap->get(&x); snap->get(&y);
+}
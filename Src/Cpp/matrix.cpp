@@ -157,59 +157,12 @@ void DL_matrix::timesis(DL_Scalar fac) {
   c2.timesis(fac);
 }
 
-void DL_matrix::times(DL_matrix *m, DL_matrix *nm) {
-  nm->c0.x=c0.x * m->c0.x + c1.x * m->c0.y + c2.x * m->c0.z;
-  nm->c1.x=c0.x * m->c1.x + c1.x * m->c1.y + c2.x * m->c1.z;
-  nm->c2.x=c0.x * m->c2.x + c1.x * m->c2.y + c2.x * m->c2.z;
-
-  nm->c0.y=c0.y * m->c0.x + c1.y * m->c0.y + c2.y * m->c0.z;
-  nm->c1.y=c0.y * m->c1.x + c1.y * m->c1.y + c2.y * m->c1.z;
-  nm->c2.y=c0.y * m->c2.x + c1.y * m->c2.y + c2.y * m->c2.z;
-
-  nm->c0.z=c0.z * m->c0.x + c1.z * m->c0.y + c2.z * m->c0.z;
-  nm->c1.z=c0.z * m->c1.x + c1.z * m->c1.y + c2.z * m->c1.z;
-  nm->c2.z=c0.z * m->c2.x + c1.z * m->c2.y + c2.z * m->c2.z;
-}
-
-void DL_matrix::timestranspose(DL_matrix *m, DL_matrix *nm) {
-//nm=self*m^T
-  nm->c0.x=c0.x * m->c0.x + c1.x * m->c1.x + c2.x * m->c2.x;
-  nm->c1.x=c0.x * m->c0.y + c1.x * m->c1.y + c2.x * m->c2.y;
-  nm->c2.x=c0.x * m->c0.z + c1.x * m->c1.z + c2.x * m->c2.z;
-
-  nm->c0.y=c0.y * m->c0.x + c1.y * m->c1.x + c2.y * m->c2.x;
-  nm->c1.y=c0.y * m->c0.y + c1.y * m->c1.y + c2.y * m->c2.y;
-  nm->c2.y=c0.y * m->c0.z + c1.y * m->c1.z + c2.y * m->c2.z;
-
-  nm->c0.z=c0.z * m->c0.x + c1.z * m->c1.x + c2.z * m->c2.x;
-  nm->c1.z=c0.z * m->c0.y + c1.z * m->c1.y + c2.z * m->c2.y;
-  nm->c2.z=c0.z * m->c0.z + c1.z * m->c1.z + c2.z * m->c2.z;
-}
-
 void DL_matrix::times(DL_Scalar f, DL_matrix *nm) {
   c0.times(f,&(nm->c0));
   c1.times(f,&(nm->c1));
   c2.times(f,&(nm->c2));
 }
 
-void DL_matrix::times(DL_vector *v,DL_vector *nv) {
-  nv->x=c0.x * v->x + c1.x * v->y + c2.x * v->z;
-  nv->y=c0.y * v->x + c1.y * v->y + c2.y * v->z;
-  nv->z=c0.z * v->x + c1.z * v->y + c2.z * v->z;
-}
-
-void DL_matrix::transposetimes(DL_vector *v,DL_vector *nv) {
-  nv->x=c0.x * v->x + c0.y * v->y + c0.z * v->z;
-  nv->y=c1.x * v->x + c1.y * v->y + c1.z * v->z;
-  nv->z=c2.x * v->x + c2.y * v->y + c2.z * v->z;
-}
-
-void DL_matrix::times(DL_point *v,DL_point *nv) {
-  nv->x=c0.x * v->x + c1.x * v->y + c2.x * v->z;
-  nv->y=c0.y * v->x + c1.y * v->y + c2.y * v->z;
-  nv->z=c0.z * v->x + c1.z * v->y + c2.z * v->z;
-}
-
 void DL_matrix::tensor(DL_vector *w,DL_vector *v) {
   c0.x=v->x*w->x;    c1.x=v->x*w->y;    c2.x=v->x*w->z;
   c0.y=v->y*w->x;    c1.y=v->y*w->y;    c2.y=v->y*w->z;
@@ -124,19 +124,17 @@ void DL_multi_bar::end_test(void) {
     if (g_is_dyna[i]) ((DL_dyna *)g[i])->endtest();
 }
 
-boolean DL_multi_bar::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_multi_bar::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dfdr(3,1);
-  static DL_largematrix dcdf;
-  static DL_largematrix subtemp;
+  DL_fixmat<3,1> dfdr;
+  DL_jacblock dcdf;
+  DL_subblock subtemp;
   DL_vector ddiff;
   boolean nonzero=FALSE;
-  dcdf.resize(cc->dim,3);
-  subtemp.resize(cc->dim,dim);
 //  sub->makezero();
   for (int i=0;i<nr;i++) {
     if (g_is_dyna[i]) {
@@ -151,11 +149,11 @@ boolean DL_multi_bar::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
 	}
 	// combine dc/df and df/dr into dc/dr:
         if (nonzero) {
-	  dcdf.times(&dfdr,&subtemp);
-	  sub->plusis(&subtemp);
+	  dcdf.times(&dfdr,&subtemp,cc->dim);
+	  sub->plusis(&subtemp,cc->dim,dim);
 	}
 	else {
-	  dcdf.times(&dfdr,sub);
+	  dcdf.times(&dfdr,sub,cc->dim);
 	  nonzero=TRUE;
 	}
       }
@@ -164,15 +162,14 @@ boolean DL_multi_bar::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
   return nonzero;
 }
 
-boolean DL_multi_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_multi_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dcdp(1,3);
-  static DL_largematrix dpdFq_(3,3);
-  static DL_largematrix dcdf_term(1,3);
+  DL_fixmat<1,3> dcdp;
+  DL_jacblock dcdf_term;
   DL_matrix dpdFq;
   DL_matrix ddpdFq;
   DL_vector ddiff;
@@ -186,7 +183,6 @@ boolean DL_multi_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
         ddpdFq.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdFq);
         dpdFq.plus(&ddpdFq,&dpdFq);
       }
-      dpdFq_.assign(&dpdFq);
       // calculate dc/dp:
       if (i==0) { dcdp.setrow(0,&(d[0])); dcdp.neg(); }
       else
@@ -197,11 +193,11 @@ boolean DL_multi_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       }
       // combine dc/dp and dp/df into dc/df
       if (nonzero) {
-	dcdp.times(&dpdFq_,&dcdf_term);
-	dcdfq->plusis(&dcdf_term);
+	dcdp.times(&dpdFq,&dcdf_term);
+	dcdfq->plusis(&dcdf_term,dim);
       }
       else {
-	dcdp.times(&dpdFq_,dcdfq);
+	dcdp.times(&dpdFq,dcdfq);
 	nonzero=TRUE;
       }
     }
@@ -209,14 +205,13 @@ boolean DL_multi_bar::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
   return nonzero;
 }
 
-boolean DL_multi_bar::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_multi_bar::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dcdp(1,3);
-  static DL_largematrix dpdF_(3,3);
-  static DL_largematrix dcdf_term(1,3);
+  DL_fixmat<1,3> dcdp;
+  DL_jacblock dcdf_term;
   DL_matrix dpdF;
   DL_matrix ddpdF;
   DL_vector ddiff;
@@ -230,7 +225,6 @@ boolean DL_multi_bar::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
         ddpdF.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdF);
         dpdF.plus(&ddpdF,&dpdF);
       }
-      dpdF_.assign(&dpdF);
       // calculate dc/dp:
       if (i==0) { dcdp.setrow(0,&(d[0])); dcdp.neg(); }
       else
@@ -241,11 +235,11 @@ boolean DL_multi_bar::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       }
       // combine dc/dp and dp/df into dc/df
       if (nonzero) {
-	dcdp.times(&dpdF_,&dcdf_term);
-	dcdf->plusis(&dcdf_term);
+	dcdp.times(&dpdF,&dcdf_term);
+	dcdf->plusis(&dcdf_term,dim);
       }
       else {
-	dcdp.times(&dpdF_,dcdf);
+	dcdp.times(&dpdF,dcdf);
 	nonzero=TRUE;
       }
     }
@@ -253,15 +247,14 @@ boolean DL_multi_bar::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
   return nonzero;
 }
 
-boolean DL_multi_bar::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_multi_bar::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dcdp(1,3);
-  static DL_largematrix dpdm_(3,3);
-  static DL_largematrix dcdm_term(1,3);
+  DL_fixmat<1,3> dcdp;
+  DL_jacblock dcdm_term;
   DL_matrix dpdm;
   DL_matrix ddpdm;
   DL_vector ddiff;
@@ -275,7 +268,6 @@ boolean DL_multi_bar::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
         ddpdm.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdm);
         dpdm.plus(&ddpdm,&dpdm);
       }
-      dpdm_.assign(&dpdm);
       // calculate dc/dp:
       if (i==0) { dcdp.setrow(0,&(d[0])); dcdp.neg(); }
       else
@@ -286,11 +278,11 @@ boolean DL_multi_bar::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       }
       // combine dc/dp and dp/dm into dc/dm
       if (nonzero) {
-	 dcdp.times(&dpdm_,&dcdm_term);
-	 dcdm->plusis(&dcdm_term);
+	 dcdp.times(&dpdm,&dcdm_term);
+	 dcdm->plusis(&dcdm_term,dim);
       }
       else {
-	dcdp.times(&dpdm_,dcdm);
+	dcdp.times(&dpdm,dcdm);
 	nonzero=TRUE;
       }
     }
@@ -298,15 +290,14 @@ boolean DL_multi_bar::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
   return nonzero;
 }
 
-boolean DL_multi_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_multi_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dcdp(1,3);
-  static DL_largematrix dpdi_(3,3);
-  static DL_largematrix dcdi_term(1,3);
+  DL_fixmat<1,3> dcdp;
+  DL_jacblock dcdi_term;
   DL_matrix dpdi;
   DL_matrix ddpdi;
   DL_vector ddiff;
@@ -320,7 +311,6 @@ boolean DL_multi_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
         ddpdi.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdi);
         dpdi.plusis(&ddpdi);
       }
-      dpdi_.assign(&dpdi);
       // calculate dc/dp:
       if (i==0) { dcdp.setrow(0,&(d[0])); dcdp.neg(); }
       else
@@ -331,11 +321,11 @@ boolean DL_multi_bar::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       }
       // combine dc/dp and dp/di into dc/di
       if (nonzero) {
-	 dcdp.times(&dpdi_,&dcdi_term);
-	 dcdi->plusis(&dcdi_term);
+	 dcdp.times(&dpdi,&dcdi_term);
+	 dcdi->plusis(&dcdi_term,dim);
       }
       else {
-	dcdp.times(&dpdi_,dcdi);
+	dcdp.times(&dpdi,dcdi);
 	nonzero=TRUE;
       }
     }
@@ -403,20 +393,7 @@ void DL_multi_bar::new_frame(void) {
 }
 
 void DL_multi_bar::first_estimate(void) {
-  static DL_largevector dF(dim);
-  dF.resize(dim);
-  if (oldF->norm()==0.0) {
-    // constant extrapolation:
-    oldF->assign(F);
-  }
-  else {
-    // linear extrapolation:
-    F->minus(oldF,&dF);
-    oldF->assign(F);
-    dF.timesis(stiffness);
-    F->plusis(&dF);
-  }
-  
+  extrapolate();
   if (check_restrictions()) apply_restrictions(F);
 }
 
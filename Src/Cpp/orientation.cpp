@@ -36,8 +36,7 @@
 // non-inline member fuctions //
 // ************************** //
 
-DL_orientation::DL_orientation():DL_constraint(),
-  dcdv0(3,3),dcdv1(1,3),dcdw1(1,3),dcdw2(3,3),dfdr(3,3) {
+DL_orientation::DL_orientation():DL_constraint() {
   dim=3;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -188,7 +187,7 @@ void DL_orientation::init(DL_dyna* _d, DL_vector *_v0, DL_vector *_v1,
     get_error(&lv);
     if (lv.norm()!=0.0) {
       DL_dsystem->get_companion()->Msg("Warning: initially invalid orientation constraint\n  Error: (%f,%f,%f)\n",
-				    lv.get(0), lv.get(1), lv.get(2) );
+				    DL_value(lv.get(0)), DL_value(lv.get(1)), DL_value(lv.get(2)) );
     }
   }
   
@@ -212,38 +211,35 @@ void DL_orientation::init(DL_dyna* _d, DL_vector *_v0, DL_vector *_v1,
   dfdr.setcolumn(0,&x);
 }
 
-boolean DL_orientation::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_orientation::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf,dcdfg;
-  dcdf.resize(cc->dim,3);
+  DL_jacblock dcdf,dcdfg;
   boolean nonzero=cc->dCdM(d,&dcdf);
   if (g_is_dyna) {
     if (nonzero) {
-      dcdfg.resize(cc->dim,3);
-      if (cc->dCdM((DL_dyna*)g,&dcdfg)) dcdf.minusis(&dcdfg);
+      if (cc->dCdM((DL_dyna*)g,&dcdfg)) dcdf.minusis(&dcdfg,cc->dim);
     }
-    else if (nonzero=cc->dCdM((DL_dyna*)g,&dcdf)) dcdf.neg(); 
+    else if (nonzero=cc->dCdM((DL_dyna*)g,&dcdf)) dcdf.neg(cc->dim); 
   }
-  dcdf.times(&dfdr,sub);
+  if (nonzero) dcdf.times(&dfdr,sub,cc->dim);
   return nonzero;
 }
 
-boolean DL_orientation::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_orientation::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dvdf(3,3);
-  static DL_largematrix dcdftmp(1,3);
+  DL_jacblock dcdftmp;
   DL_matrix dvdX;
   DL_matrix ddvdX;
   if (d==dc) {
-    dcdfq->makezero();
+    dcdfq->makezero(dim);
     
     dc->dvdfq(&v1,pc,&dvdX);
     if (veloterms) {
@@ -251,10 +247,8 @@ boolean DL_orientation::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq)
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdf.assign(&dvdX);
-    dcdftmp.resize(1,3);
-    dcdv1.times(&dvdf,&dcdftmp);
-    dcdfq->setsubmatrix(2,0,&dcdftmp);
+    dcdv1.times(&dvdX,&dcdftmp);
+    dcdfq->setsubmatrix(2,0,&dcdftmp,1);
 
     dc->dvdfq(&v0,pc,&dvdX);
     if (veloterms) {
@@ -262,15 +256,13 @@ boolean DL_orientation::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq)
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdf.assign(&dvdX);
-    dcdftmp.resize(3,3);
-    dcdv0.times(&dvdf,&dcdftmp);
-    dcdfq->plusis(&dcdftmp);
+    dcdv0.times(&dvdX,&dcdftmp);
+    dcdfq->plusis(&dcdftmp,dim);
     
     return TRUE;
   }
   if (g==dc) {
-    dcdfq->makezero();
+    dcdfq->makezero(dim);
     
     dc->dvdfq(&w1,pc,&dvdX);
     if (veloterms) {
@@ -278,10 +270,8 @@ boolean DL_orientation::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq)
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdf.assign(&dvdX);
-    dcdftmp.resize(1,3);
-    dcdw1.times(&dvdf,&dcdftmp);
-    dcdfq->setsubmatrix(0,0,&dcdftmp);
+    dcdw1.times(&dvdX,&dcdftmp);
+    dcdfq->setsubmatrix(0,0,&dcdftmp,1);
 
     dc->dvdfq(&w2,pc,&dvdX);
     if (veloterms) {
@@ -289,17 +279,15 @@ boolean DL_orientation::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq)
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdf.assign(&dvdX);
-    dcdftmp.resize(3,3);
-    dcdw2.times(&dvdf,&dcdftmp);
-    dcdfq->plusis(&dcdftmp);
+    dcdw2.times(&dvdX,&dcdftmp);
+    dcdfq->plusis(&dcdftmp,dim);
     
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_orientation::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_orientation::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
@@ -308,18 +296,17 @@ boolean DL_orientation::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
   return FALSE;
 }
 
-boolean DL_orientation::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_orientation::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dvdm(3,3);
-  static DL_largematrix dcdmtmp(1,3);
+  DL_jacblock dcdmtmp;
   DL_matrix dvdX;
   DL_matrix ddvdX;
   if (d==dc) {
-    dcdm->makezero();
+    dcdm->makezero(dim);
     
     dc->dvdM(&v1,&dvdX);
     if (veloterms) {
@@ -327,10 +314,8 @@ boolean DL_orientation::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdm.assign(&dvdX);
-    dcdmtmp.resize(1,3);
-    dcdv1.times(&dvdm,&dcdmtmp);
-    dcdm->setsubmatrix(2,0,&dcdmtmp);
+    dcdv1.times(&dvdX,&dcdmtmp);
+    dcdm->setsubmatrix(2,0,&dcdmtmp,1);
 
     dc->dvdM(&v0,&dvdX);
     if (veloterms) {
@@ -338,15 +323,13 @@ boolean DL_orientation::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdm.assign(&dvdX);
-    dcdmtmp.resize(3,3);
-    dcdv0.times(&dvdm,&dcdmtmp);
-    dcdm->plusis(&dcdmtmp);
+    dcdv0.times(&dvdX,&dcdmtmp);
+    dcdm->plusis(&dcdmtmp,dim);
     
     return TRUE;
   }
   if (g==dc) {
-    dcdm->makezero();
+    dcdm->makezero(dim);
     
     dc->dvdM(&w1,&dvdX);
     if (veloterms) {
@@ -354,10 +337,8 @@ boolean DL_orientation::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdm.assign(&dvdX);
-    dcdmtmp.resize(1,3);
-    dcdw1.times(&dvdm,&dcdmtmp);
-    dcdm->setsubmatrix(0,0,&dcdmtmp);
+    dcdw1.times(&dvdX,&dcdmtmp);
+    dcdm->setsubmatrix(0,0,&dcdmtmp,1);
 
     dc->dvdM(&w2,&dvdX);
     if (veloterms) {
@@ -365,28 +346,25 @@ boolean DL_orientation::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdm.assign(&dvdX);
-    dcdmtmp.resize(3,3);
-    dcdw2.times(&dvdm,&dcdmtmp);
-    dcdm->plusis(&dcdmtmp);
+    dcdw2.times(&dvdX,&dcdmtmp);
+    dcdm->plusis(&dcdmtmp,dim);
     
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_orientation::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_orientation::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dvdi(3,3);
-  static DL_largematrix dcditmp(1,3);
+  DL_jacblock dcditmp;
   DL_matrix dvdX;
   DL_matrix ddvdX;
   if (d==dc) {
-    dcdi->makezero();
+    dcdi->makezero(dim);
     
     dc->dvdi(&v1,pc,&dvdX);
     if (veloterms) {
@@ -395,10 +373,8 @@ boolean DL_orientation::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdi.assign(&dvdX);
-    dcditmp.resize(1,3);
-    dcdv1.times(&dvdi,&dcditmp);
-    dcdi->setsubmatrix(2,0,&dcditmp);
+    dcdv1.times(&dvdX,&dcditmp);
+    dcdi->setsubmatrix(2,0,&dcditmp,1);
 
     dc->dvdi(&v0,pc,&dvdX);
     if (veloterms) {
@@ -406,15 +382,13 @@ boolean DL_orientation::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdi.assign(&dvdX);
-    dcditmp.resize(3,3);
-    dcdv0.times(&dvdi,&dcditmp);
-    dcdi->plusis(&dcditmp);
+    dcdv0.times(&dvdX,&dcditmp);
+    dcdi->plusis(&dcditmp,dim);
     
     return TRUE;
   }
   if (g==dc) {
-    dcdi->makezero();
+    dcdi->makezero(dim);
     
     dc->dvdi(&w1,pc,&dvdX);
     if (veloterms) {
@@ -422,10 +396,8 @@ boolean DL_orientation::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdi.assign(&dvdX);
-    dcditmp.resize(1,3);
-    dcdw1.times(&dvdi,&dcditmp);
-    dcdi->setsubmatrix(0,0,&dcditmp);
+    dcdw1.times(&dvdX,&dcditmp);
+    dcdi->setsubmatrix(0,0,&dcditmp,1);
 
     dc->dvdi(&w2,pc,&dvdX);
     if (veloterms) {
@@ -433,10 +405,8 @@ boolean DL_orientation::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddvdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddvdX);
       dvdX.plus(&ddvdX,&dvdX);
     }
-    dvdi.assign(&dvdX);
-    dcditmp.resize(3,3);
-    dcdw2.times(&dvdi,&dcditmp);
-    dcdi->plusis(&dcditmp);
+    dcdw2.times(&dvdX,&dcditmp);
+    dcdi->plusis(&dcditmp,dim);
     
     return TRUE;
   }
@@ -506,16 +476,15 @@ boolean DL_orientation::check_restrictions() {
 
 void DL_orientation::test_restriction_changes(DL_largevector* lv) {
   if (maxtorque>0) {
-    DL_largevector* Fnew=new DL_largevector(dim);
-    F->plus(lv,Fnew);
+    DL_largevector Fnew(dim);
+    F->plus(lv,&Fnew);
     DL_vector trq;
-    gettorque(Fnew,&trq);
+    gettorque(&Fnew,&trq);
     if (trq.norm()>maxtorque) {
       deactivate();
       // possibly raise an event here
       DL_dsystem->get_companion()->Msg("Too large a reaction torque: orientation-constraint deactivated\n");
     }
-    delete Fnew;
   }
 }
 
@@ -578,3 +547,19 @@ void DL_orientation::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_orientation::remap(DL_dyna *from, DL_dyna *to, DL_matrix *R, DL_vector*) {
+  // only directions are involved, so the offset of the member in the
+  // compound does not apply:
+  DL_vector v;
+  if (d==from) {
+    R->times(&v0,&v); v0.assign(&v);
+    R->times(&v1,&v); v1.assign(&v);
+    d=to;
+  }
+  if (g==from) {
+    R->times(&w1,&v); w1.assign(&v);
+    R->times(&w2,&v); w2.assign(&v);
+    g=to;
+  }
+}
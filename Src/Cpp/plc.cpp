@@ -32,13 +32,13 @@
 
 #include "dyna_system.h"
 #include "plc.h"
+#include "snapshot.h"
 
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
-DL_plc::DL_plc():DL_constraint(),
-  dcdp(1,3), dcdv0(2,3), dcdw(1,3), dfdR(3,1), dmdR(3,2) {
+DL_plc::DL_plc():DL_constraint() {
   dim=3;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -105,7 +105,7 @@ void DL_plc::init(DL_dyna* _d, DL_point* _pd, DL_vector *_ld,
   get_error(&lv);
   if (lv.norm()>DL_constraints->max_error) {
     DL_dsystem->get_companion()->Msg("Warning: initially invalid plane-constraint.\n Error: (%f,%f,%f)\n",
-				     lv.get(0), lv.get(1), lv.get(2) );
+				     DL_value(lv.get(0)), DL_value(lv.get(1)), DL_value(lv.get(2)) );
   }
 
   dfdR.setcolumn(0,&l);
@@ -148,77 +148,63 @@ void DL_plc::end_test(void) {
   if (g_is_dyna) ((DL_dyna*)g)->endtest();
 }
 
-boolean DL_plc::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_plc::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf;
-  static DL_largematrix subtemp;
-  static DL_largematrix tmp;
+  DL_jacblock dcdf;
+  DL_subblock subtemp;
+  DL_fixmat<DL_MAXCDIM,2> tmp;
   boolean nonzero;
-  dcdf.resize(cc->dim,3);
   if (nonzero=cc->dCdFq(d,&pd,&dcdf)) {
-    tmp.resize(cc->dim,1);
-    dcdf.times(&dfdR,&tmp);
-    sub->setsubmatrix(0,0,&tmp);
-    tmp.resize(cc->dim,2);
+    dcdf.times(&dfdR,sub,cc->dim);
     cc->dCdM(d,&dcdf);
-    dcdf.times(&dmdR,&tmp);
-    sub->setsubmatrix(0,1,&tmp);
+    dcdf.times(&dmdR,&tmp,cc->dim);
+    sub->setsubmatrix(0,1,&tmp,cc->dim);
   }
   if (g_is_dyna) {
    if (nonzero) {
     if (cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) {
-      subtemp.resize(cc->dim,dim);
-      tmp.resize(cc->dim,1);
-      dcdf.times(&dfdR,&tmp);
-      subtemp.setsubmatrix(0,0,&tmp);
-      tmp.resize(cc->dim,2);
+      dcdf.times(&dfdR,&subtemp,cc->dim);
       cc->dCdM((DL_dyna*)g,&dcdf);
-      dcdf.times(&dmdR,&tmp);
-      subtemp.setsubmatrix(0,1,&tmp);
-      sub->minusis(&subtemp);
+      dcdf.times(&dmdR,&tmp,cc->dim);
+      subtemp.setsubmatrix(0,1,&tmp,cc->dim);
+      sub->minusis(&subtemp,cc->dim,dim);
     }
    }
    else {
     if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) {
-      tmp.resize(cc->dim,1);
-      dcdf.times(&dfdR,&tmp);
-      sub->setsubmatrix(0,0,&tmp);
-      tmp.resize(cc->dim,2);
+      dcdf.times(&dfdR,sub,cc->dim);
       cc->dCdM((DL_dyna*)g,&dcdf);
-      dcdf.times(&dmdR,&tmp);
-      sub->setsubmatrix(0,1,&tmp);
-      sub->neg();
+      dcdf.times(&dmdR,&tmp,cc->dim);
+      sub->setsubmatrix(0,1,&tmp,cc->dim);
+      sub->neg(cc->dim,dim);
     }
    }
   }
   return nonzero;
 }
 
-boolean DL_plc::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_plc::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
-  static DL_largematrix dcIdf(1,3);
+  DL_fixmat<2,3> dcIdf;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
-    dcIdf.resize(1,3);
     dc->dpdfq(&pd,pc,&dpdX);
     if (veloterms) {
       dc->ddpdfq(&pd,pc,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp.times(&dpdf,&dcIdf);
-    dcdfq->setsubmatrix(0,0,&dcIdf);
+    dcdp.times(&dpdX,&dcIdf);
+    dcdfq->setsubmatrix(0,0,&dcIdf,1);
     
     dc->dvdfq(&v0,pc,&dpdX);
     if (veloterms) {
@@ -226,25 +212,21 @@ boolean DL_plc::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcIdf.resize(2,3);
-    dcdv0.times(&dpdf,&dcIdf);
+    dcdv0.times(&dpdX,&dcIdf);
     dcdfq->setsubmatrix(1,0,&dcIdf);
     
     return TRUE;
   }
   if (dc==g) { // there is an effect on C through g
-    dcIdf.resize(1,3);
     dc->dpdfq(&pg,pc,&dpdX);
     if (veloterms) {
       dc->ddpdfq(&pg,pc,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp.times(&dpdf,&dcIdf);
-    dcIdf.neg();
-    dcdfq->setsubmatrix(0,0,&dcIdf);
+    dcdp.times(&dpdX,&dcIdf);
+    dcIdf.neg(1);
+    dcdfq->setsubmatrix(0,0,&dcIdf,1);
     
     dc->dvdfq(&w1,pc,&dpdX);
     if (veloterms) {
@@ -252,9 +234,8 @@ boolean DL_plc::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdw.times(&dpdf,&dcIdf);
-    dcdfq->setsubmatrix(1,0,&dcIdf);
+    dcdw.times(&dpdX,&dcIdf);
+    dcdfq->setsubmatrix(1,0,&dcIdf,1);
     
     dc->dvdfq(&w2,pc,&dpdX);
     if (veloterms) {
@@ -262,85 +243,76 @@ boolean DL_plc::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdw.times(&dpdf,&dcIdf);
-    dcdfq->setsubmatrix(2,0,&dcIdf);
+    dcdw.times(&dpdX,&dcIdf);
+    dcdfq->setsubmatrix(2,0,&dcIdf,1);
     
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_plc::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_plc::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
-  static DL_largematrix dcIdf(1,3);
+  DL_fixmat<2,3> dcIdf;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
-    // dcIdf.resize(1,3);
     dc->dpdF(&pd,&dpdX);
     if (veloterms) {
       dc->ddpdF(&pd,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp.times(&dpdf,&dcIdf);
-    dcdf->setsubmatrix(0,0,&dcIdf);
+    dcdp.times(&dpdX,&dcIdf);
+    dcdf->setsubmatrix(0,0,&dcIdf,1);
     
-    dcIdf.makezero(); // no effect of central force on orientation
-    dcdf->setsubmatrix(1,0,&dcIdf);
-    dcdf->setsubmatrix(2,0,&dcIdf);
+    dcIdf.makezero(1); // no effect of central force on orientation
+    dcdf->setsubmatrix(1,0,&dcIdf,1);
+    dcdf->setsubmatrix(2,0,&dcIdf,1);
     
     return TRUE;
   }
   if (dc==g) { // there is an effect on C through g
-    // dcIdf.resize(1,3);
     dc->dpdF(&pg,&dpdX);
     if (veloterms) {
       dc->ddpdF(&pg,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp.times(&dpdf,&dcIdf);
-    dcIdf.neg();
-    dcdf->setsubmatrix(0,0,&dcIdf);
+    dcdp.times(&dpdX,&dcIdf);
+    dcIdf.neg(1);
+    dcdf->setsubmatrix(0,0,&dcIdf,1);
     
-    dcIdf.makezero(); // no effect of central force on orientation
-    dcdf->setsubmatrix(1,0,&dcIdf);
-    dcdf->setsubmatrix(2,0,&dcIdf);
+    dcIdf.makezero(1); // no effect of central force on orientation
+    dcdf->setsubmatrix(1,0,&dcIdf,1);
+    dcdf->setsubmatrix(2,0,&dcIdf,1);
     
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_plc::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_plc::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dpdm(3,3);
-  static DL_largematrix dcIdm(1,3);
+  DL_fixmat<2,3> dcIdm;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
-    dcIdm.resize(1,3);
     dc->dpdM(&pd,&dpdX);
     if (veloterms) {
       dc->ddpdM(&pd,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp.times(&dpdm,&dcIdm);
-    dcdm->setsubmatrix(0,0,&dcIdm);
+    dcdp.times(&dpdX,&dcIdm);
+    dcdm->setsubmatrix(0,0,&dcIdm,1);
     
     dc->dvdM(&v0,&dpdX);
     if (veloterms) {
@@ -348,25 +320,21 @@ boolean DL_plc::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcIdm.resize(2,3);
-    dcdv0.times(&dpdm,&dcIdm);
+    dcdv0.times(&dpdX,&dcIdm);
     dcdm->setsubmatrix(1,0,&dcIdm);
     
     return TRUE;
   }
   if (dc==g) { // there is an effect on C through g
-    dcIdm.resize(1,3);
     dc->dpdM(&pg,&dpdX);
     if (veloterms) {
       dc->ddpdM(&pg,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp.times(&dpdm,&dcIdm);
-    dcIdm.neg();
-    dcdm->setsubmatrix(0,0,&dcIdm);
+    dcdp.times(&dpdX,&dcIdm);
+    dcIdm.neg(1);
+    dcdm->setsubmatrix(0,0,&dcIdm,1);
     
     dc->dvdM(&w1,&dpdX);
     if (veloterms) {
@@ -374,9 +342,8 @@ boolean DL_plc::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdw.times(&dpdm,&dcIdm);
-    dcdm->setsubmatrix(1,0,&dcIdm);
+    dcdw.times(&dpdX,&dcIdm);
+    dcdm->setsubmatrix(1,0,&dcIdm,1);
     
     dc->dvdM(&w2,&dpdX);
     if (veloterms) {
@@ -384,36 +351,32 @@ boolean DL_plc::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdw.times(&dpdm,&dcIdm);
-    dcdm->setsubmatrix(2,0,&dcIdm);
+    dcdw.times(&dpdX,&dcIdm);
+    dcdm->setsubmatrix(2,0,&dcIdm,1);
     
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_plc::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_plc::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dpdi(3,3);
-  static DL_largematrix dcIdi(1,3);
+  DL_fixmat<2,3> dcIdi;
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
-    dcIdi.resize(1,3);
     dc->dpdi(&pd,pc,&dpdX);
     if (veloterms) {
       dc->ddpdi(&pd,pc,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp.times(&dpdi,&dcIdi);
-    dcdi->setsubmatrix(0,0,&dcIdi);
+    dcdp.times(&dpdX,&dcIdi);
+    dcdi->setsubmatrix(0,0,&dcIdi,1);
     
     dc->dvdi(&v0,pc,&dpdX);
     if (veloterms) {
@@ -421,25 +384,21 @@ boolean DL_plc::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcIdi.resize(2,3);
-    dcdv0.times(&dpdi,&dcIdi);
+    dcdv0.times(&dpdX,&dcIdi);
     dcdi->setsubmatrix(1,0,&dcIdi);
     
     return TRUE;
   }
   if (dc==g) { // there is an effect on C through g
-    dcIdi.resize(1,3);
     dc->dpdi(&pg,pc,&dpdX);
     if (veloterms) {
       dc->ddpdi(&pg,pc,&ddpdX);
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp.times(&dpdi,&dcIdi);
-    dcIdi.neg();
-    dcdi->setsubmatrix(0,0,&dcIdi);
+    dcdp.times(&dpdX,&dcIdi);
+    dcIdi.neg(1);
+    dcdi->setsubmatrix(0,0,&dcIdi,1);
     
     dc->dvdi(&w1,pc,&dpdX);
     if (veloterms) {
@@ -447,9 +406,8 @@ boolean DL_plc::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdw.times(&dpdi,&dcIdi);
-    dcdi->setsubmatrix(1,0,&dcIdi);
+    dcdw.times(&dpdX,&dcIdi);
+    dcdi->setsubmatrix(1,0,&dcIdi,1);
     
     dc->dvdi(&w2,pc,&dpdX);
     if (veloterms) {
@@ -457,9 +415,8 @@ boolean DL_plc::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdw.times(&dpdi,&dcIdi);
-    dcdi->setsubmatrix(2,0,&dcIdi);
+    dcdw.times(&dpdX,&dcIdi);
+    dcdi->setsubmatrix(2,0,&dcIdi,1);
     
     return TRUE;
   }
@@ -653,3 +610,14 @@ void DL_plc::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_plc::save_state(DL_snapshot *snap) {
+  DL_constraint::save_state(snap);
+  // the local coordinate system, which is rotated along with l each frame:
+  snap->put(&l); snap->put(&x); snap->put(&y);
+}
+
+void DL_plc::restore_state(DL_snapshot *snap) {
+  DL_constraint::restore_state(snap);
+  snap->get(&l); snap->get(&x); snap->get(&y);
+}
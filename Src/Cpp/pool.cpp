@@ -0,0 +1,70 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename     : pool.cpp
+// description	: non-inline methods of class DL_pool
+//
+
+#include "pool.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+DL_pool::DL_pool(size_t bs, int cs) {
+  // blocks need to be able to hold the free list pointer and have
+  // to keep doubles properly aligned:
+  if (bs<sizeof(DL_poolblock)) bs=sizeof(DL_poolblock);
+  blocksize=((bs+sizeof(double)-1)/sizeof(double))*sizeof(double);
+  chunksize=(cs<1 ? 1 : cs);
+  freelist=chunks=NULL;
+  nrused=0;
+}
+
+DL_pool::~DL_pool() {
+  DL_poolblock *c;
+  while (chunks) {
+    c=chunks;
+    chunks=chunks->next;
+    delete[] (double*)c;
+  }
+}
+
+void DL_pool::newchunk(void) {
+  // the first block of a chunk is used to link the chunks together,
+  // the rest is added to the free list
+  int i;
+  char *mem=(char*)new double[(chunksize+1)*blocksize/sizeof(double)];
+  DL_poolblock *c=(DL_poolblock*)mem;
+  c->next=chunks;
+  chunks=c;
+  for (i=chunksize;i>0;i--) {
+    DL_poolblock *b=(DL_poolblock*)(mem+i*blocksize);
+    b->next=freelist;
+    freelist=b;
+  }
+}
@@ -37,8 +37,7 @@
 // non-inline member fuctions //
 // ************************** //
 
-DL_pris::DL_pris():DL_constraint(),
-  dcdp(2,3), dfdR(3,2) {
+DL_pris::DL_pris():DL_constraint() {
   dim=2;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -108,7 +107,7 @@ void DL_pris::init(DL_dyna *_d, DL_point *_pd, DL_vector *_ld, DL_vector *_rd,
     
   if (lv.norm()>DL_constraints->max_error) {
     DL_dsystem->get_companion()->Msg("Warning: initially invalid prism-constraint\n Error: (%f,%f)\n",
-				  lv.get(0), lv.get(1) );
+				  DL_value(lv.get(0)), DL_value(lv.get(1)) );
   }
 }
 
@@ -135,36 +134,33 @@ void DL_pris::end_test(void) {
   if (g_is_dyna) ((DL_dyna *)g)->endtest();
 }
 
-boolean DL_pris::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_pris::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf;
-  static DL_largematrix dcdfg;
-  dcdf.resize(cc->dim,3);
+  DL_jacblock dcdf;
+  DL_jacblock dcdfg;
   boolean nonzero=cc->dCdFq((DL_dyna*)d,&pd,&dcdf);
   if (g_is_dyna) {
     if (nonzero) {
-      dcdfg.resize(cc->dim,3);
-      if (cc->dCdFq((DL_dyna*)g,&pg,&dcdfg)) dcdf.minusis(&dcdfg);
+      if (cc->dCdFq((DL_dyna*)g,&pg,&dcdfg)) dcdf.minusis(&dcdfg,cc->dim);
     }
     else {
-      if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) dcdf.neg();
+      if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) dcdf.neg(cc->dim);
     }
   }
-  if (nonzero) dcdf.times(&dfdR,sub);
+  if (nonzero) dcdf.times(&dfdR,sub,cc->dim);
   return nonzero;
 }
 
-boolean DL_pris::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_pris::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dpdfq(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -174,8 +170,7 @@ boolean DL_pris::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdfq.assign(&dpdX);
-    dcdp.times(&dpdfq,dcdfq);
+    dcdp.times(&dpdX,dcdfq);
     return TRUE;
   }
   if (dc==g) { // which implies g_is_dyna;
@@ -186,20 +181,18 @@ boolean DL_pris::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdfq.assign(&dpdX);
-    dpdfq.neg();
-    dcdp.times(&dpdfq,dcdfq);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdfq);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_pris::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_pris::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -209,8 +202,7 @@ boolean DL_pris::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp.times(&dpdf,dcdf);
+    dcdp.times(&dpdX,dcdf);
     return TRUE;
   }
   if (dc==g) { // which implies g_is_dyna;
@@ -221,21 +213,19 @@ boolean DL_pris::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dpdf.neg();
-    dcdp.times(&dpdf,dcdf);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdf);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_pris::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_pris::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dpdm(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -245,8 +235,7 @@ boolean DL_pris::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp.times(&dpdm,dcdm);
+    dcdp.times(&dpdX,dcdm);
     return TRUE;
   }
   if (dc==g) { // which implies g_is_dyna;
@@ -257,21 +246,19 @@ boolean DL_pris::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dpdm.neg();
-    dcdp.times(&dpdm,dcdm);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdm);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_pris::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_pris::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dpdi(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==d) { // there is an effect on C through d
@@ -281,8 +268,7 @@ boolean DL_pris::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp.times(&dpdi,dcdi);
+    dcdp.times(&dpdX,dcdi);
     return TRUE;
   }
   if (dc==g) { // which implies g_is_dyna;
@@ -293,9 +279,8 @@ boolean DL_pris::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dpdi.neg();
-    dcdp.times(&dpdi,dcdi);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdi);
     return TRUE;
   }
   return FALSE;
@@ -32,13 +32,13 @@
 
 #include "dyna_system.h"
 #include "ptc.h"
+#include "snapshot.h"
 
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
-DL_ptc::DL_ptc():DL_constraint(),
-  dcdp(2,3), dfdR(3,2) {
+DL_ptc::DL_ptc():DL_constraint() {
   dim=2;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -117,13 +117,13 @@ void DL_ptc::init(DL_geo* _g, DL_point* _p, DL_curve* _c) {
   get_error(&lv);
   
   if (!s_inbounds) {
-    DL_dsystem->get_companion()->Msg("Error: ptc::init: initial curve position (%f) is out of bounds\n ptc-constraint not initialised", s);
+    DL_dsystem->get_companion()->Msg("Error: ptc::init: initial curve position (%f) is out of bounds\n ptc-constraint not initialised", DL_value(s));
     return;
   }
   
   if (lv.norm()>DL_constraints->max_error) {
-    DL_dsystem->get_companion()->Msg("Warning: initially invalid ptc-constraint\n Error: (%f,%f)\n Initial curve parameter: %s\n",
-				  lv.get(0), lv.get(1), s );
+    DL_dsystem->get_companion()->Msg("Warning: initially invalid ptc-constraint\n Error: (%f,%f)\n Initial curve parameter: %f\n",
+				  DL_value(lv.get(0)), DL_value(lv.get(1)), DL_value(s) );
   }
 
   // ok: we're in business:
@@ -161,38 +161,35 @@ void DL_ptc::end_test(void) {
   if (g_is_dyna) ((DL_dyna *)g)->endtest();
 }
 
-boolean DL_ptc::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_ptc::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf;
-  static DL_largematrix dcdfc;
+  DL_jacblock dcdf;
+  DL_jacblock dcdfc;
   boolean nonzero=FALSE;
-  dcdf.resize(cc->dim,3);
   if (g_is_dyna) nonzero=cc->dCdFq((DL_dyna*)g,&p,&dcdf);
   if (cg_is_dyna) {
     if (nonzero) {
-      dcdfc.resize(cc->dim,3);
       if (cc->dCdFq((DL_dyna*)(c->get_geo()),&csl,&dcdfc))
-        dcdf.minusis(&dcdfc);
+        dcdf.minusis(&dcdfc,cc->dim);
     }
     else {
-      if (nonzero=cc->dCdFq((DL_dyna*)(c->get_geo()),&csl,&dcdf)) dcdf.neg();
+      if (nonzero=cc->dCdFq((DL_dyna*)(c->get_geo()),&csl,&dcdf)) dcdf.neg(cc->dim);
     }
   }
-  if (nonzero) dcdf.times(&dfdR,sub);
+  if (nonzero) dcdf.times(&dfdR,sub,cc->dim);
   return nonzero;
 }
 
-boolean DL_ptc::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_ptc::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dpdfq(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -202,8 +199,7 @@ boolean DL_ptc::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdfq.assign(&dpdX);
-    dcdp.times(&dpdfq,dcdfq);
+    dcdp.times(&dpdX,dcdfq);
     return TRUE;
   }
   if (dc==c->get_geo()) { // which implies cg_is_dyna;
@@ -214,21 +210,19 @@ boolean DL_ptc::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdfq.assign(&dpdX);
-    dpdfq.neg();
-    dcdp.times(&dpdfq,dcdfq);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdfq);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_ptc::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_ptc::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dpdi(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -238,8 +232,7 @@ boolean DL_ptc::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp.times(&dpdi,dcdi);
+    dcdp.times(&dpdX,dcdi);
     return TRUE;
   }
   if (dc==c->get_geo()) { // which implies cg_is_dyna;
@@ -250,20 +243,18 @@ boolean DL_ptc::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dpdi.neg();
-    dcdp.times(&dpdi,dcdi);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdi);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_ptc::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_ptc::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -273,8 +264,7 @@ boolean DL_ptc::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp.times(&dpdf,dcdf);
+    dcdp.times(&dpdX,dcdf);
     return TRUE;
   }
   if (dc==c->get_geo()) { // which implies cg_is_dyna;
@@ -285,21 +275,19 @@ boolean DL_ptc::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dpdf.neg();
-    dcdp.times(&dpdf,dcdf);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdf);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_ptc::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_ptc::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dpdm(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -309,8 +297,7 @@ boolean DL_ptc::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp.times(&dpdm,dcdm);
+    dcdp.times(&dpdX,dcdm);
     return TRUE;
   }
   if (dc==c->get_geo()) { // which implies cg_is_dyna;
@@ -321,9 +308,8 @@ boolean DL_ptc::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dpdm.neg();
-    dcdp.times(&dpdm,dcdm);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdm);
     return TRUE;
   }
   return FALSE;
@@ -492,3 +478,17 @@ void DL_ptc::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_ptc::save_state(DL_snapshot *snap) {
+  DL_constraint::save_state(snap);
+  // the curve parameter and the local coordinate system rotated along
+  // with the curve derivative:
+  snap->put(s); snap->put(olds); snap->put(sf);
+  snap->put(&d); snap->put(&x); snap->put(&y);
+}
+
+void DL_ptc::restore_state(DL_snapshot *snap) {
+  DL_constraint::restore_state(snap);
+  s=snap->get(); olds=snap->get(); sf=snap->get();
+  snap->get(&d); snap->get(&x); snap->get(&y);
+}
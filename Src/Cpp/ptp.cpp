@@ -71,13 +71,12 @@ void DL_ptp::init(DL_dyna* _d, DL_point* _pd, DL_geo* _g, DL_point* _pg) {
   }
 
   // check if the constraint is initially valid
-  DL_largevector* lv=new DL_largevector(3);
-  get_error(lv);
-  if (lv->norm()>DL_constraints->max_error) {
+  DL_largevector lv(3);
+  get_error(&lv);
+  if (lv.norm()>DL_constraints->max_error) {
     DL_dsystem->get_companion()->Msg("Warning: initially invalid ptp-constraint.\n  Error: (%f,%f,%f)\n",
-				   lv->get(0), lv->get(1), lv->get(2) );
+				   DL_value(lv.get(0)), DL_value(lv.get(1)), DL_value(lv.get(2)) );
   }
-  delete lv;
 }
 
 void DL_ptp::reactionforce(DL_vector *f) {
@@ -96,27 +95,27 @@ void DL_ptp::end_test(void) {
   if (g_is_dyna) ((DL_dyna*)g)->endtest();
 }
 
-boolean DL_ptp::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_ptp::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix subtemp;
-  boolean nonzero=cc->dCdFq(d,&pd,sub);
+  DL_jacblock dcdf, subtemp;
+  boolean nonzero=cc->dCdFq(d,&pd,&dcdf);
   if (g_is_dyna) {
     if (nonzero) {
-      subtemp.resize(cc->dim,3);
-      if (cc->dCdFq((DL_dyna*)g,&pg,&subtemp)) sub->minusis(&subtemp);
+      if (cc->dCdFq((DL_dyna*)g,&pg,&subtemp)) dcdf.minusis(&subtemp,cc->dim);
     }
     else {
-      if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,sub)) sub->neg();
+      if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) dcdf.neg(cc->dim);
     }
   }
+  if (nonzero) sub->setsubmatrix(0,0,&dcdf,cc->dim);
   return nonzero;
 }
 
-boolean DL_ptp::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_ptp::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
@@ -142,13 +141,13 @@ boolean DL_ptp::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       dpdFq.plus(&ddpdFq,&dpdFq);
     }
     dcdfq->assign(&dpdFq);
-    dcdfq->neg();
+    dcdfq->neg(dim);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_ptp::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_ptp::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
@@ -173,13 +172,13 @@ boolean DL_ptp::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       dpdf.plus(&ddpdf,&dpdf);
     }
     dcdf->assign(&dpdf);
-    dcdf->neg();
+    dcdf->neg(dim);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_ptp::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_ptp::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
@@ -205,13 +204,13 @@ boolean DL_ptp::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       dpdm.plus(&ddpdm,&dpdm);
     }
     dcdm->assign(&dpdm);
-    dcdm->neg();
+    dcdm->neg(dim);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_ptp::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_ptp::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
@@ -237,7 +236,7 @@ boolean DL_ptp::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       dpdi.plusis(&ddpdi);
     }
     dcdi->assign(&dpdi);
-    dcdi->neg();
+    dcdi->neg(dim);
     return TRUE;
   }
   return FALSE;
@@ -260,14 +259,13 @@ void DL_ptp::new_frame(void) {
 
 void DL_ptp::test_restriction_changes(DL_largevector* lv) {
   if (maxforce>0) {
-    DL_largevector* Fnew=new DL_largevector(dim);
-    F->plus(lv,Fnew);
-    if (Fnew->norm()>maxforce) {
+    DL_largevector Fnew(dim);
+    F->plus(lv,&Fnew);
+    if (Fnew.norm()>maxforce) {
       deactivate();
       // possibly raise an event here
       DL_dsystem->get_companion()->Msg("Too large a reaction force: ptp-constraint deactivated\n");
     }
-    delete Fnew;
   }
 }
 
@@ -339,3 +337,17 @@ void DL_ptp::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_ptp::remap(DL_dyna *from, DL_dyna *to, DL_matrix *R, DL_vector *o) {
+  DL_point p;
+  if (d==from) {
+    R->times(&pd,&p);
+    p.plus(o,&pd);
+    d=to;
+  }
+  if (g==from) {
+    R->times(&pg,&p);
+    p.plus(o,&pg);
+    g=to;
+  }
+}
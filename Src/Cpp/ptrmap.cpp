@@ -0,0 +1,118 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename     : ptrmap.cpp
+// description	: non-inline methods of class DL_ptrmap
+//
+
+#include "ptrmap.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+DL_ptrmap::DL_ptrmap(int n) : entries(sizeof(DL_ptrmapentry),256) {
+  int i;
+  tablesize=8;
+  while (tablesize<n) tablesize*=2;
+  table=new DL_ptrmapentry*[tablesize];
+  for (i=0;i<tablesize;i++) table[i]=NULL;
+  nrelem=0;
+}
+
+DL_ptrmap::~DL_ptrmap() {
+  // the entries themselves are freed with the pool
+  delete[] table;
+}
+
+void DL_ptrmap::insert(void *key, void *value) {
+  int b=bucket(key);
+  DL_ptrmapentry *e=table[b];
+  while (e) {
+    if (e->key==key) {
+      e->value=value;
+      return;
+    }
+    e=e->next;
+  }
+  if (nrelem>=tablesize) {
+    // keep the chains short (on average at most one entry per bucket)
+    rehash(2*tablesize);
+    b=bucket(key);
+  }
+  e=(DL_ptrmapentry*)entries.alloc();
+  e->key=key;
+  e->value=value;
+  e->next=table[b];
+  table[b]=e;
+  nrelem++;
+}
+
+void* DL_ptrmap::remove(void *key) {
+  DL_ptrmapentry **pe=&(table[bucket(key)]);
+  while (*pe) {
+    if ((*pe)->key==key) {
+      DL_ptrmapentry *e=*pe;
+      void *value=e->value;
+      *pe=e->next;
+      entries.free(e);
+      nrelem--;
+      return value;
+    }
+    pe=&((*pe)->next);
+  }
+  return NULL;
+}
+
+void DL_ptrmap::clear(void) {
+  int i;
+  DL_ptrmapentry *e;
+  for (i=0;i<tablesize;i++) {
+    while ((e=table[i])) {
+      table[i]=e->next;
+      entries.free(e);
+    }
+  }
+  nrelem=0;
+}
+
+void DL_ptrmap::rehash(int n) {
+  int i,oldsize=tablesize;
+  DL_ptrmapentry **oldtable=table;
+  DL_ptrmapentry *e;
+  tablesize=n;
+  table=new DL_ptrmapentry*[tablesize];
+  for (i=0;i<tablesize;i++) table[i]=NULL;
+  for (i=0;i<oldsize;i++) {
+    while ((e=oldtable[i])) {
+      oldtable[i]=e->next;
+      int b=bucket(e->key);
+      e->next=table[b];
+      table[b]=e;
+    }
+  }
+  delete[] oldtable;
+}
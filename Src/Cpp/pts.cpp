@@ -32,13 +32,13 @@
 
 #include "dyna_system.h"
 #include "pts.h"
+#include "snapshot.h"
 
 // ************************** //
 // non-inline member fuctions //
 // ************************** //
 
-DL_pts::DL_pts():DL_constraint(),
-  dcdp(1,3), dfdR(3,1) {
+DL_pts::DL_pts():DL_constraint() {
   dim=1;
   F->resize(dim); F->makezero();
   oldF->resize(dim); oldF->makezero();
@@ -72,7 +72,7 @@ void DL_pts::init(DL_geo* _g, DL_point* _p, DL_surface* _surf) {
   if (_g) _g->to_world(_p,&ptmp);
   else ptmp.assign(_p);
   if (!_surf->closeto(&ptmp,s,t)) {
-    DL_dsystem->get_companion()->Msg("Error: pts::init: initial surface position (%f,%f) is out of bounds\n pts-constraint not initialised\n",s,t);
+    DL_dsystem->get_companion()->Msg("Error: pts::init: initial surface position (%f,%f) is out of bounds\n pts-constraint not initialised\n",DL_value(s),DL_value(t));
     return;
   }
   olds=s; oldt=t;
@@ -132,12 +132,12 @@ void DL_pts::init(DL_geo* _g, DL_point* _p, DL_surface* _surf) {
   get_error(&lv);
   
   if (!st_inbounds) {
-    DL_dsystem->get_companion()->Msg("Error: pts::init: initial surface parameters (%f,%f) out of bounds\n pts-constraint not initialised\n",s,t);
+    DL_dsystem->get_companion()->Msg("Error: pts::init: initial surface parameters (%f,%f) out of bounds\n pts-constraint not initialised\n",DL_value(s),DL_value(t));
     return;
   }
   
   if (lv.get(0)>DL_constraints->max_error) {
-    DL_dsystem->get_companion()->Msg("Warning: initially invalid pts-constraint\n  Error: %f\n Initial surface parameters: (%f,%f)\n", lv.get(0), s, t);
+    DL_dsystem->get_companion()->Msg("Warning: initially invalid pts-constraint\n  Error: %f\n Initial surface parameters: (%f,%f)\n", DL_value(lv.get(0)), DL_value(s), DL_value(t));
   }
 
   // ok: we're in business:
@@ -179,39 +179,36 @@ void DL_pts::end_test(void) {
 }
 
 
-boolean DL_pts::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_pts::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  static DL_largematrix dcdf;
-  dcdf.resize(cc->dim,3);
+  DL_jacblock dcdf;
   boolean nonzero=FALSE;
   if (g_is_dyna) nonzero=cc->dCdFq((DL_dyna*)g,&p,&dcdf);
   if (sg_is_dyna) {
     if (nonzero) {
-      static DL_largematrix dcdfc;
-      dcdfc.resize(cc->dim,3);
+      DL_jacblock dcdfc;
       if (cc->dCdFq((DL_dyna*)(surf->get_geo()),&sstl,&dcdfc))
-        dcdf.minusis(&dcdfc);
+        dcdf.minusis(&dcdfc,cc->dim);
     }
     else {
       if (nonzero=cc->dCdFq((DL_dyna*)(surf->get_geo()),&sstl,&dcdf))
-         dcdf.neg();
+         dcdf.neg(cc->dim);
     }
   }
-  if (nonzero) dcdf.times(&dfdR,sub);
+  if (nonzero) dcdf.times(&dfdR,sub,cc->dim);
   return nonzero;
 }
 
-boolean DL_pts::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_pts::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdfq==0))
 // dcdfq has dimensions dim x 3
-  static DL_largematrix dpdfq(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -221,8 +218,7 @@ boolean DL_pts::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdfq.assign(&dpdX);
-    dcdp.times(&dpdfq,dcdfq);
+    dcdp.times(&dpdX,dcdfq);
     return TRUE;
   }
   if (dc==surf->get_geo()) { // which implies sg_is_dyna;
@@ -233,20 +229,18 @@ boolean DL_pts::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdfq.assign(&dpdX);
-    dpdfq.neg();
-    dcdp.times(&dpdfq,dcdfq);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdfq);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_pts::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_pts::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
 // dcdf has dimensions dim x 3
-  static DL_largematrix dpdf(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -256,8 +250,7 @@ boolean DL_pts::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dcdp.times(&dpdf,dcdf);
+    dcdp.times(&dpdX,dcdf);
     return TRUE;
   }
   if (dc==surf->get_geo()) { // which implies cg_is_dyna;
@@ -268,21 +261,19 @@ boolean DL_pts::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdf.assign(&dpdX);
-    dpdf.neg();
-    dcdp.times(&dpdf,dcdf);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdf);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_pts::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_pts::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dpdm==0))
 // dcdm has dimensions dim x 3
-  static DL_largematrix dpdm(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -292,8 +283,7 @@ boolean DL_pts::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dcdp.times(&dpdm,dcdm);
+    dcdp.times(&dpdX,dcdm);
     return TRUE;
   }
   if (dc==surf->get_geo()) { // which implies cg_is_dyna;
@@ -304,21 +294,19 @@ boolean DL_pts::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdm.assign(&dpdX);
-    dpdm.neg();
-    dcdp.times(&dpdm,dcdm);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdm);
     return TRUE;
   }
   return FALSE;
 }
 
-boolean DL_pts::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_pts::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
 // Returns if there is any effect at all (!result=>(dcdi==0))
 // dcdi has dimensions dim x 3
-  static DL_largematrix dpdi(3,3);
   DL_matrix dpdX;
   DL_matrix ddpdX;
   if (dc==g) { // there is an effect on C through g
@@ -328,8 +316,7 @@ boolean DL_pts::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dcdp.times(&dpdi,dcdi);
+    dcdp.times(&dpdX,dcdi);
     return TRUE;
   }
   if (dc==surf->get_geo()) { // which implies sg_is_dyna;
@@ -340,9 +327,8 @@ boolean DL_pts::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
       ddpdX.times(DL_dsystem->get_integrator()->halfstepsize(),&ddpdX);
       dpdX.plus(&ddpdX,&dpdX);
     }
-    dpdi.assign(&dpdX);
-    dpdi.neg();
-    dcdp.times(&dpdi,dcdi);
+    dpdX.timesis(-1.0);
+    dcdp.times(&dpdX,dcdi);
     return TRUE;
   }
   return FALSE;
@@ -518,3 +504,17 @@ void DL_pts::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_pts::save_state(DL_snapshot *snap) {
+  DL_constraint::save_state(snap);
+  // the surface parameters (and their previous values, used for
+  // extrapolating them):
+  snap->put(s); snap->put(olds); snap->put(t); snap->put(oldt);
+  snap->put(sf); snap->put(tf);
+}
+
+void DL_pts::restore_state(DL_snapshot *snap) {
+  DL_constraint::restore_state(snap);
+  s=snap->get(); olds=snap->get(); t=snap->get(); oldt=snap->get();
+  sf=snap->get(); tf=snap->get();
+}
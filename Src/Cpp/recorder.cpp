@@ -0,0 +1,289 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename     : recorder.cpp
+// description	: non-inline methods of class DL_recorder
+//
+
+#include <string.h>
+#include "recorder.h"
+#include "dyna.h"
+#include "constraint_manager.h"
+#include "vector4.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+DL_recorder::DL_recorder() {
+  f=NULL;
+  dynas=NULL;
+  cdim=ccol=NULL;
+  cserial=NULL;
+  ring=NULL;
+  out=NULL;
+  nrdynas=nrframes=0;
+}
+
+DL_recorder::~DL_recorder() {
+  close();
+}
+
+boolean DL_recorder::open(const char *filename, boolean compress, int bf) {
+  int i;
+  DL_List *cl;
+  close();
+  if (!DL_dsystem) return FALSE;
+  f=fopen(filename,"wb");
+  if (!f) {
+    DL_dsystem->get_companion()->Msg("Error: DL_recorder::open(): can not open %s\n",filename);
+    return FALSE;
+  }
+
+  // the dynas and constraints present now are the ones that are recorded:
+  nrdynas=DL_dsystem->dynas.length();
+  dynas=new DL_dyna*[nrdynas+1];
+  DL_dyna *d=(DL_dyna*)DL_dsystem->dynas.getfirst();
+  for (i=0;d;i++) {
+    dynas[i]=d;
+    d=(DL_dyna*)DL_dsystem->dynas.getnext(d);
+  }
+  memcpy(hdr.magic,"DLTR",4);
+  hdr.version=DL_RECORDING_VERSION;
+  hdr.nrdynas=nrdynas;
+  hdr.nrconstraints=0;
+  hdr.width=1+7*nrdynas;
+  hdr.blockframes=(bf<1 ? 1 : bf);
+  hdr.compressed=(compress ? 1 : 0);
+  hdr.reserved=0;
+  cl=(DL_constraints ? DL_constraints->get_constraints() : NULL);
+  if (cl) hdr.nrconstraints=cl->length();
+  cdim=new int[hdr.nrconstraints+1];
+  ccol=new int[hdr.nrconstraints+1];
+  cserial=new long[hdr.nrconstraints+1];
+  cindex.clear();
+  if (cl) {
+    DL_constraint *c=(DL_constraint*)cl->getfirst();
+    for (i=0;c;i++) {
+      cdim[i]=c->get_dim();
+      ccol[i]=hdr.width;
+      cserial[i]=c->serial;
+      cindex.insert(c,cdim+i);
+      hdr.width+=cdim[i];
+      c=(DL_constraint*)cl->getnext(c);
+    }
+  }
+  failed=((fwrite(&hdr,sizeof(DL_recording_header),1,f)!=1) ||
+	  ((int)fwrite(cdim,sizeof(int),hdr.nrconstraints,f)!=hdr.nrconstraints));
+
+  ring=new float[DL_RECORDER_BLOCKS*hdr.blockframes*hdr.width];
+  // worst case size of an encoded block: column offsets, and per column
+  // one float and 5 bytes for every other frame:
+  out=new unsigned char[hdr.width*(sizeof(int)+sizeof(float)+5*hdr.blockframes)];
+  fill=wblock=rblock=nrfull=nrframes=0;
+  closing=FALSE;
+#ifdef DL_RECORDER_THREAD
+  pthread_mutex_init(&lock,NULL);
+  pthread_cond_init(&cond,NULL);
+  if (pthread_create(&thread,NULL,writer,(void*)this)) {
+    DL_dsystem->get_companion()->Msg("Error: DL_recorder::open(): can not start the writer thread\n");
+    failed=TRUE;
+    closing=TRUE; // nothing to join
+  }
+#endif
+  if (failed) {
+    DL_dsystem->get_companion()->Msg("Error: DL_recorder::open(): can not write %s\n",filename);
+    close();
+    return FALSE;
+  }
+  return TRUE;
+}
+
+void DL_recorder::record(void) {
+  int i,j,k;
+  boolean fail;
+  if (!f) return;
+#ifdef DL_RECORDER_THREAD
+  pthread_mutex_lock(&lock);
+  fail=failed;
+  pthread_mutex_unlock(&lock);
+#else
+  fail=failed;
+#endif
+  if (fail) {
+    DL_dsystem->get_companion()->Msg("Error: DL_recorder: writing failed, recording stopped\n");
+    close();
+    return;
+  }
+  // the dynas must be the same ones, in the same order:
+  DL_dyna *d=(DL_dyna*)DL_dsystem->dynas.getfirst();
+  for (i=0;(i<nrdynas) && (d==dynas[i]);i++)
+    d=(DL_dyna*)DL_dsystem->dynas.getnext(d);
+  if ((i<nrdynas) || d) {
+    DL_dsystem->get_companion()->Msg("Error: DL_recorder: the set of dynas changed, recording stopped\n");
+    close();
+    return;
+  }
+
+  float *row=ring+(wblock*hdr.blockframes+fill)*hdr.width;
+  DL_vector4 q;
+  DL_point *p;
+  *(row++)=DL_value(DL_dsystem->time());
+  for (i=0;i<nrdynas;i++) {
+    p=dynas[i]->get_position();
+    q.from_matrix(dynas[i]->get_orientation());
+    row[0]=DL_value(p->x); row[1]=DL_value(p->y); row[2]=DL_value(p->z);
+    row[3]=DL_value(q.c[0]); row[4]=DL_value(q.c[1]);
+    row[5]=DL_value(q.c[2]); row[6]=DL_value(q.c[3]);
+    row+=7;
+  }
+  // the recorded constraints that are still in the list of the
+  // constraint manager (with the same dimension) are looked up from
+  // that list; the others (deleted, or set aside in a compound) are
+  // recorded as 0:
+  row-=1+7*nrdynas;
+  for (i=1+7*nrdynas;i<hdr.width;i++) row[i]=0;
+  if (hdr.nrconstraints>0) {
+    DL_List *cl=(DL_constraints ? DL_constraints->get_constraints() : NULL);
+    DL_constraint *c=(cl ? (DL_constraint*)cl->getfirst() : NULL);
+    int *e;
+    while (c) {
+      e=(int*)cindex.find(c);
+      if (e && (c->serial==cserial[e-cdim]) && c->active &&
+	  (c->get_dim()==*e)) {
+	DL_largevector *r=c->get_restriction();
+	k=ccol[e-cdim];
+	for (j=0;j<*e;j++) row[k+j]=DL_value(r->get(j));
+      }
+      c=(DL_constraint*)cl->getnext(c);
+    }
+  }
+  nrframes++;
+  if (++fill==hdr.blockframes) hand_over();
+}
+
+void DL_recorder::hand_over(void) {
+  blockframes[wblock]=fill;
+#ifdef DL_RECORDER_THREAD
+  if (!closing) {
+    pthread_mutex_lock(&lock);
+    nrfull++;
+    pthread_cond_broadcast(&cond);
+    // wait for a free block if the writer can not keep up:
+    while (nrfull==DL_RECORDER_BLOCKS) pthread_cond_wait(&cond,&lock);
+    pthread_mutex_unlock(&lock);
+  }
+  else if (!write_block(wblock)) failed=TRUE;
+#else
+  if (!write_block(wblock)) failed=TRUE;
+#endif
+  wblock=(wblock+1)%DL_RECORDER_BLOCKS;
+  fill=0;
+}
+
+#ifdef DL_RECORDER_THREAD
+void* DL_recorder::writer(void *r) {
+  DL_recorder *rec=(DL_recorder*)r;
+  boolean ok;
+  pthread_mutex_lock(&(rec->lock));
+  for (;;) {
+    while ((rec->nrfull==0) && !rec->closing)
+      pthread_cond_wait(&(rec->cond),&(rec->lock));
+    if (rec->nrfull==0) break; // closing and nothing left to write
+    pthread_mutex_unlock(&(rec->lock));
+    ok=rec->write_block(rec->rblock);
+    pthread_mutex_lock(&(rec->lock));
+    if (!ok) rec->failed=TRUE;
+    rec->rblock=(rec->rblock+1)%DL_RECORDER_BLOCKS;
+    rec->nrfull--;
+    pthread_cond_broadcast(&(rec->cond));
+  }
+  pthread_mutex_unlock(&(rec->lock));
+  return NULL;
+}
+#endif
+
+boolean DL_recorder::write_block(int b) {
+  int i,col,n=blockframes[b],w=hdr.width;
+  float *blk=ring+b*hdr.blockframes*w;
+  DL_recording_block bh;
+  bh.nrframes=n;
+  if (!hdr.compressed) {
+    // transpose the block into columns:
+    float *dst=(float*)out;
+    for (col=0;col<w;col++)
+      for (i=0;i<n;i++) *(dst++)=blk[i*w+col];
+    bh.nrbytes=w*n*sizeof(float);
+  }
+  else {
+    int *offset=(int*)out;
+    unsigned char *start=out+w*sizeof(int),*p=start;
+    unsigned int prev,cur,x;
+    for (col=0;col<w;col++) {
+      offset[col]=p-start;
+      memcpy(&prev,blk+col,sizeof(unsigned int));
+      memcpy(p,&prev,sizeof(unsigned int)); p+=sizeof(unsigned int);
+      for (i=1;i<n;i++) {
+	memcpy(&cur,blk+i*w+col,sizeof(unsigned int));
+	x=cur^prev;
+	prev=cur;
+	while (x>=0x80) {
+	  *(p++)=(unsigned char)((x&0x7f)|0x80);
+	  x>>=7;
+	}
+	*(p++)=(unsigned char)x;
+      }
+    }
+    bh.nrbytes=p-out;
+  }
+  return ((fwrite(&bh,sizeof(DL_recording_block),1,f)==1) &&
+	  ((int)fwrite(out,1,bh.nrbytes,f)==bh.nrbytes));
+}
+
+void DL_recorder::close(void) {
+  if (!f) return;
+  if (fill>0) hand_over();
+#ifdef DL_RECORDER_THREAD
+  if (!closing) {
+    pthread_mutex_lock(&lock);
+    closing=TRUE;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread,NULL);
+  }
+  pthread_mutex_destroy(&lock);
+  pthread_cond_destroy(&cond);
+#endif
+  fclose(f);
+  f=NULL;
+  delete[] dynas; dynas=NULL;
+  delete[] cdim; cdim=NULL;
+  delete[] ccol; ccol=NULL;
+  delete[] cserial; cserial=NULL;
+  cindex.clear();
+  delete[] ring; ring=NULL;
+  delete[] out; out=NULL;
+}
@@ -0,0 +1,248 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename     : recording.cpp
+// description	: non-inline methods of class DL_recording
+//
+
+#include <string.h>
+#include "recording.h"
+#include "vector4.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+DL_recording::DL_recording() {
+  f=NULL;
+  dims=cstart=NULL;
+  blockpos=NULL;
+  blockstart=blocksize=blockbytes=NULL;
+  buf=NULL; bufsize=0;
+  cache=NULL; cacheblock=-1;
+  nrblocks=nrframes=0;
+  memset(&hdr,0,sizeof(DL_recording_header));
+}
+
+DL_recording::~DL_recording() {
+  close();
+}
+
+void DL_recording::close(void) {
+  if (f) fclose(f);
+  f=NULL;
+  if (dims) delete[] dims;
+  if (cstart) delete[] cstart;
+  if (blockpos) delete[] blockpos;
+  if (blockstart) delete[] blockstart;
+  if (blocksize) delete[] blocksize;
+  if (blockbytes) delete[] blockbytes;
+  if (buf) delete[] buf;
+  if (cache) delete[] cache;
+  dims=cstart=NULL;
+  blockpos=NULL;
+  blockstart=blocksize=blockbytes=NULL;
+  buf=NULL; bufsize=0;
+  cache=NULL; cacheblock=-1;
+  nrblocks=nrframes=0;
+  memset(&hdr,0,sizeof(DL_recording_header));
+}
+
+boolean DL_recording::open(const char *filename) {
+  int i,maxblocks;
+  DL_recording_block b;
+  close();
+  f=fopen(filename,"rb");
+  if (!f) return FALSE;
+  if ((fread(&hdr,sizeof(DL_recording_header),1,f)!=1) ||
+      (memcmp(hdr.magic,"DLTR",4)!=0) || (hdr.version!=DL_RECORDING_VERSION) ||
+      (hdr.nrdynas<0) || (hdr.nrconstraints<0) || (hdr.width<1) ||
+      (hdr.blockframes<1)) {
+    close();
+    return FALSE;
+  }
+  dims=new int[hdr.nrconstraints+1];
+  cstart=new int[hdr.nrconstraints+1];
+  if ((int)fread(dims,sizeof(int),hdr.nrconstraints,f)!=hdr.nrconstraints) {
+    close();
+    return FALSE;
+  }
+  cstart[0]=1+7*hdr.nrdynas;
+  for (i=0;i<hdr.nrconstraints;i++) cstart[i+1]=cstart[i]+dims[i];
+
+  // build the index of the blocks:
+  maxblocks=16;
+  blockpos=new long[maxblocks];
+  blockstart=new int[maxblocks];
+  blocksize=new int[maxblocks];
+  blockbytes=new int[maxblocks];
+  while (fread(&b,sizeof(DL_recording_block),1,f)==1) {
+    if ((b.nrframes<1) || (b.nrframes>hdr.blockframes) || (b.nrbytes<0)) break;
+    if (nrblocks==maxblocks) {
+      long *np=new long[2*maxblocks];
+      int *ns=new int[2*maxblocks], *nf=new int[2*maxblocks], *nb=new int[2*maxblocks];
+      for (i=0;i<nrblocks;i++) {
+	np[i]=blockpos[i]; ns[i]=blockstart[i];
+	nf[i]=blocksize[i]; nb[i]=blockbytes[i];
+      }
+      delete[] blockpos; delete[] blockstart;
+      delete[] blocksize; delete[] blockbytes;
+      blockpos=np; blockstart=ns; blocksize=nf; blockbytes=nb;
+      maxblocks*=2;
+    }
+    blockpos[nrblocks]=ftell(f);
+    blockstart[nrblocks]=nrframes;
+    blocksize[nrblocks]=b.nrframes;
+    blockbytes[nrblocks]=b.nrbytes;
+    if (fseek(f,b.nrbytes,SEEK_CUR)) break;
+    nrframes+=b.nrframes;
+    nrblocks++;
+  }
+  // a block that was cut off (for example because the recording
+  // process crashed) is ignored:
+  if (nrblocks>0) {
+    fseek(f,0,SEEK_END);
+    long end=ftell(f);
+    while ((nrblocks>0) &&
+	   (blockpos[nrblocks-1]+blockbytes[nrblocks-1]>end)) {
+      nrblocks--;
+      nrframes-=blocksize[nrblocks];
+    }
+  }
+  cache=new float[hdr.blockframes*hdr.width];
+  return TRUE;
+}
+
+int DL_recording::find_block(int frame) {
+  int lo=0,hi=nrblocks-1,mid;
+  if ((frame<0) || (frame>=nrframes)) return -1;
+  while (lo<hi) {
+    mid=(lo+hi+1)/2;
+    if (blockstart[mid]<=frame) lo=mid;
+    else hi=mid-1;
+  }
+  return lo;
+}
+
+boolean DL_recording::read_block(int b) {
+  if (blockbytes[b]>bufsize) {
+    if (buf) delete[] buf;
+    bufsize=blockbytes[b];
+    buf=new unsigned char[bufsize];
+  }
+  if (fseek(f,blockpos[b],SEEK_SET)) return FALSE;
+  return ((int)fread(buf,1,blockbytes[b],f)==blockbytes[b]);
+}
+
+void DL_recording::decode_column(int b, int col, float *dst, int stride) {
+  int i,n=blocksize[b];
+  if (!hdr.compressed) {
+    float *src=((float*)buf)+col*n;
+    for (i=0;i<n;i++) dst[i*stride]=src[i];
+    return;
+  }
+  unsigned char *p=buf+hdr.width*sizeof(int)+((int*)buf)[col];
+  unsigned int prev,x;
+  int shift;
+  memcpy(&prev,p,sizeof(unsigned int)); p+=sizeof(unsigned int);
+  memcpy(dst,&prev,sizeof(float));
+  for (i=1;i<n;i++) {
+    x=0; shift=0;
+    do {
+      x|=((unsigned int)(*p&0x7f))<<shift;
+      shift+=7;
+    } while (*(p++)&0x80);
+    prev^=x;
+    memcpy(dst+i*stride,&prev,sizeof(float));
+  }
+}
+
+boolean DL_recording::decode_block(int b) {
+  int col;
+  if (b==cacheblock) return TRUE;
+  if (!read_block(b)) return FALSE;
+  for (col=0;col<hdr.width;col++) decode_column(b,col,cache+col,hdr.width);
+  cacheblock=b;
+  return TRUE;
+}
+
+boolean DL_recording::get_frame(int frame, float *values) {
+  int b=find_block(frame);
+  if ((b<0) || !decode_block(b)) return FALSE;
+  memcpy(values,cache+(frame-blockstart[b])*hdr.width,hdr.width*sizeof(float));
+  return TRUE;
+}
+
+boolean DL_recording::get_column(int col, float *values) {
+  // only the data of the column itself is decoded
+  int b;
+  if ((col<0) || (col>=hdr.width)) return FALSE;
+  for (b=0;b<nrblocks;b++) {
+    if (b==cacheblock) {
+      for (int i=0;i<blocksize[b];i++)
+	values[blockstart[b]+i]=cache[i*hdr.width+col];
+    }
+    else {
+      if (!read_block(b)) return FALSE;
+      decode_column(b,col,values+blockstart[b],1);
+    }
+  }
+  return TRUE;
+}
+
+DL_Scalar DL_recording::get_time(int frame) {
+  int b=find_block(frame);
+  if ((b<0) || !decode_block(b)) return 0;
+  return cache[(frame-blockstart[b])*hdr.width];
+}
+
+boolean DL_recording::get_position(int frame, int d, DL_point *p) {
+  int b=find_block(frame);
+  if ((d<0) || (d>=hdr.nrdynas) || (b<0) || !decode_block(b)) return FALSE;
+  float *v=cache+(frame-blockstart[b])*hdr.width+position_column(d);
+  p->init(v[0],v[1],v[2]);
+  return TRUE;
+}
+
+boolean DL_recording::get_orientation(int frame, int d, DL_matrix *m) {
+  int b=find_block(frame);
+  if ((d<0) || (d>=hdr.nrdynas) || (b<0) || !decode_block(b)) return FALSE;
+  float *v=cache+(frame-blockstart[b])*hdr.width+orientation_column(d);
+  DL_vector4 q;
+  q.init(v[0],v[1],v[2],v[3]);
+  q.normalize(); // the floats are not exactly normalized
+  q.to_matrix(m);
+  return TRUE;
+}
+
+boolean DL_recording::get_restriction(int frame, int c, DL_largevector *lv) {
+  int i,b=find_block(frame);
+  if ((c<0) || (c>=hdr.nrconstraints) || (b<0) || !decode_block(b)) return FALSE;
+  float *v=cache+(frame-blockstart[b])*hdr.width+cstart[c];
+  lv->resize(dims[c]);
+  for (i=0;i<dims[c];i++) lv->set(i,v[i]);
+  return TRUE;
+}
@@ -39,15 +39,14 @@
 
 void DL_rungekutta2::integrate(DL_supvec *y, DL_dyna *d, DL_supvec *ny) {
   DL_supvec k1, k2;
+  DL_supvec *k[2]={&k1,&k2};
+  DL_Scalar b[2]={1.0,1.0};
 
   d->ode(y,&k1,0.0);  // dfh==0, so use the constant instead of the attribute
-  k1.times(h,ny);
-  ny->plusis(y);
+  ny->plustimes(y,h,&k1);
   ny->q2A(d);
 
   d->ode(ny,&k2,0.0);
-  k1.plus(&k2,ny);
-  ny->timesis(halfh);
-  ny->plusis(y);
+  ny->pluslincomb(y,halfh,2,b,k);
   ny->q2A(d);
 }
@@ -39,32 +39,24 @@
 
 void DL_rungekutta4::integrate(DL_supvec *y, DL_dyna *d, DL_supvec *ny) {
   DL_supvec k1, k2, k3, k4;
+  DL_supvec *k[4]={&k1,&k2,&k3,&k4};
+  DL_Scalar b[4]={1.0,2.0,2.0,1.0};
 
   d->ode(y,&k1,0);  // dfh==0, so use the constant instead)
-  k1.times(halfh,ny);
-  ny->plusis(y);
+  ny->plustimes(y,halfh,&k1);
   ny->q2A(d);
 
   d->ode(ny,&k2,0);
-  k2.times(halfh,ny);
-  ny->plusis(y);
+  ny->plustimes(y,halfh,&k2);
   ny->q2A(d);
   
   d->ode(ny,&k3,0);
-  k3.times(h,ny);
-  ny->plusis(y);
+  ny->plustimes(y,h,&k3);
   ny->q2A(d);
 
   d->ode(ny,&k4,0);
 
-  k2.timesis(2);
-  k3.timesis(2);
-
-  k1.plus(&k2,ny);
-  ny->plusis(&k3);
-  ny->plusis(&k4);
-  ny->timesis((1.0/6.0)*h);
-  ny->plusis(y);
+  ny->pluslincomb(y,(1.0/6.0)*h,4,b,k);
 
   ny->q2A(d);
 }
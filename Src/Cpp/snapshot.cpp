@@ -0,0 +1,182 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename     : snapshot.cpp
+// description	: non-inline methods of class DL_snapshot
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "snapshot.h"
+#include "dyna_system.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+DL_snapshot::DL_snapshot() {
+  h=&hdr;
+  data=NULL;
+  maxvalues=0;
+  reset();
+}
+
+DL_snapshot::~DL_snapshot() {
+  if (maxvalues) delete[] data;
+}
+
+void DL_snapshot::reset(void) {
+  if (h!=&hdr) {
+    // detach from the image in memory
+    h=&hdr;
+    data=NULL;
+    maxvalues=0;
+  }
+  memcpy(hdr.magic,"DLSS",4);
+  hdr.version=DL_SNAPSHOT_VERSION;
+  hdr.scalarsize=sizeof(DL_Scalar);
+  hdr.nrdynas=hdr.nrconstraints=hdr.frame_nr=0;
+  hdr.nrvalues=hdr.reserved=0;
+  hdr.time=hdr.h=hdr.oldh=0;
+  pos=0;
+  readerror=FALSE;
+}
+
+void DL_snapshot::grow(int n) {
+  int newmax=2*maxvalues;
+  if (newmax<256) newmax=256;
+  if (newmax<n) newmax=n;
+  DL_Scalar *newdata=new DL_Scalar[newmax];
+  if (h->nrvalues) memcpy(newdata,data,h->nrvalues*sizeof(DL_Scalar));
+  if (maxvalues) delete[] data;
+  data=newdata;
+  maxvalues=newmax;
+}
+
+long DL_snapshot::image_size(void) {
+  return sizeof(DL_snapshot_header)+((long)h->nrvalues)*sizeof(DL_Scalar);
+}
+
+void DL_snapshot::begin_write(void) {
+  // keep the allocated values (if any) for reuse
+  reset();
+}
+
+void DL_snapshot::begin_read(void) {
+  pos=0;
+  readerror=FALSE;
+}
+
+void DL_snapshot::take(void) {
+  if (!DL_dsystem) return;
+  begin_write();
+  DL_dsystem->save_state(this);
+}
+
+boolean DL_snapshot::restore(void) {
+  if (!DL_dsystem) return FALSE;
+  if (empty()) {
+    DL_dsystem->get_companion()->Msg("Error: DL_snapshot::restore(): empty snapshot\n");
+    return FALSE;
+  }
+  begin_read();
+  return DL_dsystem->restore_state(this);
+}
+
+boolean DL_snapshot::save(const char *filename) {
+  FILE *f=fopen(filename,"wb");
+  if (!f) {
+    DL_dsystem->get_companion()->Msg("Error: DL_snapshot::save(): can not open %s\n",filename);
+    return FALSE;
+  }
+  boolean ok=(fwrite(h,sizeof(DL_snapshot_header),1,f)==1);
+  if (ok && h->nrvalues)
+    ok=(fwrite(data,sizeof(DL_Scalar),h->nrvalues,f)==(size_t)h->nrvalues);
+  if (fclose(f)) ok=FALSE;
+  if (!ok)
+    DL_dsystem->get_companion()->Msg("Error: DL_snapshot::save(): could not write %s\n",filename);
+  return ok;
+}
+
+boolean DL_snapshot::load(const char *filename) {
+  FILE *f=fopen(filename,"rb");
+  if (!f) {
+    DL_dsystem->get_companion()->Msg("Error: DL_snapshot::load(): can not open %s\n",filename);
+    return FALSE;
+  }
+  DL_snapshot_header fh;
+  boolean ok=(fread(&fh,sizeof(DL_snapshot_header),1,f)==1);
+  if (ok) ok=(memcmp(fh.magic,"DLSS",4)==0 && fh.version==DL_SNAPSHOT_VERSION &&
+	      fh.scalarsize==sizeof(DL_Scalar) && fh.nrvalues>=0);
+  if (ok) {
+    reset();
+    if (fh.nrvalues>maxvalues) grow(fh.nrvalues);
+    if (fh.nrvalues)
+      ok=(fread(data,sizeof(DL_Scalar),fh.nrvalues,f)==(size_t)fh.nrvalues);
+  }
+  fclose(f);
+  if (!ok) {
+    DL_dsystem->get_companion()->Msg("Error: DL_snapshot::load(): %s is not a valid snapshot\n",filename);
+    reset();
+    return FALSE;
+  }
+  hdr=fh;
+  return TRUE;
+}
+
+boolean DL_snapshot::attach(void *mem, long size) {
+  DL_snapshot_header *mh=(DL_snapshot_header*)mem;
+  if (!mem || size<(long)sizeof(DL_snapshot_header) ||
+      memcmp(mh->magic,"DLSS",4)!=0 || mh->version!=DL_SNAPSHOT_VERSION ||
+      mh->scalarsize!=sizeof(DL_Scalar) || mh->nrvalues<0 ||
+      size<(long)sizeof(DL_snapshot_header)+((long)mh->nrvalues)*(long)sizeof(DL_Scalar)) {
+    DL_dsystem->get_companion()->Msg("Error: DL_snapshot::attach(): not a valid snapshot image\n");
+    return FALSE;
+  }
+  if (maxvalues) delete[] data;
+  maxvalues=0;
+  h=mh;
+  data=(DL_Scalar*)(mh+1);
+  pos=0;
+  readerror=FALSE;
+  return TRUE;
+}
+
+void DL_snapshot::put(DL_largevector *lv) {
+  int i,n=lv->get_dim();
+  put((DL_Scalar)n);
+  for (i=0;i<n;i++) put(lv->get(i));
+}
+
+void DL_snapshot::get(DL_largevector *lv) {
+  int i,n=(int)DL_value(get());
+  if (n!=lv->get_dim()) {
+    // the vector does not belong to the same kind of object
+    readerror=TRUE;
+    return;
+  }
+  for (i=0;i<n;i++) lv->set(i,get());
+}
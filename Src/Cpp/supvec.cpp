@@ -43,23 +43,28 @@ DL_supvec::DL_supvec(){
   q.init(0,0,0,1);
   A.assign(1,0,0, 0,1,0, 0,0,1);
   w.init(0,0,0);
+  Adirty=FALSE;
 }
 
 DL_supvec::DL_supvec(DL_point* nz, DL_vector* nv,
                             DL_vector4* nq, DL_vector* nw, DL_matrix* nA) {
   z.assign(nz); v.assign(nv); q.assign(nq); w.assign(nw); A.assign(nA);
+  Adirty=FALSE;
 }
 
 void DL_supvec::init(DL_point* nz, DL_vector* nv,
                             DL_vector4* nq, DL_vector* nw, DL_matrix *nA) {
   z.assign(nz); v.assign(nv); q.assign(nq); w.assign(nw); A.assign(nA);
+  Adirty=FALSE;
 }
 
 void DL_supvec::assign(DL_supvec* sv) {
   if (sv) {
     z.assign(&(sv->z)); v.assign(&(sv->v));
     q.assign(&(sv->q)); w.assign(&(sv->w));
-    A.assign(&(sv->A));
+    // only copy A if it is valid: otherwise it is derived from q when needed
+    Adirty=sv->Adirty;
+    if (!Adirty) A.assign(&(sv->A));
   }
 }
 
@@ -70,39 +75,80 @@ void DL_supvec::plusis(DL_supvec* sv) {
   if (sv) {
     q.plusis(&(sv->q));
     w.plusis(&(sv->w));
+    Adirty=TRUE;
   }
 }
 
 void DL_supvec::timesis(DL_Scalar f) { 
   q.timesis(f);
   w.timesis(f);
+  Adirty=TRUE;
 }
 
 void DL_supvec::plus(DL_supvec* sv,DL_supvec *nv) { 
   if (sv) {
     q.plus(&(sv->q), &(nv->q));
     w.plus(&(sv->w), &(nv->w));
+    nv->Adirty=TRUE;
   }
 }
 
 void DL_supvec::times(DL_Scalar t, DL_supvec *nv) {
   q.times(t, &(nv->q));
   w.times(t, &(nv->w));
+  nv->Adirty=TRUE;
+}
+
+void DL_supvec::plustimes(DL_supvec *y, DL_Scalar a, DL_supvec *k) {
+// self:=y+a*k in a single pass. k may be self.
+  q.c[0]=a*k->q.c[0]+y->q.c[0];
+  q.c[1]=a*k->q.c[1]+y->q.c[1];
+  q.c[2]=a*k->q.c[2]+y->q.c[2];
+  q.c[3]=a*k->q.c[3]+y->q.c[3];
+  w.x=a*k->w.x+y->w.x;
+  w.y=a*k->w.y+y->w.y;
+  w.z=a*k->w.z+y->w.z;
+  Adirty=TRUE;
+}
+
+void DL_supvec::pluslincomb(DL_supvec *y, DL_Scalar a,
+			    int n, DL_Scalar *b, DL_supvec **k) {
+// self:=y+a*(b[0]*k[0]+...+b[n-1]*k[n-1]) in a single pass, summing in
+// the same order as the separate times/plusis calls did
+// PRE: n>0
+  DL_Scalar s[7];
+  int i;
+  s[0]=b[0]*k[0]->q.c[0]; s[1]=b[0]*k[0]->q.c[1];
+  s[2]=b[0]*k[0]->q.c[2]; s[3]=b[0]*k[0]->q.c[3];
+  s[4]=b[0]*k[0]->w.x; s[5]=b[0]*k[0]->w.y; s[6]=b[0]*k[0]->w.z;
+  for (i=1;i<n;i++) {
+    s[0]+=b[i]*k[i]->q.c[0]; s[1]+=b[i]*k[i]->q.c[1];
+    s[2]+=b[i]*k[i]->q.c[2]; s[3]+=b[i]*k[i]->q.c[3];
+    s[4]+=b[i]*k[i]->w.x; s[5]+=b[i]*k[i]->w.y; s[6]+=b[i]*k[i]->w.z;
+  }
+  q.c[0]=a*s[0]+y->q.c[0]; q.c[1]=a*s[1]+y->q.c[1];
+  q.c[2]=a*s[2]+y->q.c[2]; q.c[3]=a*s[3]+y->q.c[3];
+  w.x=a*s[4]+y->w.x; w.y=a*s[5]+y->w.y; w.z=a*s[6]+y->w.z;
+  Adirty=TRUE;
 }
 
 void DL_supvec::A2q() {
-  q.from_matrix(&A);
+  q.from_matrix(get_A());
 }
 
 void DL_supvec::q2A(DL_dyna *d) {
 // q.normalize();
- q.to_matrix(&A);
+// A itself is only recomputed when it is read (see get_A()), so the many
+// intermediate orientations of the integrators do not all need the
+// conversion:
+  Adirty=TRUE;
 
  // for 1D-objects the angular velocity should not have any components in the
  // direction of the object's axis. Since we changed the orientation of that
  // axis, we might have to adjust the angular velocity as well:
   if (d->get_oneD()!=0) {
     DL_vector *l;
+    get_A();
     if (d->get_oneD()==1) l=&(A.c0);
     if (d->get_oneD()==2) l=&(A.c1);
     if (d->get_oneD()==3) l=&(A.c2);
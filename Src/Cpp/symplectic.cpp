@@ -0,0 +1,75 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename     : symplectic.cpp
+// description	: non-inline methods of class DL_symplectic
+//
+
+#include "symplectic.h"
+#include "dyna.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+void DL_symplectic::integrate(DL_supvec *y, DL_dyna *d, DL_supvec *ny) {
+// first update the angular velocity using the torques at time t (this is
+// the only evaluation of the motion equations per step), then rotate the
+// orientation over the whole step around the average of the old and the
+// new angular velocity (like the analytical positional integration in
+// dyna, and like the derivatives used by the constraints assume).
+// The rotation uses the exponential map:
+//   q_{t+h}= cos(|wm|h/2) q_t + (2 sin(|wm|h/2)/|wm|) (wm#q_t)
+// which is exact for constant wm and keeps q at unit length.
+  DL_supvec k;
+  DL_vector wm;
+  DL_vector4 dq;
+  DL_Scalar wl, hw, c, s;
+
+  d->ode(y,&k,0.0);
+  k.w.times(halfh,&wm);
+  ny->w.assign(&wm);
+  ny->w.timesis(2.0);
+  ny->w.plusis(&(y->w));      // ny->w:=y->w + h*dw
+  wm.plusis(&(y->w));         // wm:=y->w + 0.5*h*dw
+
+  wl=wm.norm();
+  hw=wl*halfh;
+  if (hw<1e-6) { // use the limit for small rotations
+    c=1.0;
+    s=h;
+  }
+  else {
+    c=cos(hw);
+    s=2.0*sin(hw)/wl;
+  }
+  y->q.times(&wm,&dq);        // dq:=wm#(y->q)
+  y->q.times(c,&(ny->q));
+  dq.timesis(s);
+  ny->q.plusis(&dq);
+  ny->q2A(d);
+}
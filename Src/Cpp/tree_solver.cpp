@@ -0,0 +1,381 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename     : tree_solver.cpp
+// description	: non-inline methods of class DL_tree_solver
+//
+
+#include <math.h>
+#include "tree_solver.h"
+
+// ************************** //
+// non-inline member fuctions //
+// ************************** //
+
+DL_tree_solver::DL_tree_solver() {
+  n=size=maxdim=nrfill=valsize=0;
+  bidx=bdim=blockat=NULL;
+  nrnb=nbsize=NULL; nb=NULL;
+  order=pos=upstart=up=NULL;
+  doff=uoff=loff=NULL;
+  val=tmp=NULL;
+}
+
+DL_tree_solver::~DL_tree_solver() {
+  clear();
+}
+
+void DL_tree_solver::clear(void) {
+  int i;
+  if (nb) {
+    for (i=0;i<n;i++) if (nb[i]) delete[] nb[i];
+    delete[] nb; nb=NULL;
+  }
+  if (nrnb) { delete[] nrnb; nrnb=NULL; }
+  if (nbsize) { delete[] nbsize; nbsize=NULL; }
+  if (bidx) { delete[] bidx; bidx=NULL; }
+  if (bdim) { delete[] bdim; bdim=NULL; }
+  if (blockat) { delete[] blockat; blockat=NULL; }
+  if (order) { delete[] order; order=NULL; }
+  if (pos) { delete[] pos; pos=NULL; }
+  if (upstart) { delete[] upstart; upstart=NULL; }
+  if (up) { delete[] up; up=NULL; }
+  if (doff) { delete[] doff; doff=NULL; }
+  if (uoff) { delete[] uoff; uoff=NULL; }
+  if (loff) { delete[] loff; loff=NULL; }
+  if (val) { delete[] val; val=NULL; }
+  if (tmp) { delete[] tmp; tmp=NULL; }
+  n=size=maxdim=nrfill=valsize=0;
+}
+
+void DL_tree_solver::init(int nrblocks, int dimension) {
+  int i;
+  clear();
+  n=nrblocks;
+  size=dimension;
+  if (n>0) {
+    bidx=new int[n];
+    bdim=new int[n];
+    nrnb=new int[n];
+    nbsize=new int[n];
+    nb=new int*[n];
+    for (i=0;i<n;i++) {
+      bidx[i]=bdim[i]=nrnb[i]=nbsize[i]=0;
+      nb[i]=NULL;
+    }
+  }
+  if (size>0) {
+    blockat=new int[size];
+    for (i=0;i<size;i++) blockat[i]=-1;
+  }
+}
+
+void DL_tree_solver::setblock(int b, int index, int dim) {
+// PRE: 0<=b<n && dim>0 && index+dim<=size
+  bidx[b]=index;
+  bdim[b]=dim;
+  blockat[index]=b;
+  if (dim>maxdim) maxdim=dim;
+}
+
+void DL_tree_solver::addnb(int i, int j) {
+  if (nrnb[i]==nbsize[i]) {
+    int *newnb=new int[nbsize[i]=(nbsize[i]>0 ? 2*nbsize[i] : 4)];
+    for (int k=0;k<nrnb[i];k++) newnb[k]=nb[i][k];
+    if (nb[i]) delete[] nb[i];
+    nb[i]=newnb;
+  }
+  nb[i][nrnb[i]++]=j;
+}
+
+boolean DL_tree_solver::hasnb(int i, int j) {
+  for (int k=0;k<nrnb[i];k++) if (nb[i][k]==j) return TRUE;
+  return FALSE;
+}
+
+void DL_tree_solver::connect(int index0, int index1) {
+  int b0=blockat[index0];
+  int b1=blockat[index1];
+  if ((b0<0) || (b1<0) || (b0==b1)) return;
+  if (!hasnb(b0,b1)) {
+    addnb(b0,b1);
+    addnb(b1,b0);
+  }
+}
+
+int DL_tree_solver::get_blockband(void) {
+// PRE: analyse() has not been called yet since init()
+  int i,k,bw=0;
+  for (i=0;i<n;i++)
+    for (k=0;k<nrnb[i];k++)
+      if (nb[i][k]-i>bw) bw=nb[i][k]-i;
+  return bw;
+}
+
+void DL_tree_solver::analyse(boolean reorder) {
+// Eliminate the blocks one by one. Blocks with at most one neighbour
+// left (the joints at the leaves of a tree) are eliminated first: that
+// creates no new blocks, and eliminating one can only turn its
+// neighbour into such a block, so for a tree structured graph this
+// takes time linear in the number of blocks. They are kept on a stack
+// that starts with the lowest numbers on top, so a chain is eliminated
+// by number. Only when there are none (loops), the block whose
+// neighbours are connected the best (so the elimination creates the
+// least new blocks) is picked, and the one with the least neighbours of
+// those. Without reordering the blocks are eliminated by number (for a
+// block banded matrix the fill-in stays within the band).
+  int i,j,k,p,t,best,bestfill,bestdeg,fill,upsize=0,nrleaves=0;
+  boolean *done=new boolean[n];
+  boolean *stacked=new boolean[n];
+  int *leaves=new int[n>0 ? n : 1];
+  for (i=0;i<n;i++) done[i]=stacked[i]=FALSE;
+  order=new int[n];
+  pos=new int[n];
+  upstart=new int[n+1];
+  for (i=0;i<n;i++) upsize+=nrnb[i];
+  up=new int[upsize>0 ? upsize : 1];
+  nrfill=0; t=0;
+  if (reorder)
+    for (i=n-1;i>=0;i--)
+      if (nrnb[i]<=1) { leaves[nrleaves++]=i; stacked[i]=TRUE; }
+
+  for (p=0;p<n;p++) {
+    best=(reorder ? -1 : p); bestfill=bestdeg=0;
+    if (reorder && (nrleaves>0)) best=leaves[--nrleaves];
+    else for (i=0;reorder && (i<n);i++) {
+      if (done[i]) continue;
+      fill=0;
+      for (j=0;(j<nrnb[i]) && ((best<0) || (fill<=bestfill));j++)
+	for (k=j+1;k<nrnb[i];k++)
+	  if (!hasnb(nb[i][j],nb[i][k])) fill++;
+      if ((best<0) || (fill<bestfill) ||
+	  ((fill==bestfill) && (nrnb[i]<bestdeg))) {
+	best=i; bestfill=fill; bestdeg=nrnb[i];
+      }
+    }
+    i=best;
+    order[p]=i; pos[i]=p; done[i]=TRUE;
+    upstart[p]=t;
+    if (t+nrnb[i]>upsize) { // fill-in made the up-array too small
+      int *newup=new int[upsize=2*(t+nrnb[i])];
+      for (j=0;j<t;j++) newup[j]=up[j];
+      delete[] up;
+      up=newup;
+    }
+    // the remaining neighbours become connected:
+    for (j=0;j<nrnb[i];j++) {
+      up[t++]=nb[i][j];
+      for (k=j+1;k<nrnb[i];k++)
+	if (!hasnb(nb[i][j],nb[i][k])) {
+	  addnb(nb[i][j],nb[i][k]);
+	  addnb(nb[i][k],nb[i][j]);
+	  nrfill++;
+	}
+    }
+    // and i is removed from the graph (which may make new leaves):
+    for (j=0;j<nrnb[i];j++) {
+      int nbj=nb[i][j];
+      for (k=0;k<nrnb[nbj];k++)
+	if (nb[nbj][k]==i) { nb[nbj][k]=nb[nbj][--nrnb[nbj]]; break; }
+      if (reorder && (nrnb[nbj]<=1) && !stacked[nbj]) {
+	leaves[nrleaves++]=nbj; stacked[nbj]=TRUE;
+      }
+    }
+  }
+  upstart[n]=t;
+  delete[] done;
+  delete[] stacked;
+  delete[] leaves;
+
+  // the graph is not needed anymore:
+  for (i=0;i<n;i++) if (nb[i]) delete[] nb[i];
+  delete[] nb; nb=NULL;
+  delete[] nrnb; nrnb=NULL;
+  delete[] nbsize; nbsize=NULL;
+
+  // lay out the blocks:
+  doff=new int[n];
+  uoff=new int[t>0 ? t : 1];
+  loff=new int[t>0 ? t : 1];
+  valsize=0;
+  for (p=0;p<n;p++) {
+    i=order[p];
+    doff[i]=valsize;
+    valsize+=bdim[i]*bdim[i];
+    for (k=upstart[p];k<upstart[p+1];k++) {
+      uoff[k]=valsize;
+      loff[k]=valsize+bdim[i]*bdim[up[k]];
+      valsize+=2*bdim[i]*bdim[up[k]];
+    }
+  }
+  val=new DL_Scalar[valsize>0 ? valsize : 1];
+  tmp=new DL_Scalar[maxdim*maxdim+maxdim+1];
+}
+
+DL_Scalar *DL_tree_solver::block(int j, int k) {
+// returns the (j,k) block of the factors, for neighbours j!=k
+  int t,p;
+  if (pos[j]<pos[k]) {
+    p=pos[j];
+    for (t=upstart[p];t<upstart[p+1];t++) if (up[t]==k) return val+uoff[t];
+  }
+  else {
+    p=pos[k];
+    for (t=upstart[p];t<upstart[p+1];t++) if (up[t]==j) return val+loff[t];
+  }
+  return NULL;
+}
+
+boolean DL_tree_solver::invert(DL_Scalar *d, int dim) {
+// invert the dim x dim block d in place (Gauss-Jordan elimination with
+// partial pivoting). Returns FALSE if the block is (near) singular.
+  register int r,c,m;
+  register DL_Scalar f;
+  DL_Scalar *a=tmp, mx=0.0;
+  for (r=0;r<dim*dim;r++) {
+    a[r]=d[r];
+    d[r]=0.0;
+    if (fabs(a[r])>mx) mx=fabs(a[r]);
+  }
+  for (r=0;r<dim;r++) d[r*dim+r]=1.0;
+  DL_Scalar tol=mx*dim*DL_SCALAR_EPSILON;
+  if (mx==0.0) return FALSE;
+  for (c=0;c<dim;c++) {
+    int pr=c;
+    for (r=c+1;r<dim;r++) if (fabs(a[r*dim+c])>fabs(a[pr*dim+c])) pr=r;
+    if (fabs(a[pr*dim+c])<=tol) return FALSE;
+    if (pr!=c)
+      for (m=0;m<dim;m++) {
+	f=a[pr*dim+m]; a[pr*dim+m]=a[c*dim+m]; a[c*dim+m]=f;
+	f=d[pr*dim+m]; d[pr*dim+m]=d[c*dim+m]; d[c*dim+m]=f;
+      }
+    f=1.0/a[c*dim+c];
+    for (m=0;m<dim;m++) { a[c*dim+m]*=f; d[c*dim+m]*=f; }
+    for (r=0;r<dim;r++) {
+      if ((r==c) || ((f=a[r*dim+c])==0.0)) continue;
+      DL_plus_times(dim-c,-f,a+c*dim+c,a+r*dim+c);
+      DL_plus_times(dim,-f,d+c*dim,d+r*dim);
+    }
+  }
+  return TRUE;
+}
+
+boolean DL_tree_solver::factor(DL_largematrix *A) {
+// PRE: analyse() has been called for the structure of A &&
+//      A->rep==full/riss
+  int p,t,s,i,j,k,r,c,m,di,dj,dk;
+  DL_Scalar *D,*L,*U,*T,*row=tmp+maxdim*maxdim;
+
+  // copy the blocks from A:
+  for (p=0;p<n;p++) {
+    i=order[p]; di=bdim[i];
+    D=val+doff[i];
+    for (r=0;r<di;r++)
+      for (c=0;c<di;c++) D[r*di+c]=A->get(bidx[i]+r,bidx[i]+c);
+    for (t=upstart[p];t<upstart[p+1];t++) {
+      j=up[t]; dj=bdim[j];
+      U=val+uoff[t]; L=val+loff[t];
+      for (r=0;r<di;r++)
+	for (c=0;c<dj;c++) U[r*dj+c]=A->get(bidx[i]+r,bidx[j]+c);
+      for (r=0;r<dj;r++)
+	for (c=0;c<di;c++) L[r*di+c]=A->get(bidx[j]+r,bidx[i]+c);
+    }
+  }
+
+  // eliminate the blocks in order:
+  for (p=0;p<n;p++) {
+    i=order[p]; di=bdim[i];
+    D=val+doff[i];
+    if (!invert(D,di)) return FALSE;
+    // L(j,i):=A(j,i) D(i)^-1
+    for (t=upstart[p];t<upstart[p+1];t++) {
+      dj=bdim[up[t]];
+      L=val+loff[t];
+      for (r=0;r<dj;r++) {
+	for (m=0;m<di;m++) { row[m]=L[r*di+m]; L[r*di+m]=0.0; }
+	for (m=0;m<di;m++) DL_plus_times(di,row[m],D+m*di,L+r*di);
+      }
+    }
+    // A(j,k):=A(j,k)-L(j,i)A(i,k) for the remaining neighbours j and k:
+    for (t=upstart[p];t<upstart[p+1];t++) {
+      j=up[t]; dj=bdim[j];
+      L=val+loff[t];
+      for (s=upstart[p];s<upstart[p+1];s++) {
+	k=up[s]; dk=bdim[k];
+	U=val+uoff[s];
+	T=(j==k ? val+doff[j] : block(j,k));
+	for (r=0;r<dj;r++)
+	  for (m=0;m<di;m++)
+	    DL_plus_times(dk,-L[r*di+m],U+m*dk,T+r*dk);
+      }
+    }
+  }
+  return TRUE;
+}
+
+void DL_tree_solver::solve(DL_largevector *x, DL_largevector *b) {
+// PRE: factor() has succeeded && x!=b && b->dim==size
+  int p,t,i,j,r,m,di,dj;
+  DL_Scalar *L,*U,*D,*xi,*xj;
+  register DL_Scalar sum;
+
+  x->assign(b);
+  // forward substitution with the lower factor:
+  for (p=0;p<n;p++) {
+    i=order[p]; di=bdim[i];
+    xi=x->v+bidx[i];
+    for (t=upstart[p];t<upstart[p+1];t++) {
+      j=up[t]; dj=bdim[j];
+      L=val+loff[t];
+      xj=x->v+bidx[j];
+      for (r=0;r<dj;r++) {
+	sum=0.0;
+	for (m=0;m<di;m++) sum+=L[r*di+m]*xi[m];
+	xj[r]-=sum;
+      }
+    }
+  }
+  // backward substitution with the upper factor:
+  for (p=n-1;p>=0;p--) {
+    i=order[p]; di=bdim[i];
+    xi=x->v+bidx[i];
+    for (r=0;r<di;r++) tmp[r]=xi[r];
+    for (t=upstart[p];t<upstart[p+1];t++) {
+      j=up[t]; dj=bdim[j];
+      U=val+uoff[t];
+      xj=x->v+bidx[j];
+      for (r=0;r<di;r++)
+	for (m=0;m<dj;m++) tmp[r]-=U[r*dj+m]*xj[m];
+    }
+    D=val+doff[i];
+    for (r=0;r<di;r++) {
+      sum=0.0;
+      for (m=0;m<di;m++) sum+=D[r*di+m]*tmp[m];
+      xi[r]=sum;
+    }
+  }
+}
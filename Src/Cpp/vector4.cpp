@@ -46,15 +46,6 @@ void DL_vector4::init(DL_Scalar n0, DL_Scalar n1, DL_Scalar n2, DL_Scalar n3) {
   c[0]=n0; c[1]=n1; c[2]=n2; c[3]=n3;
 }
 
-void DL_vector4::assign(DL_vector4* v) {
-  if (v) {
-    c[0]=v->c[0]; 
-    c[1]=v->c[1]; 
-    c[2]=v->c[2]; 
-    c[3]=v->c[3];
-  }
-}
-
 DL_Scalar DL_vector4::norm() {
   return (::sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2] + c[3]*c[3]));
 }
@@ -77,22 +68,6 @@ DL_Scalar DL_vector4::inprod(DL_vector4* v) {
   else return 0;
 }
 
-void DL_vector4::plusis(DL_vector4* v) { 
-  if (v) {
-    c[0] += v->c[0]; 
-    c[1] += v->c[1]; 
-    c[2] += v->c[2]; 
-    c[3] += v->c[3]; 
-  }
-}
-
-void DL_vector4::timesis(DL_Scalar f) { 
-    c[0] *= f; 
-    c[1] *= f; 
-    c[2] *= f; 
-    c[3] *= f; 
-}
-
 void DL_vector4::timesis(DL_vector4* v) { 
     c[0] *= v->c[0]; 
     c[1] *= v->c[1]; 
@@ -118,20 +93,6 @@ void DL_vector4::set(int r,DL_Scalar f) {
 }
 
 
-void DL_vector4::plus(DL_vector4* v,DL_vector4 *nv) { 
-  nv->c[0]=c[0] + v->c[0];
-  nv->c[1]=c[1] + v->c[1];
-  nv->c[2]=c[2] + v->c[2];
-  nv->c[3]=c[3] + v->c[3];
-}
-
-void DL_vector4::minus(DL_vector4 *v,DL_vector4 *nv) { 
-  nv->c[0]=c[0] - v->c[0];
-  nv->c[1]=c[1] - v->c[1];
-  nv->c[2]=c[2] - v->c[2];
-  nv->c[3]=c[3] - v->c[3];
-}
-
 void DL_vector4::neg(DL_vector4 *nv) {         
   nv->c[0]=-c[0];
   nv->c[1]=-c[1];
@@ -139,25 +100,6 @@ void DL_vector4::neg(DL_vector4 *nv) {
   nv->c[3]=-c[3];
 }
 
-void DL_vector4::times(DL_Scalar t, DL_vector4 *nv) {
-  nv->c[0]=c[0]*t;
-  nv->c[1]=c[1]*t;
-  nv->c[2]=c[2]*t;
-  nv->c[3]=c[3]*t;
-}
-
-void DL_vector4::times(DL_vector* w,DL_vector4* nv) {
-  //                  1 ( 0  -w^T )
-  // implements nv:= ---(         ) self  , where w~ is the outer produkt
-  //                  2 ( w  -w~  )         matrix
-  //                    (         )
-
-  nv->c[0] = -0.5*(            w->x*c[1] + w->y*c[2] + w->z*c[3]);
-  nv->c[1] =  0.5*(w->x*c[0]             + w->z*c[2] - w->y*c[3]);
-  nv->c[2] =  0.5*(w->y*c[0] - w->z*c[1]             + w->x*c[3]);
-  nv->c[3] =  0.5*(w->z*c[0] + w->y*c[1] - w->x*c[2]            );
-}
-
 void DL_vector4::to_matrix(DL_matrix* m){
 // PRE: |self|==1
   m->c0.x=2.0*(c[0]*c[0]+c[1]*c[1])-1.0;
@@ -79,7 +79,7 @@ void DL_vtv::init(DL_dyna* _d, DL_point* _pd, DL_geo* _g, DL_point* _pg) {
   get_error(&lv);
   if (lv.norm()>DL_constraints->max_error) {
     DL_dsystem->get_companion()->Msg("Warning: initially invalid vtv-constraint.\n  error: (%f,%f,%f)\n",
-				  lv.get(0), lv.get(1), lv.get(2) );
+				  DL_value(lv.get(0)), DL_value(lv.get(1)), DL_value(lv.get(2)) );
   }
 }
 
@@ -99,24 +99,25 @@ void DL_vtv::end_test(void) {
   if (g_is_dyna) ((DL_dyna*)g)->endtest();
 }
 
-boolean DL_vtv::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_vtv::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  boolean nonzero=cc->dCdFq(d,&pd,sub);
+  DL_jacblock dcdf,subtemp;
+  boolean nonzero=cc->dCdFq(d,&pd,&dcdf);
   if (g_is_dyna) {
     if (nonzero) {
-      DL_largematrix subtemp(cc->dim,3);
-      if (cc->dCdFq((DL_dyna*)g,&pg,&subtemp)) sub->minusis(&subtemp);
+      if (cc->dCdFq((DL_dyna*)g,&pg,&subtemp)) dcdf.minusis(&subtemp,cc->dim);
     }
-    else if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,sub)) sub->neg();
+    else if (nonzero=cc->dCdFq((DL_dyna*)g,&pg,&dcdf)) dcdf.neg(cc->dim);
   }
+  if (nonzero) sub->setsubmatrix(0,0,&dcdf,cc->dim);
   return nonzero;
 }
 
-boolean DL_vtv::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_vtv::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
@@ -137,7 +138,7 @@ boolean DL_vtv::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
   return FALSE;
 }
 
-boolean DL_vtv::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_vtv::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
@@ -157,7 +158,7 @@ boolean DL_vtv::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
   return FALSE;
 }
 
-boolean DL_vtv::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_vtv::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
@@ -178,7 +179,7 @@ boolean DL_vtv::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
   return FALSE;
 }
 
-boolean DL_vtv::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_vtv::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
@@ -285,3 +286,17 @@ void DL_vtv::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_vtv::remap(DL_dyna *from, DL_dyna *to, DL_matrix *R, DL_vector *o) {
+  DL_point p;
+  if (d==from) {
+    R->times(&pd,&p);
+    p.plus(o,&pd);
+    d=to;
+  }
+  if (g==from) {
+    R->times(&pg,&p);
+    p.plus(o,&pg);
+    g=to;
+  }
+}
@@ -32,6 +32,7 @@
 
 #include "dyna_system.h"
 #include "wheel.h"
+#include "snapshot.h"
 
 // defines: WA2 causes the correction of the attachment point at the wheel
 // (by linear estimate of the position halfway the next frame)
@@ -154,28 +155,29 @@ void DL_wheel::end_test(void) {
   wa=wasave;
 }
 
-boolean DL_wheel::dCdRsub(DL_constraint *cc, DL_largematrix *sub){
+boolean DL_wheel::dCdRsub(DL_constraint *cc, DL_subblock *sub){
 // return the submatrix of dCdR that shows the relation between
 // the restriction value of this constraint and the constraint
 // error of the constraint supplied as parameter
 // the dimension of sub is cc->dim x dim;
 // Returns if there is any effect at all (!result=>(m==0))
-  boolean nonzero=cc->dCdFq(w,&wpc,sub);
+  DL_jacblock dcdf,subtemp;
+  boolean nonzero=cc->dCdFq(w,&wpc,&dcdf);
   if (sg_is_dyna) {
     if (nonzero) {
-      DL_largematrix *subtemp=new DL_largematrix(cc->dim,3);
-      if (cc->dCdFq((DL_dyna*)(surf->get_geo()),&spc,subtemp))
-            sub->minusis(subtemp);
-      delete subtemp;
+      if (cc->dCdFq((DL_dyna*)(surf->get_geo()),&spc,&subtemp))
+            dcdf.minusis(&subtemp,cc->dim);
     }
     else {
-      if (nonzero=cc->dCdFq((DL_dyna*)(surf->get_geo()),&spc,sub)) sub->neg();
+      if (nonzero=cc->dCdFq((DL_dyna*)(surf->get_geo()),&spc,&dcdf))
+            dcdf.neg(cc->dim);
     }
   }
+  if (nonzero) sub->setsubmatrix(0,0,&dcdf,cc->dim);
   return nonzero;
 }
 
-boolean DL_wheel::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
+boolean DL_wheel::dCdFq(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdfq) {
 // calculate the matrix that shows the effect of application of a
 // (non-central) force to the point of the dyna on the constraint
 // error of this constraint.
@@ -223,7 +225,7 @@ boolean DL_wheel::dCdFq(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdfq) {
   return FALSE;
 }
 
-boolean DL_wheel::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
+boolean DL_wheel::dCdF(DL_dyna *dc, DL_jacblock *dcdf) {
 // calculate the matrix that shows the effect of application of a
 // central force to the dyna on the constraint error of this constraint.
 // Returns if there is any effect at all (!result=>(dcdf==0))
@@ -270,7 +272,7 @@ boolean DL_wheel::dCdF(DL_dyna *dc, DL_largematrix *dcdf) {
   return FALSE;
 }
 
-boolean DL_wheel::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
+boolean DL_wheel::dCdM(DL_dyna *dc, DL_jacblock *dcdm) {
 // calculate the matrix that shows the effect of
 // application of a torque to the dyna on the
 // constraint error of this constraint.
@@ -318,7 +320,7 @@ boolean DL_wheel::dCdM(DL_dyna *dc, DL_largematrix *dcdm) {
   return FALSE;
 }
 
-boolean DL_wheel::dCdI(DL_dyna *dc, DL_point *pc, DL_largematrix *dcdi) {
+boolean DL_wheel::dCdI(DL_dyna *dc, DL_point *pc, DL_jacblock *dcdi) {
 // calculate the matrix that shows the effect of application of an
 // impulse to the point of the dyna on the constraint error of this
 // constraint.
@@ -546,14 +548,13 @@ void DL_wheel::test_restriction_changes(DL_largevector* lv) {
     // possibly raise an event here
   }
   if (maxforce>0) {
-    DL_largevector* Fnew=new DL_largevector(dim);
-    F->plus(lv,Fnew);
-    if (Fnew->norm()>maxforce) {
+    DL_largevector Fnew(dim);
+    F->plus(lv,&Fnew);
+    if (Fnew.norm()>maxforce) {
       deactivate();
       // possibly raise an event here
       DL_dsystem->get_companion()->Msg("Too large a reaction force: wheel-constraint deactivated\n");
     }
-    delete Fnew;
   }
 }
 
@@ -666,3 +667,17 @@ void DL_wheel::get_force_info(int i, DL_actuator_type& at,
   }
   at=none;
 };
+
+void DL_wheel::save_state(DL_snapshot *snap) {
+  DL_constraint::save_state(snap);
+  // the positions on the wheel and the surface (and their previous
+  // values, used for extrapolating them):
+  snap->put(wa); snap->put(oldwa); snap->put(sa);
+  snap->put(s); snap->put(t); snap->put(olds); snap->put(oldt);
+}
+
+void DL_wheel::restore_state(DL_snapshot *snap) {
+  DL_constraint::restore_state(snap);
+  wa=snap->get(); oldwa=snap->get(); sa=snap->get();
+  s=snap->get(); t=snap->get(); olds=snap->get(); oldt=snap->get();
+}
@@ -51,7 +51,8 @@ protected:
   DL_vector dpgw;  // velocity of pg (in wc; used only if !g_is_dyna) 
   boolean g_is_dyna;
   DL_Scalar l, lsqr; // the length and the square of the length of the bar
-  DL_largematrix dcdp, dfdr;
+  DL_fixmat<1,3> dcdp;
+  DL_fixmat<3,1> dfdr;
   
 public:
   /// externally accessible:
@@ -91,33 +92,33 @@ public:
                      // the dyna's that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
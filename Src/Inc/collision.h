@@ -49,7 +49,8 @@ protected:
   DL_Scalar p;          // relative positional target
   DL_vector n;      // collision normal (in wc)
   boolean g0_is_dyna, g1_is_dyna;
-  DL_largematrix dcdX,dXdR;
+  DL_fixmat<1,3> dcdX;
+  DL_fixmat<3,1> dXdR;
 
   void init(DL_geo*, DL_point*,
 	    DL_geo*, DL_point*,
@@ -63,6 +64,11 @@ public:
 		          DL_vector*, int=0); // constructor;
 	     ~DL_collision(){};        // destructor
 
+  // collisions are created (by the collision detection) and deleted
+  // (in post_processing) every frame, so they are allocated from a pool:
+  void* operator new(size_t);
+  void  operator delete(void*,size_t);
+
   /// for internal (DL) use only:
   // methods for empirical dC/dR determination:
   virtual void begin_test(void);
@@ -74,33 +80,33 @@ public:
                      // the dyna's that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
@@ -114,6 +120,11 @@ public:
                      // calculate the constraint error vector
   virtual void post_processing(void);
                      // wrap up the calculations for this frame
+  virtual boolean remappable(void){ return TRUE; }
+  virtual boolean is_collision(void){ return TRUE; }
+  virtual void remap(DL_dyna*, DL_dyna*, DL_matrix*, DL_vector*);
+                     // move the constraint from a dyna to a compound
+		     // (see DL_constraint::remap)
   // for NOT (un)registering with the force_drawer:
   virtual void show_forces(void){};
   virtual void hide_forces(void){};
@@ -0,0 +1,106 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename	: compound.h
+// description	: rigid compounds of welded dynas. Dynas that are welded
+//                together by connectors move as one rigid body, so the
+//                constraint manager can replace them by a single dyna
+//                with their combined mass and inertia (see
+//                DL_constraint_manager::merge_welds). The members of a
+//                compound follow its motion and pass the loads applied
+//                to them on to it. The constraints between members are
+//                set aside, and the other constraints of the members
+//                are remapped to the compound, until it is split up
+//                again.
+//
+
+#ifndef DL_COMPOUNDH
+#define DL_COMPOUNDH
+
+#include "dyna.h"
+#include "connector.h"
+
+// ***************** //
+// class DL_compound //
+// ***************** //
+
+class DL_compound : public DL_dyna {
+  protected:
+    int            nrmembers;
+    DL_dyna*      *member;  // the members, in breadth first order: member
+    int           *parent;  // i>0 is welded to member parent[i] by
+    DL_connector* *weld;    // weld[i]
+    DL_constraint* *remapped; // the constraints remapped to the compound,
+    DL_dyna*      *remapdyna; // from member remapdyna[i]
+    int            nrremapped;
+    int            size_remapped;
+    DL_vector     *wP, *wK; // scratch for weld_load
+    DL_Scalar      lastload; // the estimate of the previous frame
+
+    void      combine(void);
+                  // derive mass, inertia and motion state from the members
+    void      probe_loads(DL_constraint*,DL_vector*,DL_vector*);
+                  // the impulse and the angular impulse (about the centre
+		  // of mass) the current restriction value of the
+		  // constraint gives the compound during the frame
+  public:
+    DL_List   aside;        // the constraints set aside (see
+                            // DL_constraint::setaside)
+    boolean   splitpending; // should the compound be split up at the
+                            // end of the frame
+
+    virtual boolean is_compound(void) { return TRUE; }
+
+    void      remap(DL_constraint*,DL_dyna*);
+                  // move the constraint from the member to the compound
+    void      unremap(DL_constraint*);
+                  // move it back to the member (if it was remapped)
+    void      book_loads(DL_constraint*);
+                  // add the loads of the remapped constraint to the totals
+		  // kept by its member (for collisions, which are deleted
+		  // before weld_load is called)
+    DL_Scalar weld_load(void);
+                  // estimate the loads on the welds from the motion of
+		  // the compound during this frame, and the loads on
+		  // its members, and return the largest fraction of
+		  // their maximums (see DL_connector::load_fraction),
+		  // averaged with that of the previous frame (the
+		  // restriction values tend to alternate a little)
+    void      split(boolean);
+                  // let the members move on their own again, and move
+		  // the remapped constraints back to them (the set aside
+		  // ones are left to the constraint manager). The
+		  // parameter tells if the compound has been prepared
+		  // for the next frame already
+
+              DL_compound(int, DL_dyna**, int*, DL_connector**);
+                  // constructor: the members in breadth first order, and
+		  // for each but the first its parent and its weld
+              ~DL_compound();  // destructor
+};
+
+#endif
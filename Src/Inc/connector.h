@@ -53,11 +53,11 @@ public:
    // the next few methods don't need to do anything: just override
    // them anyway to prevent the errormessage from the constraint-
    // implementations of them...
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*){return FALSE;}
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*){return FALSE;}
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*){return FALSE;}
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*){return FALSE;}
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*){return FALSE;}
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*){return FALSE;}
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*){return FALSE;}
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*){return FALSE;}
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*){return FALSE;}
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*){return FALSE;}
   virtual void apply_restrictions(DL_largevector*){};
 
   virtual boolean check_restrictions();
@@ -71,6 +71,15 @@ public:
   virtual void show_forces(void){};
   virtual void hide_forces(void){};
 
+  virtual boolean is_connector(void){ return TRUE; }
+  DL_Scalar load_fraction(DL_vector*,DL_vector*);
+                     // the largest fraction of its maximum (maxforce of
+		     // myptp and maxtorque of myorient) that the force or
+		     // the torque given would be (0 if there are no
+		     // maximums)
+  DL_Scalar load_fraction();
+                     // the same for the current reaction force and torque
+
              DL_connector();                    // constructor
 	     ~DL_connector();                   // destructor
 };
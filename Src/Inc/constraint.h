@@ -36,9 +36,17 @@
 #include "list.h"
 #include "largevector.h"
 #include "largematrix.h"
+#include "fixmat.h"
 #include "dyna.h"
 #include "force_drawable.h"
 
+class DL_snapshot;
+class DL_compound;
+
+// how a constraint extrapolates its restriction value of the previous
+// frames to get the first estimate for the next (see first_estimate):
+enum DL_extrapolation {constant_estimate, linear_estimate, quadratic_estimate};
+
 // ******************* //
 // class DL_constraint //
 // ******************* //
@@ -48,6 +56,11 @@ protected:
   DL_largevector *F;    // the reaction "force"
   DL_largevector *oldF; // the reaction "force" of the previous frame
   DL_largevector *Fsave;// for saving during testing
+  DL_largevector Fstore, oldFstore, Fsavestore;
+                        // what F, oldF and Fsave point to (as part of the
+                        // constraint so no separate allocations are needed)
+  DL_largevector old2F; // the reaction "force" two frames ago
+  int nrhistory;        // number of frames of history in oldF and old2F
   boolean initialised;  // one can only activate an initialised constraint
   boolean testing;   // are we testing?
   boolean veloterms; // add velocityterms to the constraints (to prevent
@@ -66,6 +79,13 @@ public:
   boolean active;    // has the constraint been checked in with constraints
   int	index;       // index used by the constraint manager (the sum of all
                      // dimensions of previous constraint in the list)
+  int   colour;      // constraints of the same colour don't influence
+                     // the same constraint errors, so the constraint
+                     // manager can test them together (empirical dC/dR)
+  long  serial;      // the order of creation (snapshots keep the
+                     // constraints in this order)
+  DL_largevector* get_restriction(void){ return F; }
+                     // the current restriction value
 
   // methods for empirical dC/dR determination:
   virtual void begin_test(void);
@@ -77,43 +97,55 @@ public:
                      // the dynas that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdi has dimensions dim x 3
+  virtual void probe_error(DL_dyna*,DL_largevector*);
+                     // add the change in the constraint error of this
+		     // constraint caused by the probe loads of the dyna
+		     // (see DL_dyna::probing) to the vector, using
+		     // dCdF, dCdM and dCdI. Applying the restrictions
+		     // of all constraints while probing and then
+		     // calling this for each dyna a constraint applies
+		     // its restrictions to gives dCdR times a
+		     // restriction vector, without dCdR
 
   virtual void new_frame(void);
                      // prepare for a new frame
   virtual void first_estimate(void);
                      // calculate and apply the first estimate
+  void extrapolate(void);
+                     // calculate the first estimate (without applying
+		     // it) and shift the history
   virtual void apply_restrictions(DL_largevector*);
                      // apply the reaction forces and torques specified
 	             // by the parameter
@@ -130,8 +162,32 @@ public:
                      // calculate the constraint error vector
   virtual void post_processing(void);
                      // wrap up the calculations for this frame
-
-  void reset(void){F->makezero(); oldF->makezero();};
+  virtual void save_state(DL_snapshot*);
+                     // add the state that is carried from frame to frame
+		     // (restriction values etc.) to the snapshot
+  virtual void restore_state(DL_snapshot*);
+                     // read that state back from the snapshot
+
+  // methods for merging welded dynas into compounds (see
+  // DL_constraint_manager::merge_welds):
+  DL_compound *setaside; // the compound the constraint is set aside in
+                         // (or NULL): it is not in the list of the
+                         // constraint manager, but it is still active
+  int nrremaps;      // the number of compounds it is remapped to
+  virtual boolean remappable(void){ return FALSE; }
+                     // can the constraint be moved from a dyna to a
+		     // compound (see remap)
+  virtual void remap(DL_dyna*, DL_dyna*, DL_matrix*, DL_vector*){};
+                     // move the constraint from the first dyna to the
+		     // second. A point p (vector v) in the coordinates of
+		     // the first is R p+o (R v) in those of the second
+  virtual boolean is_connector(void){ return FALSE; }
+  virtual boolean is_collision(void){ return FALSE; }
+  int get_nrhistory(void){ return nrhistory; }
+                     // the number of frames of restriction history
+		     // (reset by reset())
+
+  void reset(void){F->makezero(); oldF->makezero(); nrhistory=0;};
   // reset the current restriction value to 0
   // (to be used after a big global change)
   void reset_undo(void);
@@ -148,6 +204,8 @@ public:
 
   // methods for external (to DL) use:
   DL_Scalar stiffness;    // the stiffness of the constraint
+  DL_extrapolation extrapolation; // how the first estimate is made
+                          // (default: linear_estimate)
   void	init(void);       // initialise the constraint
   void  activate(void);   // announce myself at the constraint manager
   void  deactivate(void); // remove myself from the constraint manager
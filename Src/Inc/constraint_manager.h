@@ -34,13 +34,43 @@
 
 #include "list.h"
 #include "largematrix.h"
+#include "tree_solver.h"
 #include "constraint.h"
 #include "collision.h"
 
+// dCdR is solved by block elimination instead of LU decomposition
+// (when lud_bcksub is the solve method) if, after sorting, no constraint
+// influences a constraint more than this many places away in the order:
+#define DL_MAXBLOCKBAND 3
+
+// the number of Broyden updates of the decomposition of dCdR (see
+// broyden below) after which dCdR is recalculated:
+#define DL_MAXBROYDEN 8
+
+// the relative residual up to which the matrix-free solve (see
+// matrix_free below) iterates:
+#define DL_MFTOL 0.01
+
+// the relaxation (see solve_using_relaxation below) handles the
+// constraints of one colour in parallel (if compiled with OpenMP) when
+// there are more than this many:
+#define DL_MINPARALLEL 64
+
+// welds are merged into compounds (see merge_welds below) while the
+// load on them is below this fraction of their maximum, and the
+// compound is split up again when the estimated load on one of its
+// welds comes above the second fraction:
+#define DL_MERGEFRACTION 0.5
+#define DL_SPLITFRACTION 0.8
+
+class DL_compound;
+
 // the constraint manager administrates which constraint pairs
 // influence each other, so it does not re-calculate zeros in
 // the dCdR matrix all the time. Here is the class definition for
-// those constrainmt-pair objects:
+// those constrainmt-pair objects (which are all thrown away and
+// created again each time dCdR is rebuilt from scratch, so they
+// are allocated from a pool):
 
 class DL_constraint_pair : public DL_ListElem {
   public:
@@ -51,6 +81,9 @@ class DL_constraint_pair : public DL_ListElem {
       cc=c; cf=f;
     }
     ~DL_constraint_pair(){}; // destructor
+
+    void* operator new(size_t);
+    void  operator delete(void*,size_t);
 }; // DL_constraint_pair
     
 
@@ -70,6 +103,16 @@ class DL_constraint_manager {
     boolean	c_changed;   // has the list of constraints changed since dCdR
                          // was calculated last
     DL_largematrix *dCdR;
+    DL_tree_solver tree; // for solving dCdR by elimination in tree order
+    boolean tree_valid;  // does tree have the structure of the current dCdR
+    boolean banded;      // is dCdR block banded (a chain) after sorting
+    boolean factored;    // is the decomposition of dCdR still current
+                         // (dCdR not recalculated since)
+    boolean treefactored;// and was it done by the tree solver
+    int nrbroyden;       // number of Broyden updates since the decomposition
+    DL_largevector broyden_u[DL_MAXBROYDEN]; // the updates: the inverse of
+    DL_largevector broyden_s[DL_MAXBROYDEN]; // dCdR is replaced by
+                         // (I+u s^T)...(I+u0 s0^T) inverse(dCdR)
     int	totdim;          // total dimension: sum of constraint dimensions
     DL_Scalar first_error;
     int nrcollisions;    // number of detected collisions
@@ -79,6 +122,27 @@ class DL_constraint_manager {
     // can be in two lists at the same time.  B(
     int size_collisions;      // allocated size of the collisions-array
     boolean show_con_forces;
+    DL_dyna* *mfdyna;    // for matrix_free: the dynas the i-th constraint
+    int *mfstart;        // applies its restrictions to are mfdyna[j] with
+                         // mfstart[i]<=j<mfstart[i+1]
+    int size_mfdyna;     // allocated sizes of mfdyna
+    int size_mfstart;    // and mfstart
+    boolean mfbuilt;     // was the administration last built without
+                         // dCdR (for matrix_free or relaxation)
+    boolean relaxing;    // solving using relaxation
+    boolean relaxvalid;  // are the colours and blocks below up to date
+    DL_constraint* *relaxorder; // the constraints sorted by colour: those
+    int *relaxcolour;    // of colour c are relaxorder[k] with
+                         // relaxcolour[c]<=k<relaxcolour[c+1]
+    int nrrelaxcolours;  // the number of colours
+    DL_subblock *relaxinv; // the inverses of the diagonal blocks of the
+                         // constraints in relaxorder
+    int size_relax;      // allocated size of relaxorder and relaxinv
+    DL_constraint* *newcons; // the constraints added while there are
+    int nrnewcons;       // compounds (see merge_welds), which may have
+    int size_newcons;    // to be set aside or remapped
+    DL_dyna* *touched;   // the dynas found by touched_dynas
+    int size_touched;    // allocated size of touched
     
     void	new_frame(void);
                   // prepare all constraints for the new frame
@@ -103,30 +167,135 @@ class DL_constraint_manager {
     void	calc_dCdR_full(void);
     void	calc_dCdR_analytical(void);
     void	calc_dCdR_empirical(void);
+    int     colour_constraints();
+                  // colour the constraints for calc_dCdR_empirical, so
+                  // the constraints of one colour can be tested at once
     void    begin_test(void);
     void    end_test(void);
     void	iterate(DL_largevector*);
+    void    broyden_solve(DL_largevector*, DL_largevector*, boolean);
+                  // solve using the decomposition and the Broyden updates
+    void    analyse_tree();
+                  // give the tree solver the block structure of dCdR.
+		  // Block banded matrices are solved by it instead of
+		  // by LU decomposition, trees if tree_elimination is set
     void    redo_index_administration();
+    void    find_dynas();
+                  // the matrix_free counterpart of calc_dCdR_full: find
+                  // the dynas each constraint applies its restrictions to
+    void    clear_probes();
+                  // clear the probe loads of all probed dynas
+    void    jacobian_times(DL_largevector*, DL_largevector*);
+                  // dCdR times the first vector, without dCdR
+    boolean bicgstab(DL_largevector*, DL_largevector*);
+                  // solve dCdR x=b with BiCGSTAB using jacobian_times;
+                  // returns if the solution was diverging
+    void    iterate_matrix_free(DL_largevector*);
+    void    colour_by_dynas();
+                  // colour the constraints so that constraints of one
+                  // colour share no dyna (using the administration of
+                  // find_dynas), and fill relaxorder and relaxcolour
+    void    prepare_relaxation();
+                  // colour the constraints and invert their diagonal blocks
+    boolean relax(DL_largevector*);
+                  // do one relaxation sweep, adding the restriction
+                  // changes to the parameter (if not NULL); returns if
+                  // any constraints have deleted themselves in the process
+    void    iterate_relaxation(DL_largevector*);
+    int     touched_dynas(DL_constraint*);
+                  // list the dynas the constraint applies its
+                  // restrictions to in touched, and return their number
+    void    set_aside(DL_constraint*, DL_compound*);
+                  // take the constraint out of the list while it is
+                  // between members of the compound
+    int     snapshot_order(DL_constraint**);
+                  // list all active constraints (also those set aside
+                  // in compounds) in the order they were created, and
+                  // return their number (pass NULL to only count them)
+    void    settle_new_constraints();
+                  // set aside or remap the new constraints of members
+                  // of compounds
   public:
     /// control parameters etc. for external use:
     boolean     analytical; // analytical or empirical determination of
                             // dCdR
+    boolean     mixed_precision; // LU decompose dCdR in single precision
+                            // and refine the solution (default: FALSE)
+    boolean     tree_elimination; // solve dCdR by block elimination in
+                            // tree order: linear time for chains and
+                            // trees of joints (default: FALSE). The
+                            // solve methods below take over if it fails
+    boolean     broyden;    // keep the decomposition of dCdR over the
+                            // frames it is reused (see NrSkip), and
+                            // improve it with a Broyden (secant) update
+                            // per iteration, until DL_MAXBROYDEN updates
+                            // cause a recalculation (default: FALSE).
+                            // Only for lud_bcksub and tree elimination
+    boolean     matrix_free;// don't calculate dCdR at all, but solve for
+                            // the restriction changes iteratively
+                            // (BiCGSTAB), using the products of dCdR
+                            // and a vector that follow from probing the
+                            // dynas with the restrictions (see
+                            // DL_constraint::probe_error). This takes
+                            // memory linear in the number of constraints
+                            // (where dCdR is quadratic), and for large
+                            // systems of constraints less time, as long
+                            // as they are well-conditioned. Needs
+                            // analytical derivatives: it has no effect
+                            // if analytical is FALSE (default: FALSE)
     int		MaxIter;    // the number of constraint correction iterations
     int		NrSkip;     // dCdR is recalculated every NrSkip+1 frames
+    int         NrSweeps;   // number of relaxation sweeps per iteration
+                            // step when solving using relaxation
+                            // (default: 20)
+    int         NrSmooth;   // number of relaxation sweeps done before
+                            // each iteration step when solving using
+                            // conjugate gradient (default: 0)
+    boolean     merge_welds;// replace dynas that are welded together
+                            // by connectors by a single rigid compound
+                            // dyna (see DL_compound) while the loads on
+                            // the welds are well below their maximums,
+                            // and split it up again when a weld is
+                            // about to break. The welds are not solved
+                            // for while merged, and the constraints
+                            // between the welded dynas and the rest are
+                            // moved to the compound. Only groups of
+                            // dynas welded in a tree (no loops), with no
+                            // other constraints between them, and with
+                            // only ptp, vtv, orientation and connector
+                            // constraints to the rest are merged
+                            // (default: FALSE)
     DL_Scalar   max_error;  // error thresh hold
     DL_Scalar   error;      // the current error magnitude
                             // (just for information)
     int         nriter;     // actual number of iteration steps taken in the
                             // last frame  (just for information)
+    int         nrframes;   // number of frames with constraints to satisfy,
+    int         nrquick;    // and how many of them needed at most one
+                            // iteration: an indication of the quality of
+                            // the first estimates (just for information)
     int         max_collisionloops;  // maximum number of secundary collision
                                      // detection/handling phases
 
     void    solve_using_lud();
-    boolean solving_using_lud(){ return dCdR->get_solve_method()==lud_bcksub;};
+    boolean solving_using_lud(){ return !relaxing && dCdR->get_solve_method()==lud_bcksub;};
     void    solve_using_cg();
-    boolean solving_using_cg(){ return dCdR->get_solve_method()==conjug_grad;};
+    boolean solving_using_cg(){ return !relaxing && dCdR->get_solve_method()==conjug_grad;};
     void    solve_using_svd();
-    boolean solving_using_svd(){ return dCdR->get_solve_method()==svd;};
+    boolean solving_using_svd(){ return !relaxing && dCdR->get_solve_method()==svd;};
+    void    solve_using_relaxation();
+    boolean solving_using_relaxation(){ return relaxing; };
+                  // relaxation doesn't need dCdR: each sweep visits the
+                  // constraints one colour at a time (constraints of one
+                  // colour share no dyna, so they are handled in
+                  // parallel), and changes the restriction values of
+                  // each constraint to remove its own error, using its
+                  // diagonal block of dCdR. The outcome does not depend
+                  // on the number of threads
+
+    void    set_extrapolation(DL_extrapolation);
+                  // set how all current constraints make their first
+                  // estimates (see DL_constraint::extrapolation)
 
     void    show_constraint_forces();
     void    hide_constraint_forces();
@@ -140,13 +309,33 @@ class DL_constraint_manager {
 
     /// for internal DL use only:
     void	satisfy(void);       // do the constraint correction
-    void	add(DL_constraint*); // add a constraint
+    DL_List*    get_constraints(void){ return c; }
+                                     // the list of (active) constraints
+    boolean	add(DL_constraint*); // add a constraint (FALSE if it
+                                     // is refused: dim>DL_MAXCDIM)
     void	del(DL_constraint*); // delete a constraint
 
+    void        save_state(DL_snapshot*);    // add the state of all
+                                             // constraints to the snapshot
+					     // (including those set aside
+					     // in compounds)
+    boolean     restore_state(DL_snapshot*); // restore it (after the
+                                             // compounds have been split)
     void        add_collision(DL_collision*);
                 // for DL_collision to be able to tell the constraint manager
 		// that a collision has been detected (so secondary collision
 		// detection can be called if necessary)
+    void        merge_welded(void);
+                // merge welded dynas into compounds (if merge_welds),
+		// after the dynas have been prepared for the next frame
+    void        split_overloaded(void);
+                // split up the compounds whose welds are about to break
+		// (or all if !merge_welds), before the dynas are prepared
+    void        split_compounds(void);
+                // split up all compounds (between frames)
+    void        split_compound(DL_compound*, boolean);
+                // split up the compound; the parameter tells if the
+		// dynas have been prepared for the next frame already
 
 };
 
@@ -160,18 +349,43 @@ inline DL_constraint_manager::DL_constraint_manager() {
   NrSkip=dCdRToGo=totdim=0;
   error=first_error=0.0; max_error=0.1;
   nriter=nr_cg=0;
+  nrframes=nrquick=0;
   max_collisionloops=1; // no secundary collision detection by default
   c_changed=FALSE;
   analytical=TRUE;
+  mixed_precision=FALSE;
+  tree_elimination=tree_valid=banded=FALSE;
+  broyden=factored=treefactored=FALSE;
+  nrbroyden=0;
+  matrix_free=mfbuilt=FALSE;
+  mfdyna=NULL; mfstart=NULL;
+  size_mfdyna=size_mfstart=0;
+  relaxing=relaxvalid=FALSE;
+  relaxorder=NULL; relaxcolour=NULL; relaxinv=NULL;
+  nrrelaxcolours=size_relax=0;
+  NrSweeps=20;
+  NrSmooth=0;
+  merge_welds=FALSE;
+  newcons=NULL; touched=NULL;
+  nrnewcons=size_newcons=size_touched=0;
   c=new DL_List;
   dCdR=new DL_largematrix(0,0);
   nrcollisions=size_collisions=0;
   show_con_forces=FALSE;
 }
 
-inline DL_constraint_manager::~DL_constraint_manager(void) {
+inline DL_constraint_manager::~DL_constraint_manager(void) {
   cp.delete_all();
   if (size_collisions>0) delete[] collisions;
+  if (size_mfdyna>0) delete[] mfdyna;
+  if (size_mfstart>0) delete[] mfstart;
+  if (size_relax>0) {
+    delete[] relaxorder;
+    delete[] relaxcolour;
+    delete[] relaxinv;
+  }
+  if (size_newcons>0) delete[] newcons;
+  if (size_touched>0) delete[] touched;
   delete dCdR;
   delete c;
 }
@@ -210,6 +424,14 @@ inline void DL_constraint_manager::apply_first_estimates(void) {
   }
 }
 
+inline void DL_constraint_manager::set_extrapolation(DL_extrapolation e) {
+  DL_constraint *constr=(DL_constraint *)c->getfirst();
+  while (constr) {
+    constr->extrapolation=e;
+    constr=(DL_constraint*)c->getnext(constr);
+  }
+}
+
 inline void DL_constraint_manager::reset_all(void) {
   DL_constraint *constr=(DL_constraint *)c->getfirst();
   while (constr) {
@@ -64,8 +64,8 @@ public:
   virtual DL_Scalar closeto(DL_point*);
        // returns a curveparameter s with p-curve(s) minimal
        // p given in world coordinates
-  void init(DL_geo*,DL_List*,boolean);
-       // initialise with geo, points and _cyclic;
+  void init(DL_geo*,DL_point*,int,boolean);
+       // initialise with geo, the array of n control points and _cyclic;
   void update_control_point(int,DL_point*);
        // change the coordinates of the i-th control point
 
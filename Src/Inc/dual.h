@@ -0,0 +1,179 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename	: dual.h
+// description	: dual numbers for forward mode automatic differentiation.
+//                A DL_dual holds a value and its derivatives with respect
+//                to DL_DUAL_WIDTH independent variables, and every
+//                operation applies the chain rule to them. Compiling the
+//                library (and the application using it) with
+//                -DDL_DUAL_SCALAR makes DL_Scalar a DL_dual (see scalar.h
+//                and the libd target in makefile.dynamo): the empirical
+//                determination of dCdR then seeds the derivatives of
+//                DL_DUAL_WIDTH restriction components at once and reads
+//                exact dCdR columns from the derivatives of the
+//                constraint errors, instead of differencing the errors
+//                of one unit test force at a time. As all calculations
+//                carry the derivatives along, that build is an order of
+//                magnitude slower than the double precision one (see
+//                the manual).
+//
+
+#ifndef DL_DUALH
+#define DL_DUALH
+
+#include <math.h>
+
+#ifndef DL_DUAL_WIDTH
+#define DL_DUAL_WIDTH 4
+#endif
+
+// *************** //
+// class DL_dual   //
+// *************** //
+
+class DL_dual {
+  public:
+    double x;                // the value
+    double d[DL_DUAL_WIDTH]; // the derivatives
+
+    DL_dual() { for (int i=0;i<DL_DUAL_WIDTH;i++) d[i]=0.0; }
+    DL_dual(double v) {
+      x=v;
+      for (int i=0;i<DL_DUAL_WIDTH;i++) d[i]=0.0;
+    }
+    DL_dual(double v, int i) { // the independent variable i with value v
+      x=v;
+      for (int j=0;j<DL_DUAL_WIDTH;j++) d[j]=(i==j ? 1.0 : 0.0);
+    }
+
+    DL_dual& operator+=(const DL_dual& b) {
+      x+=b.x; for (int i=0;i<DL_DUAL_WIDTH;i++) d[i]+=b.d[i]; return *this;
+    }
+    DL_dual& operator-=(const DL_dual& b) {
+      x-=b.x; for (int i=0;i<DL_DUAL_WIDTH;i++) d[i]-=b.d[i]; return *this;
+    }
+    DL_dual& operator*=(const DL_dual& b) {
+      for (int i=0;i<DL_DUAL_WIDTH;i++) d[i]=d[i]*b.x+x*b.d[i];
+      x*=b.x; return *this;
+    }
+    DL_dual& operator/=(const DL_dual& b) {
+      double r=1.0/b.x;
+      x*=r;
+      for (int i=0;i<DL_DUAL_WIDTH;i++) d[i]=(d[i]-x*b.d[i])*r;
+      return *this;
+    }
+};
+
+inline double DL_value(const DL_dual& a) { return a.x; }
+inline double DL_value(double a) { return a; }
+
+inline DL_dual operator-(const DL_dual& a) {
+  DL_dual r(-a.x);
+  for (int i=0;i<DL_DUAL_WIDTH;i++) r.d[i]=-a.d[i];
+  return r;
+}
+inline DL_dual operator+(const DL_dual& a) { return a; }
+inline DL_dual operator+(const DL_dual& a, const DL_dual& b) {
+  DL_dual r(a); return r+=b;
+}
+inline DL_dual operator-(const DL_dual& a, const DL_dual& b) {
+  DL_dual r(a); return r-=b;
+}
+inline DL_dual operator*(const DL_dual& a, const DL_dual& b) {
+  DL_dual r(a); return r*=b;
+}
+inline DL_dual operator/(const DL_dual& a, const DL_dual& b) {
+  DL_dual r(a); return r/=b;
+}
+
+// two duals are only equal if their derivatives are as well (so tests
+// like f==0.0 that skip work for zero forces don't drop derivatives),
+// the ordering only looks at the values:
+inline bool operator==(const DL_dual& a, const DL_dual& b) {
+  if (a.x!=b.x) return false;
+  for (int i=0;i<DL_DUAL_WIDTH;i++) if (a.d[i]!=b.d[i]) return false;
+  return true;
+}
+inline bool operator!=(const DL_dual& a, const DL_dual& b) { return !(a==b); }
+inline bool operator< (const DL_dual& a, const DL_dual& b) { return a.x< b.x; }
+inline bool operator<=(const DL_dual& a, const DL_dual& b) { return a.x<=b.x; }
+inline bool operator> (const DL_dual& a, const DL_dual& b) { return a.x> b.x; }
+inline bool operator>=(const DL_dual& a, const DL_dual& b) { return a.x>=b.x; }
+
+// the elementary functions (f(a) has derivatives f'(a.x)*a.d):
+inline DL_dual DL_dual_chain(double fx, double dfx, const DL_dual& a) {
+  DL_dual r(fx);
+  for (int i=0;i<DL_DUAL_WIDTH;i++) r.d[i]=dfx*a.d[i];
+  return r;
+}
+inline DL_dual sqrt(const DL_dual& a) {
+  double s=::sqrt(a.x);
+  return DL_dual_chain(s,(s>0.0 ? 0.5/s : 0.0),a);
+}
+inline DL_dual fabs(const DL_dual& a) { return (a.x<0.0 ? -a : a); }
+inline DL_dual sin(const DL_dual& a) { return DL_dual_chain(::sin(a.x),::cos(a.x),a); }
+inline DL_dual cos(const DL_dual& a) { return DL_dual_chain(::cos(a.x),-::sin(a.x),a); }
+inline DL_dual tan(const DL_dual& a) {
+  double t=::tan(a.x);
+  return DL_dual_chain(t,1.0+t*t,a);
+}
+inline DL_dual asin(const DL_dual& a) {
+  return DL_dual_chain(::asin(a.x),1.0/::sqrt(1.0-a.x*a.x),a);
+}
+inline DL_dual acos(const DL_dual& a) {
+  return DL_dual_chain(::acos(a.x),-1.0/::sqrt(1.0-a.x*a.x),a);
+}
+inline DL_dual atan(const DL_dual& a) {
+  return DL_dual_chain(::atan(a.x),1.0/(1.0+a.x*a.x),a);
+}
+inline DL_dual atan2(const DL_dual& y, const DL_dual& x) {
+  double r=1.0/(x.x*x.x+y.x*y.x);
+  DL_dual t(::atan2(y.x,x.x));
+  for (int i=0;i<DL_DUAL_WIDTH;i++) t.d[i]=(x.x*y.d[i]-y.x*x.d[i])*r;
+  return t;
+}
+inline DL_dual exp(const DL_dual& a) {
+  double e=::exp(a.x);
+  return DL_dual_chain(e,e,a);
+}
+inline DL_dual log(const DL_dual& a) { return DL_dual_chain(::log(a.x),1.0/a.x,a); }
+inline DL_dual pow(const DL_dual& a, double p) {
+  return DL_dual_chain(::pow(a.x,p),p*::pow(a.x,p-1.0),a);
+}
+inline DL_dual pow(const DL_dual& a, const DL_dual& b) {
+  double p=::pow(a.x,b.x);
+  double da=(a.x!=0.0 ? b.x*p/a.x : 0.0);
+  double db=(a.x>0.0 ? p*::log(a.x) : 0.0);
+  DL_dual r(p);
+  for (int i=0;i<DL_DUAL_WIDTH;i++) r.d[i]=da*a.d[i]+db*b.d[i];
+  return r;
+}
+inline DL_dual floor(const DL_dual& a) { return DL_dual(::floor(a.x)); }
+inline DL_dual ceil(const DL_dual& a) { return DL_dual(::ceil(a.x)); }
+
+#endif
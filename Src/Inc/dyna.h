@@ -37,14 +37,22 @@
 #include "geo.h"
 #include "NaN.h"
 
+class DL_snapshot;
+class DL_compound;
+
 // Class Mpair is internal to DL
-// Elements of class Mpair are used in the list forces of each dyna
+// Elements of class Mpair are used in the array forces of each dyna
 // which administrates pairs of forces/application-points (in
 // local coordinates) so torques can be calculated later based on
 // the current orientation (so we can have torques that do not rotate
 // along with the dyna).
+// The array starts out in a small buffer inside the dyna and only
+// moves to the heap when more pairs are needed. It keeps its size
+// between frames, so in a steady state no allocations are done at all.
+
+#define DL_MPAIRS_INLINE 8   // number of pairs stored inside the dyna
 
-class DL_Mpair : public DL_ListElem {
+class DL_Mpair {
   public:
     DL_vector force;
     DL_vector rho;
@@ -55,6 +63,7 @@ class DL_Mpair : public DL_ListElem {
 // ************* //
 
 class DL_dyna : public DL_geo {
+  friend class DL_compound;
   protected:
     int     oneD;       // 0 if the object is 2D or 3D; otherwise: the index
                         // of the basevector which is the axis of the dyna.
@@ -79,8 +88,44 @@ class DL_dyna : public DL_geo {
     DL_Scalar totalmass_inv;// 1.0/totalmass
     DL_vector Fexternal; // total of external central forces
 
-    DL_List   forces; // reaction force/application point pairs for calculating M
-    DL_List   forcesSave;
+    DL_Mpair *forces;     // reaction force/application point pairs for calculating M
+    int       nforces;    // number of pairs in use
+    int       maxforces;  // number of pairs available in forces
+    int       nforcesSave;// nforces saved for during testing
+    DL_Mpair  forcesbuf[DL_MPAIRS_INLINE]; // inline storage for forces
+
+    // the loads applied while probing (see probing below):
+    DL_vector probeF;     // total force (as a central force)
+    DL_vector probeM;     // total torque, including that of the forces
+    DL_vector probeI;     // total impulse
+    DL_matrix probeIq;    // column k: the impulses times the k-th
+                          // (local) coordinate of their points
+    boolean   probed;     // is the dyna on the list of probed dynas
+    boolean   probeimp;   // have any impulses been probed
+    DL_dyna  *nextprobed; // the next dyna on that list
+
+    inline void probe(void);            // put the dyna on the list
+
+    // the compound the dyna is welded into (see DL_compound), which
+    // moves it: its centre of mass is at point cpos, and its axes
+    // are the columns of cA, in the coordinates of the compound.
+    // While it is part of a compound, the dyna passes on all loads
+    // applied to it, only keeping their totals in F and M (as
+    // a central force and torque, with impulses divided by the
+    // stepsize) for its potential energy and for splitting up
+    // the compound again:
+    DL_dyna  *compound;
+    DL_matrix cA;
+    DL_vector cpos;
+    boolean   managed;    // is the dyna registered with the dyna system
+    void      follow(DL_supvec*,DL_supvec*);
+                          // derive the motion state (2nd parameter) from
+                          // that of the compound (1st parameter)
+    void      follow_compound(void);
+                          // derive nextmstate and mstateimp from the compound
+    void      compound_force(DL_point*,DL_vector*);
+    void      compound_impulse(DL_point*,DL_vector*);
+                          // pass on a force/impulse at the (local) point
 
     // matrix caches for analytical inverse dynamics support:
     // some are not full matrices ((anti)symmetrical), so we
@@ -101,6 +146,7 @@ class DL_dyna : public DL_geo {
            // of M and all torques listed in forces
 
     inline  void integrate();           // integrate the motion state
+    void    grow_forces(int);           // make room for at least n pairs
     void    update_cache1(void);        // makes sure cache1 is filled
     void    update_cache2(void);        // makes sure cache2 is filled
 
@@ -140,6 +186,9 @@ class DL_dyna : public DL_geo {
 
     void    init();              // initialise attributes
     virtual boolean is_dyna(void) { return TRUE; }
+    virtual boolean is_compound(void) { return FALSE; }
+    DL_dyna* get_compound(void) { return compound; };
+                                 // the compound the dyna is part of (or NULL)
 
     void prepare_for_next_frame(void);  // shift state and prepare for the next frame;
     void new_frame(void); // start of new frame (after user-code
@@ -192,8 +241,27 @@ class DL_dyna : public DL_geo {
 
     // methods to support empirical determination of dc/dF (for inverse dynamics):
     void begintest();                   // start testing: save F,M,A,nextmstate and uptodate
+    void save_state(DL_snapshot*);      // add the motion state etc. to the snapshot
+    void restore_state(DL_snapshot*);   // restore them from the snapshot
     void endtest();                     // end testing: restore F,M,A,nextmstate and uptodate
 
+    // methods to support matrix-free solving of the constraints (see
+    // DL_constraint_manager::matrix_free): while probing is set, the
+    // apply-methods above leave the motion alone and only add their
+    // loads to the probe loads of the dyna, which then puts itself on
+    // the list of probed dynas starting at firstprobed:
+    static boolean  probing;
+    static DL_dyna *firstprobed;
+    DL_dyna* get_nextprobed() { return nextprobed; };
+    boolean  is_probed() { return probed; };
+    void     clear_probe(void);  // clear the probe loads (the list itself
+                                 // is cleared by resetting firstprobed)
+    boolean  get_probe(DL_vector*,DL_vector*,DL_vector*,DL_matrix*);
+                                 // get probeF, probeM, probeI and probeIq;
+                                 // returns if there are any impulses
+    int      probenr;            // scratch number used by the constraint
+                                 // manager to number the probed dynas
+
     // methods to support analytical determination of dc/dF (for inverse dynamics):
     inline void dpdfq(DL_point*, DL_point*, DL_matrix*);  // corresponds to applyforce/new_toworld(point)
     inline void dpdF(DL_point*, DL_matrix*);              // corresponds to applycenterforce/new_toworld(point)
@@ -242,12 +310,18 @@ class DL_dyna : public DL_geo {
 
                DL_dyna(void*);       // constructor
 	       ~DL_dyna();           // destructor
+  protected:
+               DL_dyna();            // constructor for compounds (which
+	                             // are not registered with the dyna system)
 };
 
 #include "dyna_system.h"
 
 inline void DL_dyna::init() {
   testing=FALSE;
+  forces=forcesbuf;
+  maxforces=DL_MPAIRS_INLINE;
+  nforces=nforcesSave=0;
   oneD=0;
   J.init(1,1,1);
   Jinv.init(1,1,1);
@@ -261,10 +335,17 @@ inline void DL_dyna::init() {
   totalmass=totalmass_inv=0.0;
 
   Fexternal.init(0,0,0);
+
+  probed=FALSE;
+  nextprobed=NULL;
+  clear_probe();
+
+  compound=NULL;
 }
 
 inline DL_dyna::DL_dyna(void *comp):DL_geo(comp) {
   init();
+  managed=TRUE;
   if (DL_dsystem) {
     DL_dsystem->register_dyna(this);
     DL_dsystem->get_companion()->get_first_geo_info(this);
@@ -273,10 +354,14 @@ inline DL_dyna::DL_dyna(void *comp):DL_geo(comp) {
     fprintf(stderr,"Severe warning: there is no dyna system to manage the dyna's!\n"); // can't use Msg here!!
 }
 
+inline DL_dyna::DL_dyna():DL_geo(NULL) {
+  init();
+  managed=FALSE;
+}
+
 inline DL_dyna::~DL_dyna() {
-   if (DL_dsystem)  DL_dsystem->remove_dyna(this);
-   forces.delete_all();
-   forcesSave.delete_all();
+   if (DL_dsystem && managed)  DL_dsystem->remove_dyna(this);
+   if (forces!=forcesbuf) delete [] forces;
 }
 
 inline void DL_dyna::set_position(DL_point *p) {
@@ -293,7 +378,7 @@ inline void DL_dyna::set_orientation(DL_matrix *m) {
   DL_geo::set_orientation(m);
   mstate.A2q();
   mstate.q2A(this);  
-  mstateimp.A.assign(&(mstate.A));
+  mstateimp.set_A(mstate.get_A());
   mstateimp.q.assign(&(mstate.q));  
 }
 
@@ -322,7 +407,7 @@ inline DL_vector* DL_dyna::get_next_velocity(void) {
 
 inline DL_matrix* DL_dyna::get_next_orientation(void) {
   integrate();
-  return &(nextmstate.A);
+  return nextmstate.get_A();
 }
 
 inline DL_vector* DL_dyna::get_next_angvelocity(void) {
@@ -365,21 +450,21 @@ inline void DL_dyna::get_newvelocity(DL_vector *v, DL_vector *vr) {
 inline void DL_dyna::imp_toworld(DL_point *p, DL_point *pr) {
   DL_vector vtmp;
   integrate();
-  mstateimp.A.times(p,pr);
+  mstateimp.get_A()->times(p,pr);
   mstateimp.z.tovector(&vtmp);
   pr->plusis(&vtmp);
 }
 
 inline void DL_dyna::imp_toworld(DL_vector *v, DL_vector *vr) {
   integrate();
-  mstateimp.A.times(v,vr);
+  mstateimp.get_A()->times(v,vr);
 }
 
 inline void DL_dyna::get_impvelocity(DL_point *p, DL_vector *v) {
 // p in local coordinates; v in world coordinates
   DL_point pw;
   DL_vector vw;
-  mstateimp.A.times(p,&pw);
+  mstateimp.get_A()->times(p,&pw);
   pw.tovector(&vw);
   vw.crossprod(&(mstateimp.w),v);
   v->plusis(&(mstateimp.v));
@@ -388,7 +473,7 @@ inline void DL_dyna::get_impvelocity(DL_point *p, DL_vector *v) {
 inline void DL_dyna::get_impvelocity(DL_vector *v, DL_vector *vr) {
 // v in local coordinates; vr in world coordinates
   DL_vector vw;
-  mstateimp.A.times(v,&vw);
+  mstateimp.get_A()->times(v,&vw);
   vw.crossprod(&(mstateimp.w),vr);
 }
 
@@ -436,6 +521,10 @@ inline DL_Scalar DL_dyna::get_mass() {
 }
 
 inline void DL_dyna::integrate() {
+  if (compound) {
+    follow_compound();
+    return;
+  }
   if (!Fuptodate) {
     // first do the positional integration:
     // this can be done analytically:
@@ -466,14 +555,15 @@ inline void DL_dyna::ode(DL_supvec* y,DL_supvec* dy, DL_Scalar df) {
 // of the euler integrators
 
   DL_vector v0, v1, koppel; // auxilary variables
+  DL_matrix *A=y->get_A();  // derived from y->q once for all products below
 
-  y->A.diag_transpose_vec(&J,&(y->w),&v0); // v0:=J A^T w  
-  y->A.times(&v0,&v1);                     // v1:=A J A^T w
+  A->diag_transpose_vec(&J,&(y->w),&v0);   // v0:=J A^T w  
+  A->times(&v0,&v1);                       // v1:=A J A^T w
   v1.crossprod(&(y->w),&v0);               // v0:=w~ A J A^T w
-  calc_M(&(y->A),&koppel);
+  calc_M(A,&koppel);
   koppel.minus(&v0,&v1);	           // v1:=M - w~ A J A^T w
-  y->A.diag_transpose_vec(&Jinv,&v1,&v0);  // v0:=Jinv A^T (M - w~ A J A^T w)
-  y->A.times(&v0,&(dy->w));                // dy->w:=A Jinv A^T ( M - w~ A J A^T w )
+  A->diag_transpose_vec(&Jinv,&v1,&v0);    // v0:=Jinv A^T (M - w~ A J A^T w)
+  A->times(&v0,&(dy->w));                  // dy->w:=A Jinv A^T ( M - w~ A J A^T w )
   
   if (df==0.0)
     y->q.times(&(y->w),&(dy->q));  // dy->q:=(y->w)#(y->q)
@@ -489,15 +579,14 @@ inline void DL_dyna::calc_M(DL_matrix *A, DL_vector *totkoppel){
   DL_vector t;
   DL_vector tp;
   DL_vector *l;
-  DL_Mpair *elem;
+  DL_Mpair *elem, *last;
   if (oneD!=0) {
     if (oneD==1) l=&(A->c0);
     if (oneD==2) l=&(A->c1);
     if (oneD==3) l=&(A->c2);
   }
   totkoppel->assign(&M);
-  elem=(DL_Mpair*)forces.getfirst();
-  while (elem) {
+  for (elem=forces, last=forces+nforces; elem<last; elem++) {
     A->times(&(elem->rho),&tp);
     elem->force.crossprod(&tp,&t);
     if (oneD!=0) { // no torque in the direction of l;
@@ -505,7 +594,6 @@ inline void DL_dyna::calc_M(DL_matrix *A, DL_vector *totkoppel){
       t.minus(&tp,&t);
     }
     totkoppel->plusis(&t);
-    elem=(DL_Mpair*)forces.getnext(elem);
   }
 }
 
@@ -549,24 +637,25 @@ inline void DL_dyna::update_cache1() {
      // account for factor h*h:
      DL_Scalar hh=DL_dsystem->get_integrator()->stepsize(); hh*=hh;
      DL_Scalar Jx=hh*Jinv.x, Jy=hh*Jinv.y, Jz=hh*Jinv.z;
-     ddwdM00=Jx*mstate.A.c0.x*mstate.A.c0.x +
-             Jy*mstate.A.c1.x*mstate.A.c1.x +
-	     Jz*mstate.A.c2.x*mstate.A.c2.x ;
-     ddwdM11=Jx*mstate.A.c0.y*mstate.A.c0.y +
-             Jy*mstate.A.c1.y*mstate.A.c1.y +
-	     Jz*mstate.A.c2.y*mstate.A.c2.y ;
-     ddwdM22=Jx*mstate.A.c0.z*mstate.A.c0.z +
-             Jy*mstate.A.c1.z*mstate.A.c1.z +
-	     Jz*mstate.A.c2.z*mstate.A.c2.z ;
-     ddwdM01=Jx*mstate.A.c0.x*mstate.A.c0.y +
-             Jy*mstate.A.c1.x*mstate.A.c1.y +
-	     Jz*mstate.A.c2.x*mstate.A.c2.y ;
-     ddwdM02=Jx*mstate.A.c0.x*mstate.A.c0.z +
-             Jy*mstate.A.c1.x*mstate.A.c1.z +
-	     Jz*mstate.A.c2.x*mstate.A.c2.z ;
-     ddwdM12=Jx*mstate.A.c0.y*mstate.A.c0.z +
-             Jy*mstate.A.c1.y*mstate.A.c1.z +
-	     Jz*mstate.A.c2.y*mstate.A.c2.z ;
+     DL_matrix *A=mstate.get_A();
+     ddwdM00=Jx*A->c0.x*A->c0.x +
+             Jy*A->c1.x*A->c1.x +
+	     Jz*A->c2.x*A->c2.x ;
+     ddwdM11=Jx*A->c0.y*A->c0.y +
+             Jy*A->c1.y*A->c1.y +
+	     Jz*A->c2.y*A->c2.y ;
+     ddwdM22=Jx*A->c0.z*A->c0.z +
+             Jy*A->c1.z*A->c1.z +
+	     Jz*A->c2.z*A->c2.z ;
+     ddwdM01=Jx*A->c0.x*A->c0.y +
+             Jy*A->c1.x*A->c1.y +
+	     Jz*A->c2.x*A->c2.y ;
+     ddwdM02=Jx*A->c0.x*A->c0.z +
+             Jy*A->c1.x*A->c1.z +
+	     Jz*A->c2.x*A->c2.z ;
+     ddwdM12=Jx*A->c0.y*A->c0.z +
+             Jy*A->c1.y*A->c1.z +
+	     Jz*A->c2.y*A->c2.z ;
       
      matrixcache1empty=FALSE;
   }
@@ -585,7 +674,7 @@ inline void DL_dyna::dpdfq(DL_point *p, DL_point *q, DL_matrix *m) {
   // so we multiply the two and add the bit for dp/dF
 
   // first calculate (mstate.A)*q :
-  mstate.A.times(q,&rho);
+  mstate.get_A()->times(q,&rho);
   
   // now multiply: we can do this a bit cheaper since we know the
   // diagonal of rho~ only contains zeros. Of course I should not
@@ -609,7 +698,7 @@ inline void DL_dyna::dvdfq(DL_vector *v, DL_point *q, DL_matrix *m) {
   DL_matrix dvdm;
   DL_point rho;
   dvdM(v,&dvdm);
-  mstate.A.times(q,&rho);
+  mstate.get_A()->times(q,&rho);
   m->c0.x=dvdm.c2.x*rho.y-dvdm.c1.x*rho.z;
   m->c1.x=dvdm.c0.x*rho.z-dvdm.c2.x*rho.x;
   m->c2.x=dvdm.c1.x*rho.x-dvdm.c0.x*rho.y;
@@ -706,7 +795,7 @@ inline void DL_dyna::update_cache2() {
     DL_vector Ai;
     DL_Scalar hinv=1.0/DL_dsystem->get_integrator()->stepsize();
         
-    mstate.A.c0.times(hinv,&Ai);
+    mstate.get_A()->c0.times(hinv,&Ai);
     DL_Scalar wzc01=mstate.w.z*dA0ddw01;
     DL_Scalar wyc02=mstate.w.y*dA0ddw02;
     DL_Scalar wxc12=mstate.w.x*dA0ddw12;
@@ -721,7 +810,7 @@ inline void DL_dyna::update_cache2() {
     m02y= mstate.w.z*dA0ddw02-Ai.x;
     m02z= wxc12-wyc02;
     
-    mstate.A.c1.times(hinv,&Ai);
+    mstate.get_A()->c1.times(hinv,&Ai);
     wzc01=mstate.w.z*dA1ddw01;
     wyc02=mstate.w.y*dA1ddw02;
     wxc12=mstate.w.x*dA1ddw12;
@@ -736,7 +825,7 @@ inline void DL_dyna::update_cache2() {
     m12y= mstate.w.z*dA1ddw02-Ai.x;
     m12z= wxc12-wyc02;
     
-    mstate.A.c2.times(hinv,&Ai);
+    mstate.get_A()->c2.times(hinv,&Ai);
     wzc01=mstate.w.z*dA2ddw01;
     wyc02=mstate.w.y*dA2ddw02;
     wxc12=mstate.w.x*dA2ddw12;
@@ -767,7 +856,7 @@ inline void DL_dyna::ddpdfq(DL_point *p, DL_point *q, DL_matrix *m) {
   // so we multiply the two and add the bit for ddp/dF
 
   // first calculate (mstate->A)*q :
-  mstate.A.times(q,&rho);
+  mstate.get_A()->times(q,&rho);
   
   // now multiply: we can do this a bit cheaper since we know the
   // diagonal of rho~ only contains zero's. Of course I shouldn't
@@ -791,7 +880,7 @@ inline void DL_dyna::ddvdfq(DL_vector *v, DL_point *q, DL_matrix *m) {
   DL_point rho;
     
   ddvdM(v,&ddvdm);
-  mstate.A.times(q,&rho);
+  mstate.get_A()->times(q,&rho);
   
   m->c0.x=ddvdm.c2.x*rho.y-ddvdm.c1.x*rho.z;
   m->c1.x=ddvdm.c0.x*rho.z-ddvdm.c2.x*rho.x;
@@ -882,8 +971,8 @@ inline void DL_dyna::dpdi(DL_point *p, DL_point *q, DL_matrix *m) {
 
    // first calculate ddq/di:
    DL_matrix Atmp,ddqdi;
-   Atmp.diagcrosstranspose(&Jinv,q,&(mstate.A));
-   mstate.A.times(&Atmp,&ddqdi);
+   Atmp.diagcrosstranspose(&Jinv,q,mstate.get_A());
+   mstate.get_A()->times(&Atmp,&ddqdi);
 
    // make sure the cache is up to date
    update_cache1();
@@ -919,8 +1008,8 @@ inline void DL_dyna::dvdi(DL_vector *v, DL_point *q, DL_matrix *m) {
 
    // first calculate ddq/di:
    DL_matrix Atmp,ddqdi;
-   Atmp.diagcrosstranspose(&Jinv,q,&(mstate.A));
-   mstate.A.times(&Atmp,&ddqdi);
+   Atmp.diagcrosstranspose(&Jinv,q,mstate.get_A());
+   mstate.get_A()->times(&Atmp,&ddqdi);
 
    // make sure the cache is up to date
    update_cache1();
@@ -959,8 +1048,8 @@ inline void DL_dyna::ddpdi(DL_point *p, DL_point *q, DL_matrix *m) {
     update_cache1();  // results from cache 1 are required here
 
     // first calculate dw/di:
-    Atmp.diagcrosstranspose(&Jinv,q,&(mstate.A));
-    mstate.A.times(&Atmp,&dwdi);
+    Atmp.diagcrosstranspose(&Jinv,q,mstate.get_A());
+    mstate.get_A()->times(&Atmp,&dwdi);
 
     // then calculate ddp/dw in Atmp:
     p->times(2.0*DL_dsystem->get_integrator()->stepsize(),&rho);
@@ -968,7 +1057,7 @@ inline void DL_dyna::ddpdi(DL_point *p, DL_point *q, DL_matrix *m) {
     S02=rho.x*dA0ddw02+rho.y*dA1ddw02+rho.z*dA2ddw02;
     S12=rho.x*dA0ddw12+rho.y*dA1ddw12+rho.z*dA2ddw12;
 
-    mstate.A.times(p,&rho);
+    mstate.get_A()->times(p,&rho);
     
     Atmp.c0.x= mstate.w.z*S01-mstate.w.y*S02;
     Atmp.c1.x=-mstate.w.y*S12+rho.z;
@@ -996,8 +1085,8 @@ inline void DL_dyna::ddvdi(DL_vector *v, DL_point *q, DL_matrix *m) {
     update_cache1();  // results from cache 1 are required here
 
     // first calculate dw/di:
-    Atmp.diagcrosstranspose(&Jinv,q,&(mstate.A));
-    mstate.A.times(&Atmp,&dwdi);
+    Atmp.diagcrosstranspose(&Jinv,q,mstate.get_A());
+    mstate.get_A()->times(&Atmp,&dwdi);
 
     // then calculate ddp/dw in Atmp:
     v->times(2.0*DL_dsystem->get_integrator()->stepsize(),&rho);
@@ -1005,7 +1094,7 @@ inline void DL_dyna::ddvdi(DL_vector *v, DL_point *q, DL_matrix *m) {
     S02=rho.x*dA0ddw02+rho.y*dA1ddw02+rho.z*dA2ddw02;
     S12=rho.x*dA0ddw12+rho.y*dA1ddw12+rho.z*dA2ddw12;
 
-    mstate.A.times(v,&rho);
+    mstate.get_A()->times(v,&rho);
     
     Atmp.c0.x= mstate.w.z*S01-mstate.w.y*S02;
     Atmp.c1.x=-mstate.w.y*S12+rho.z;
@@ -1026,8 +1115,8 @@ inline void DL_dyna::ddptdi(DL_point *p, DL_point *q, DL_matrix *m) {
 // (both p and q in local coordinates)
   DL_matrix Atmp;
   m->negcrossdiagcross(p,&Jinv,q);
-  m->timestranspose(&(mstate.A),&Atmp);
-  mstate.A.times(&Atmp,m);
+  m->timestranspose(mstate.get_A(),&Atmp);
+  mstate.get_A()->times(&Atmp,m);
   m->c0.x+=totalmass_inv;
   m->c1.y+=totalmass_inv;
   m->c2.z+=totalmass_inv;
@@ -1040,8 +1129,8 @@ inline void DL_dyna::ddvtdi(DL_vector *v, DL_point *q, DL_matrix *m) {
   DL_point p;
   v->topoint(&p);
   m->negcrossdiagcross(&p,&Jinv,q);
-  m->timestranspose(&(mstate.A),&Atmp);
-  mstate.A.times(&Atmp,m);
+  m->timestranspose(mstate.get_A(),&Atmp);
+  mstate.get_A()->times(&Atmp,m);
 }
 
 inline void DL_dyna::move(DL_point *newpos, DL_matrix *neworient){
@@ -1056,8 +1145,45 @@ inline void DL_dyna::new_frame(void) {
   Fexternal.assign(&F);
 }
 
+inline void DL_dyna::probe(void) {
+  if (probed) return;
+  probed=TRUE;
+  nextprobed=firstprobed;
+  firstprobed=this;
+}
+
+inline void DL_dyna::clear_probe(void) {
+  probeF.init(0,0,0);
+  probeM.init(0,0,0);
+  probeI.init(0,0,0);
+  probeIq.c0.init(0,0,0);
+  probeIq.c1.init(0,0,0);
+  probeIq.c2.init(0,0,0);
+  probeimp=probed=FALSE;
+}
+
+inline boolean DL_dyna::get_probe(DL_vector *f, DL_vector *m,
+				  DL_vector *i, DL_matrix *iq) {
+  f->assign(&probeF);
+  m->assign(&probeM);
+  if (!probeimp) return FALSE;
+  i->assign(&probeI);
+  iq->assign(&probeIq);
+  return TRUE;
+}
+
 inline void DL_dyna::applycenterforce(DL_vector *f) {
+  if (probing) {
+    probe();
+    probeF.plusis(f);
+    return;
+  }
   if ((f->x==0.0)&&(f->y==0.0)&&(f->z==0.0)) return;
+  if (compound) {
+    DL_point o(0,0,0);
+    compound_force(&o,f);
+    return;
+  }
   F.plusis(f);
   Fuptodate=FALSE;
 }
@@ -1065,8 +1191,32 @@ inline void DL_dyna::applycenterforce(DL_vector *f) {
 inline void DL_dyna::applyforce(DL_point *p, DL_geo *g, DL_vector *f) {
   DL_vector m;
   DL_vector t;
-  DL_Mpair *forceselem;
+  DL_Mpair *forceselem, *last;
+  if (probing) {
+    // the force acts as a central force plus a torque, with the arm
+    // based on the current orientation (as in dpdfq):
+    DL_point pm;
+    if (g==this) mstate.get_A()->times(p,&pm);
+    else {
+      DL_point pl;
+      to_local(p,g,&pl);
+      mstate.get_A()->times(&pl,&pm);
+    }
+    pm.tovector(&m);
+    f->crossprod(&m,&t);
+    probe();
+    probeF.plusis(f);
+    probeM.plusis(&t);
+    return;
+  }
   if ((f->x==0.0)&&(f->y==0.0)&&(f->z==0.0)) return;
+  if (compound) {
+    DL_point pm;
+    if (g==this) pm.assign(p);
+    else to_local(p,g,&pm);
+    compound_force(&pm,f);
+    return;
+  }
   
   F.plusis(f);
   Fuptodate=FALSE;  
@@ -1078,39 +1228,47 @@ inline void DL_dyna::applyforce(DL_point *p, DL_geo *g, DL_vector *f) {
     pm.tovector(&m);
   }
 
-  // add the force to the force list:
+  // add the force to the force array:
   // see if we already have a force to this point;
-  forceselem=(DL_Mpair*)forces.getfirst();
-  while (forceselem) {
+  // while testing, the pairs from before the test are left alone, so
+  // endtest() only has to forget the pairs added since begintest()
+  last=forces+nforces;
+  forceselem=forces+(testing ? nforcesSave : 0);
+  while (forceselem<last) {
     if (forceselem->rho.equal(&m)) break;
-    else forceselem=(DL_Mpair*)forces.getnext(forceselem);
+    else forceselem++;
   }
-  if (forceselem) {
+  if (forceselem<last) {
     forceselem->force.plusis(f);
-/* probably won't make things faster:
-    if (forceselem->force.norm()==0) {
-      forces.remelem(forceselem);
-      delete forceselem;
-    }
-*/
   }
   else {
-    forceselem=new DL_Mpair;
+    if (nforces==maxforces) grow_forces(nforces+1);
+    forceselem=forces+nforces;
+    nforces++;
     forceselem->force.assign(f);
     forceselem->rho.assign(&m);
-    forces.addelem(forceselem);
   }
 
   Muptodate=FALSE;
 }
 
 inline void DL_dyna::applytorque(DL_vector *t) {
+  if (probing) {
+    probe();
+    probeM.plusis(t);
+    return;
+  }
   if ((t->x==0.0)&&(t->y==0.0)&&(t->z==0.0)) return;
+  if (compound) {
+    M.plusis(t);
+    compound->applytorque(t);
+    return;
+  }
   if (oneD!=0) {
     DL_vector *l;
-    if (oneD==1) l=&(mstate.A.c0);
-    if (oneD==2) l=&(mstate.A.c1);
-    if (oneD==3) l=&(mstate.A.c2);
+    if (oneD==1) l=&(mstate.get_A()->c0);
+    if (oneD==2) l=&(mstate.get_A()->c1);
+    if (oneD==3) l=&(mstate.get_A()->c2);
     DL_vector tp;
     l->times(l->inprod(t),&tp);
     t->minus(&tp,&tp); // tp is the projection of t onto the plane
@@ -1126,11 +1284,32 @@ inline void DL_dyna::applyimpulse(DL_point *p, DL_geo *g, DL_vector *i) {
   DL_vector r; // A(p in lc)
   DL_point pm;
 
+  if (probing) {
+    // the effect of an impulse is linear in the (local) coordinates
+    // of its point (see dpdi), so the impulses and their moments
+    // are enough:
+    if (g==this) pm.assign(p);
+    else to_local(p,g,&pm);
+    probe();
+    probeI.plusis(i);
+    i->times(pm.x,&tmp); probeIq.c0.plusis(&tmp);
+    i->times(pm.y,&tmp); probeIq.c1.plusis(&tmp);
+    i->times(pm.z,&tmp); probeIq.c2.plusis(&tmp);
+    probeimp=TRUE;
+    return;
+  }
+  if (compound) {
+    if (g==this) pm.assign(p);
+    else to_local(p,g,&pm);
+    compound_impulse(&pm,i);
+    return;
+  }
+
   i->times(totalmass_inv,&delta);
   mstateimp.v.plusis(&delta);
 
   if (g==this) {
-    mstate.A.times(p,&pm);
+    mstate.get_A()->times(p,&pm);
     pm.tovector(&r);
   }
   else {
@@ -1138,13 +1317,13 @@ inline void DL_dyna::applyimpulse(DL_point *p, DL_geo *g, DL_vector *i) {
     pm.minus(&(mstate.z),&r);
   }
   i->crossprod(&r,&delta);
-  mstate.A.diag_transpose_vec(&Jinv,&delta,&tmp);
-  mstate.A.times(&tmp,&delta);
+  mstate.get_A()->diag_transpose_vec(&Jinv,&delta,&tmp);
+  mstate.get_A()->times(&tmp,&delta);
     
   if (oneD!=0) { // no torque in the direction of the oneDth base vector;
-    if (oneD==1) mstate.A.c0.times(mstate.A.c0.inprod(&delta),&tmp);
-    if (oneD==2) mstate.A.c1.times(mstate.A.c1.inprod(&delta),&tmp);
-    if (oneD==3) mstate.A.c2.times(mstate.A.c2.inprod(&delta),&tmp);
+    if (oneD==1) mstate.get_A()->c0.times(mstate.get_A()->c0.inprod(&delta),&tmp);
+    if (oneD==2) mstate.get_A()->c1.times(mstate.get_A()->c1.inprod(&delta),&tmp);
+    if (oneD==3) mstate.get_A()->c2.times(mstate.get_A()->c2.inprod(&delta),&tmp);
     delta.minusis(&tmp);
   }
   
@@ -37,9 +37,11 @@
 #include "geo.h"
 #include "controller.h"
 #include "list.h"
+#include "ptrmap.h"
 #include "force_drawer.h"
 
 class DL_dyna;
+class DL_snapshot;
 
 // ****************************** //
 // class DL_dyna_system_callbacks //
@@ -109,8 +111,13 @@ class DL_dyna_system {
 				 // the outside user
     DL_List geos;                // these are the geo's that are
 		 	         // of interest to the dyna_system.
+    DL_ptrmap geoindex;          // the geos indexed by their companion
+    DL_ptrmap dynaindex;         // the dynas indexed by their companion
     DL_List controllers;         // these are the controllers that are
 				 // managed by the dyna_system.
+    DL_List compounds;           // the compounds of welded dynas (see
+                                 // DL_constraint_manager::merge_welds),
+				 // which are not in the dynas list
     boolean show_con_forces;     // show the controller forces or not
   public:
     /// for external (to DL) use:
@@ -121,6 +128,10 @@ class DL_dyna_system {
     DL_geo* register_geo(void*);        // make sure there is a geo with the
                                         // supplied companion in the geos-list
     void remove_geo(DL_geo*);           // remove the geo from the geos.
+    DL_geo* find_geo(void*);            // the registered geo with the
+                                        // supplied companion (or NULL)
+    DL_dyna* find_dyna(void*);          // the dyna with the supplied
+                                        // companion (or NULL)
     
     void set_gravity(DL_vector*);       // set gravity
     void get_gravity(DL_vector*);       // get gravity;
@@ -147,9 +158,16 @@ class DL_dyna_system {
     /// for internal (DL) use only:
     void register_dyna(DL_dyna*);       // add the DL_dyna to the dynas-list
     void remove_dyna(DL_dyna*);         // remove the dyna from the dynas.
+    void reindex_dyna(DL_dyna*,void*);  // the dyna's companion changed
+                                        // (the old one is supplied)
     void add_controller(DL_controller*); // add this controller to the list
     void rem_controller(DL_controller*); // remove this controller from the list
+    void add_compound(DL_dyna*);         // add this compound to the list
+    void rem_compound(DL_dyna*);         // remove this compound from the list
+    DL_List* get_compounds(void){ return &compounds; };
     void update_dyna_companions();       // update positions/orientations etc. for all dynas
+    void save_state(DL_snapshot*);       // record the state of the simulation
+    boolean restore_state(DL_snapshot*); // restore it (see DL_snapshot)
     
     DL_Scalar newkinenergy();           // return sum of new kinetic
                                         // energy of all dyna's
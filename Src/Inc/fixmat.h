@@ -0,0 +1,177 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename	: fixmat.h
+// description	: small matrices with dimensions known at compile time.
+//                These are used for the blocks the constraints compute
+//                for dC/dR (dc/dp, df/dR, dC/dFq etc.), so assembling
+//                them needs no heap memory and no size checks. The loops
+//                have constant bounds and are unrolled by the compiler.
+//                Some operations take the number of rows to use, for
+//                blocks that are sized for the largest constraint but
+//                filled for a specific one.
+//
+
+#ifndef DL_FIXMATH
+#define DL_FIXMATH
+
+#include "scalar.h"
+#include "matrix.h"
+
+// the largest dimension of a constraint (the line-hinge constraint):
+#define DL_MAXCDIM 5
+
+// ************************ //
+// class template DL_fixmat //
+// ************************ //
+
+template<int R, int C>
+class DL_fixmat {
+  public:
+    DL_Scalar a[R][C];
+
+    // the operations that take n (and m) only use the first n rows (and
+    // m columns), for blocks that are sized for the largest constraint:
+    DL_Scalar get(int r,int c) { return a[r][c]; }
+    void      set(int r,int c,DL_Scalar x) { a[r][c]=x; }
+    void      makezero(int n=R,int m=C);
+    void      assign(DL_matrix*);         // PRE: R>=3 && C>=3 (sets 3x3)
+    void      setrow(int,DL_vector*);     // PRE: C>=3
+    void      setcolumn(int,DL_vector*);  // PRE: R>=3
+    void      neg(int n=R,int m=C);
+    void      plusis(DL_fixmat<R,C>*,int n=R,int m=C);
+    void      minusis(DL_fixmat<R,C>*,int n=R,int m=C);
+    void      timesis(DL_Scalar,int n=R,int m=C);
+    template<int R2, int C2>
+    void      setsubmatrix(int,int,DL_fixmat<R2,C2>*,int n=R2,int m=C2);
+                                          // copy the first n x m elements
+                                          // of the parameter to (r,c)
+    template<int K, int R2, int C2>
+    void      times(DL_fixmat<C,K>*,DL_fixmat<R2,C2>*,int n=R);
+                                          // first n rows of self*m
+                                          // PRE: n<=R2 && K<=C2
+    template<int R2, int C2>
+    void      times(DL_matrix*,DL_fixmat<R2,C2>*,int n=R);
+                                          // PRE: C==3 && n<=R2 && C2>=3
+};
+
+// a dim x 3 block: the effect of a force, torque or impulse on the
+// constraint error of (any) constraint:
+typedef DL_fixmat<DL_MAXCDIM,3> DL_jacblock;
+// a cc->dim x cf->dim sub-matrix of dC/dR:
+typedef DL_fixmat<DL_MAXCDIM,DL_MAXCDIM> DL_subblock;
+
+// ******************** //
+// inline member bodies //
+// ******************** //
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::makezero(int n,int m) {
+  for (int r=0;r<n;r++)
+    for (int c=0;c<m;c++) a[r][c]=0.0;
+}
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::assign(DL_matrix *mat) {
+  a[0][0]=mat->c0.x; a[0][1]=mat->c1.x; a[0][2]=mat->c2.x;
+  a[1][0]=mat->c0.y; a[1][1]=mat->c1.y; a[1][2]=mat->c2.y;
+  a[2][0]=mat->c0.z; a[2][1]=mat->c1.z; a[2][2]=mat->c2.z;
+}
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::setrow(int r,DL_vector *v) {
+  a[r][0]=v->x; a[r][1]=v->y; a[r][2]=v->z;
+}
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::setcolumn(int c,DL_vector *v) {
+  a[0][c]=v->x; a[1][c]=v->y; a[2][c]=v->z;
+}
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::neg(int n,int m) {
+  for (int r=0;r<n;r++)
+    for (int c=0;c<m;c++) a[r][c]=-a[r][c];
+}
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::plusis(DL_fixmat<R,C> *fm,int n,int m) {
+  for (int r=0;r<n;r++)
+    for (int c=0;c<m;c++) a[r][c]+=fm->a[r][c];
+}
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::minusis(DL_fixmat<R,C> *fm,int n,int m) {
+  for (int r=0;r<n;r++)
+    for (int c=0;c<m;c++) a[r][c]-=fm->a[r][c];
+}
+
+template<int R, int C>
+inline void DL_fixmat<R,C>::timesis(DL_Scalar f,int n,int m) {
+  for (int r=0;r<n;r++)
+    for (int c=0;c<m;c++) a[r][c]*=f;
+}
+
+template<int R, int C> template<int R2, int C2>
+inline void DL_fixmat<R,C>::setsubmatrix(int r,int c,DL_fixmat<R2,C2> *fm,
+					 int n,int m) {
+  for (int ri=0;ri<n;ri++)
+    for (int ci=0;ci<m;ci++) a[r+ri][c+ci]=fm->a[ri][ci];
+}
+
+template<int R, int C> template<int K, int R2, int C2>
+inline void DL_fixmat<R,C>::times(DL_fixmat<C,K> *fm,DL_fixmat<R2,C2> *nfm,
+				  int n) {
+// nfm may not be self or fm
+  DL_Scalar temp;
+  for (int r=0;r<n;r++)
+    for (int k=0;k<K;k++) {
+      temp=0.0;
+      for (int c=0;c<C;c++) temp+=a[r][c]*fm->a[c][k];
+      nfm->a[r][k]=temp;
+    }
+}
+
+template<int R, int C> template<int R2, int C2>
+inline void DL_fixmat<R,C>::times(DL_matrix *mat,DL_fixmat<R2,C2> *nfm,
+				  int n) {
+// nfm may not be self
+  DL_Scalar temp;
+  for (int r=0;r<n;r++) {
+    temp=0.0;
+    temp+=a[r][0]*mat->c0.x; temp+=a[r][1]*mat->c0.y; temp+=a[r][2]*mat->c0.z;
+    nfm->a[r][0]=temp;
+    temp=0.0;
+    temp+=a[r][0]*mat->c1.x; temp+=a[r][1]*mat->c1.y; temp+=a[r][2]*mat->c1.z;
+    nfm->a[r][1]=temp;
+    temp=0.0;
+    temp+=a[r][0]*mat->c2.x; temp+=a[r][1]*mat->c2.y; temp+=a[r][2]*mat->c2.z;
+    nfm->a[r][2]=temp;
+  }
+}
+
+#endif
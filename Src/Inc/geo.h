@@ -149,11 +149,11 @@ inline DL_vector* DL_geo::get_velocity(void) {
 }
 
 inline void DL_geo::set_orientation(DL_matrix *m) {
-  mstate.A.assign(m);
+  mstate.set_A(m);
 }
 
 inline DL_matrix* DL_geo::get_orientation(void) {
-  return &(mstate.A);
+  return mstate.get_A();
 }
 
 inline void DL_geo::set_angvelocity(DL_vector *w) {
@@ -181,11 +181,11 @@ inline DL_vector* DL_geo::get_next_velocity(void) {
 }
 
 inline void DL_geo::set_next_orientation(DL_matrix *m) {
-  nextmstate.A.assign(m);
+  nextmstate.set_A(m);
 }
 
 inline DL_matrix* DL_geo::get_next_orientation(void) {
-  return &(nextmstate.A);
+  return nextmstate.get_A();
 }
 
 inline void DL_geo::set_next_angvelocity(DL_vector *w) {
@@ -198,13 +198,13 @@ inline DL_vector* DL_geo::get_next_angvelocity(void) {
 
 inline void DL_geo::to_world(DL_point *pl, DL_point *pw) {
   DL_vector vtmp;
-  mstate.A.times(pl,pw);
+  mstate.get_A()->times(pl,pw);
   mstate.z.tovector(&vtmp);
   pw->plusis(&vtmp);
 }
 
 inline void DL_geo::to_world(DL_vector *vl, DL_vector *vw) {
-  mstate.A.times(vl,vw);
+  mstate.get_A()->times(vl,vw);
 }
 
 inline void DL_geo::to_local(DL_point *p, DL_geo *g, DL_point *pl) {
@@ -216,7 +216,7 @@ inline void DL_geo::to_local(DL_point *p, DL_geo *g, DL_point *pl) {
     DL_vector vtmp,vl;
     DL_matrix Ainv;
     p->minus(&(mstate.z),&vtmp);
-    mstate.A.invert(&Ainv);
+    mstate.get_A()->invert(&Ainv);
     Ainv.times(&vtmp,&vl);
     vl.topoint(pl);
     return;
@@ -233,7 +233,7 @@ inline void DL_geo::to_local(DL_vector *v, DL_geo *g, DL_vector *vl) {
   }
   if (g==NULL) {
     DL_matrix Ainv;
-    mstate.A.invert(&Ainv);
+    mstate.get_A()->invert(&Ainv);
     Ainv.times(v,vl);
     return;
   }
@@ -246,7 +246,7 @@ inline void DL_geo::get_velocity(DL_point *p, DL_vector *v){
   // p in local coordinates; v in world coordinates
   DL_point pw;
   DL_vector vw;
-  mstate.A.times(p,&pw);
+  mstate.get_A()->times(p,&pw);
   pw.tovector(&vw);
   vw.crossprod(&(mstate.w),v);
   v->plusis(&(mstate.v));  
@@ -254,19 +254,19 @@ inline void DL_geo::get_velocity(DL_point *p, DL_vector *v){
 
 inline void DL_geo::get_velocity(DL_vector *v, DL_vector *vr){
   DL_vector vw;
-  mstate.A.times(v,&vw);
+  mstate.get_A()->times(v,&vw);
   vw.crossprod(&(mstate.w),vr);
 }
 
 inline void DL_geo::new_toworld(DL_point *p, DL_point *pr) {
   DL_vector vtmp;
-  nextmstate.A.times(p,pr);
+  nextmstate.get_A()->times(p,pr);
   nextmstate.z.tovector(&vtmp);
   pr->plusis(&vtmp);
 }
 
 inline void DL_geo::new_toworld(DL_vector *v, DL_vector *vr) {
-  nextmstate.A.times(v,vr);
+  nextmstate.get_A()->times(v,vr);
 }
 
 inline void DL_geo::new_tolocal(DL_point *p, DL_geo *g, DL_point *pl) {
@@ -277,7 +277,7 @@ inline void DL_geo::new_tolocal(DL_point *p, DL_geo *g, DL_point *pl) {
   if (g==NULL) {
     DL_vector vtmp,vl;
     p->minus(&(nextmstate.z),&vtmp);
-    nextmstate.A.transposetimes(&vtmp,&vl); // A's inverse is its transpose
+    nextmstate.get_A()->transposetimes(&vtmp,&vl); // A's inverse is its transpose
     vl.topoint(pl);
     return;
   }
@@ -292,7 +292,7 @@ inline void DL_geo::new_tolocal(DL_vector *v, DL_geo *g, DL_vector *vl) {
     return;
   }
   if (g==NULL) {
-    nextmstate.A.transposetimes(v,vl); // A's inverse is its transpose
+    nextmstate.get_A()->transposetimes(v,vl); // A's inverse is its transpose
     return;
   }
   DL_vector vw;
@@ -304,7 +304,7 @@ inline void DL_geo::get_newvelocity(DL_point *p, DL_vector *v) {
 // p in local coordinates; v in world coordinates
   DL_point pw;
   DL_vector vw;
-  nextmstate.A.times(p,&pw);
+  nextmstate.get_A()->times(p,&pw);
   pw.tovector(&vw);
   vw.crossprod(&(nextmstate.w),v);
   v->plusis(&(nextmstate.v));
@@ -313,7 +313,7 @@ inline void DL_geo::get_newvelocity(DL_point *p, DL_vector *v) {
 inline void DL_geo::get_newvelocity(DL_vector *v, DL_vector *vr) {
 // v in local coordinates; vr in world coordinates
   DL_vector vw;
-  nextmstate.A.times(v,&vw);
+  nextmstate.get_A()->times(v,&vw);
   vw.crossprod(&(nextmstate.w),vr);
 }
 
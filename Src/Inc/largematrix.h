@@ -38,11 +38,24 @@
 
 #include "boolean.h"
 #include "matrix.h"
+#include "fixmat.h"
 #include "largevector.h" 
 #include "minmax.h"
+#include "pool.h"
+#include "simd.h"
 #include "dyna_system.h"
 enum solve_method {lud_bcksub, conjug_grad, svd};
 
+// element arrays are at least this large, so the small matrices used
+// for constraint sub-matrices are never reallocated. Arrays of exactly
+// this size come from a pool instead of the heap:
+#define DL_SMALLMATRIX 36
+extern DL_pool* DL_smallmatrix_pool();
+
+// matrix products with more multiplications than this use the cache
+// blocked kernel (or BLAS, if the library is compiled with -DDL_LAPACK)
+#define DL_SMALLPRODUCT 4096
+
 // ******************** //
 // class DL_largematrix //
 // ******************** //
@@ -63,6 +76,8 @@ class DL_largematrix {
     DL_Scalar *a;  // a[r][c] <=> a[r*nrcols+c]: doing our own address
                // calculation allows for optimisations.
     int asize; // the actual size of a (may be a bit larger than nrelem
+    DL_Scalar* new_elements(int);           // allocate an element array
+    void  delete_elements(DL_Scalar*,int);  // free an element array
 
     // lud representation:
     DL_Scalar *lu; // lower and upper matrices
@@ -70,6 +85,13 @@ class DL_largematrix {
     DL_Scalar d;   // number of row-exchanges in ludcmp odd or even;
     int bandw;     // bandwidth of the matrix (<=0: bandwidth not used)
 
+    // single precision lud representation (see set_mixed_precision()):
+    boolean mixed;        // decompose in single precision and refine?
+    boolean lumixed;      // is the current decomposition the one in luf?
+    boolean mixedstalled; // has refinement stalled since the last resize?
+    float *luf;           // single precision lower and upper matrices
+    DL_Scalar anorm;      // infinity norm of the decomposed matrix
+
     // limited (no sa-array) row indexed sparse storage representation:
     boolean *nonzero; // which element in the full representation is nonzero
     int *ijari;       // non-zero element start/stop indices in ijaci and ijami
@@ -92,6 +114,12 @@ class DL_largematrix {
     // using the bandwidth
     int   ludcmpbw();
     void  lubksbbw(DL_largevector*, DL_largevector*);
+    // in single precision (using the bandwidth if it is small enough)
+    int   ludcmpf();
+    void  lubksbf(DL_largevector*, DL_largevector*);
+    boolean refine(DL_largevector*, DL_largevector*);
+
+    void  timesblocked(DL_largematrix*,DL_largematrix*);
 
     boolean conjug_gradient(DL_largevector*, DL_largevector*);
     void  asolve(DL_largevector*,DL_largevector*);
@@ -117,6 +145,9 @@ class DL_largematrix {
     void  getsubmatrix(int,int,DL_largematrix*);
     void  setsubmatrix(int,int,DL_largematrix*);
     void  setsubmatrixnonzero(int, int, DL_largematrix*);
+    void  setsubmatrix(int,int,int,int,DL_subblock*);
+    void  setsubmatrixnonzero(int,int,int,int,DL_subblock*);
+                 // copy the first nr x nc elements of a constraint block
     void  setsubmatrixzero(int,int,int,int);
     void  setcolumn(int,DL_largevector*);
     void  setcolumn(int,DL_vector*);
@@ -144,6 +175,8 @@ class DL_largematrix {
     void  set_solve_method(solve_method);
     solve_method get_min_solve_method(){ return min_sm; };
     void  set_min_solve_method(solve_method);
+    boolean get_mixed_precision(){ return mixed; };
+    void  set_mixed_precision(boolean);
   
     void  analyse_structure();
     boolean  prep_for_solve();
@@ -164,8 +197,8 @@ inline DL_largematrix::DL_largematrix(int r, int c, solve_method _sm){
   nrrows=r;
   nrcols=c;
   asize=nrelem=r*c;
-  if (asize<36) asize=36;
-  a=new DL_Scalar[asize];
+  if (asize<DL_SMALLMATRIX) asize=DL_SMALLMATRIX;
+  a=new_elements(asize);
   rep=full;
   min_sm=lud_bcksub;
   sm=_sm;
@@ -174,15 +207,31 @@ inline DL_largematrix::DL_largematrix(int r, int c, solve_method _sm){
   indx=NULL;
   nonzero=NULL; ijari=ijaci=ijami=NULL;
   lu=u=w=v=NULL;
+  mixed=lumixed=mixedstalled=FALSE;
+  luf=NULL;
+  anorm=0.0;
 };
 
 inline DL_largematrix::DL_largematrix(DL_largematrix *lm) {
+  nrrows=nrcols=nrelem=0;
+  asize=DL_SMALLMATRIX;
+  a=new_elements(asize);
+  rep=full;
+  min_sm=sm=lud_bcksub;
+  bandw=-1;
+  indx=NULL;
+  nonzero=NULL; ijari=ijaci=ijami=NULL;
+  lu=u=w=v=NULL;
+  mixed=lumixed=mixedstalled=FALSE;
+  luf=NULL;
+  anorm=0.0;
   assign(lm);
 }
 
 inline DL_largematrix::~DL_largematrix() {
-  if (a) delete[] a;
+  if (a) delete_elements(a,asize);
   if (lu) delete[] lu;
+  if (luf) delete[] luf;
   if (indx) delete[] indx;
   if (nonzero) delete[] nonzero;
   if (ijari) {
@@ -195,6 +244,16 @@ inline DL_largematrix::~DL_largematrix() {
   if (w) delete[] w;
 }
 
+inline DL_Scalar* DL_largematrix::new_elements(int n) {
+  if (n==DL_SMALLMATRIX) return (DL_Scalar*)DL_smallmatrix_pool()->alloc();
+  return new DL_Scalar[n];
+}
+
+inline void DL_largematrix::delete_elements(DL_Scalar *e, int n) {
+  if (n==DL_SMALLMATRIX) DL_smallmatrix_pool()->free(e);
+  else delete[] e;
+}
+
 inline void DL_largematrix::reptofull() {
   switch (rep) {
   case full: return;
@@ -271,20 +330,22 @@ inline void DL_largematrix::resize(int r, int c) {
   nrrows=r;
   nrcols=c;
   nrelem=r*c;
-  if ((nrelem>asize) || ((nrelem>36) && (2*nrelem<asize))){
-    // enlarge `a' if the nr of elements won't fit
-    // make `a' smaller if the size of `a' is larger than twice the
-    // new number of elements, except for the cases where `a' is
-    // already rather small (<=36 elements)
-    delete[] a;
+  if (nrelem>asize){
+    // enlarge `a' if the nr of elements won't fit. `a' is never made
+    // smaller, so a matrix that changes size with the number of
+    // constraints (as dCdR does when collisions come and go) only
+    // reallocates when it outgrows its largest size so far
+    if (a) delete_elements(a,asize);
     asize=nrelem;
     if (asize==0) a=NULL;
-    else a=new DL_Scalar[asize];
+    else a=new_elements(asize);
   }
   if (ijari){ delete[] ijari; ijari=NULL; }
   if (ijaci){ delete[] ijaci; ijaci=NULL; }
   if (ijami){ delete[] ijami; ijami=NULL; }
   if (lu) { delete[] lu; lu=NULL; }
+  if (luf) { delete[] luf; luf=NULL; }
+  lumixed=mixedstalled=FALSE;
   if (indx) { delete[] indx; indx=NULL; }
   if (u) { delete[] u; u=NULL; }
   if (v) { delete[] v; v=NULL; }
@@ -416,6 +477,56 @@ inline void DL_largematrix::setsubmatrixnonzero(int r,int c,DL_largematrix* lm){
   }
 }
 
+inline void DL_largematrix::setsubmatrix(int r,int c,int nr,int nc,
+					 DL_subblock* sb){
+// PRE: sb && (r+nr<=nrrows) && (c+nc<=nrcols) && (rep==full/riss)
+  int ri, ci;
+  int r_ri_nrcols_c=r*nrcols+c; // INV: r_ri_nrcols_c==(r+ri)*nrcols+c
+  for (ri=0; ri<nr; ri++) {
+    for (ci=0; ci<nc; ci++)
+      a[r_ri_nrcols_c+ci]=sb->a[ri][ci];
+    r_ri_nrcols_c+=nrcols;
+  }
+}
+
+inline void DL_largematrix::setsubmatrixnonzero(int r,int c,int nr,int nc,
+						DL_subblock* sb){
+// PRE: sb && (r+nr<=nrrows) && (c+nc<=nrcols)
+  switch (rep) {
+  case full: break;
+  case riss:
+    delete[] ijari; ijari=NULL;
+    delete[] ijaci; ijaci=NULL;
+    delete[] ijami; ijami=NULL;
+    rep=full;
+    break;
+  case lud:
+  case ludb:
+    DL_dsystem->get_companion()->Msg("Error: DL_largematrix::setsubmatrixnonzero:\n Can not set elements of a LU decomposed matrix\n");
+    return;
+  case svdcmpd:
+    DL_dsystem->get_companion()->Msg("Error: DL_largematrix::setsubmatrixnonzero:\n Can not set elements of an SV decomposed matrix\n");
+    return;
+  }
+  int ri,ci;
+  if (!nonzero)
+    if (nrrows==nrcols) {
+      nonzero=new boolean[nrelem];
+      for (ri=0;ri<nrelem;ri++) nonzero[ri]=FALSE;
+    }
+    else
+      DL_dsystem->get_companion()->Msg("DL_largematrix::setsubmatrixnonzero is only effective for square matrices. Use DL_largematrix::setsubmatrix instead\n");
+  
+  register int idx0=r*nrcols+c; // INV: idx0==(r+ri)*nrcols+c
+  for (ri=0; ri<nr; ri++) {
+    for (ci=0; ci<nc; ci++) {
+      a[idx0+ci]=sb->a[ri][ci];
+      if (nonzero) nonzero[idx0+ci]=TRUE;
+    }
+    idx0+=nrcols;
+  }
+}
+
 inline void DL_largematrix::setcolumn(int c,DL_largevector* lv) {
 // PRE: lv->dim>=nrrows && 0<=c<nrcols
   switch (rep) {
@@ -543,6 +654,10 @@ inline void DL_largematrix::times(DL_largematrix *lm, DL_largematrix *nlm) {
   int ri_nlm_nrcols=0;
   DL_Scalar temp;
   nlm->reptofull();
+  if (nrrows*nrcols*lm->nrcols>DL_SMALLPRODUCT) {
+    timesblocked(lm,nlm);
+    return;
+  }
   for (ri=0; ri<nlm->nrrows; ri++) {
     for (ci=0; ci<nlm->nrcols; ci++) {
       temp=0.0; i_lm_nrcols_ci=ci;
@@ -652,15 +767,13 @@ inline void DL_largematrix::transposetimes(DL_largevector *lv,DL_largevector *nl
     }
   }
   else {
-    int r,c,c_nrcols_r;
-    DL_Scalar temp;
-    for (r=0; r<nrrows; r++) {
-      temp=0.0; c_nrcols_r=r;
-      for (c=0; c<nrcols; c++) {
-	temp+=a[c_nrcols_r]*lv->get(c);
-	c_nrcols_r+=nrcols;
-      }
-      nlv->set(r,temp);
+    // accumulate the rows (instead of running down the columns), which
+    // adds the same products in the same order:
+    int c,c_nrcols=0;
+    nlv->makezero();
+    for (c=0; c<nrcols; c++) {
+      DL_plus_times(nrrows,lv->get(c),a+c_nrcols,nlv->v);
+      c_nrcols+=nrcols;
     }
   }
 }
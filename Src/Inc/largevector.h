@@ -40,16 +40,30 @@
 #include "boolean.h"
 #include "scalar.h"
 
+// vectors up to this dimension (which covers the restriction vectors
+// of all constraints) keep their coordinates inside the object itself,
+// so they can be created and resized without using the heap:
+#define DL_LARGEVECTOR_INLINE 6
+
 // ******************** //
 // class DL_largevector //
 // ******************** //
 
 class DL_largevector {
   friend class DL_largematrix;
+  friend class DL_tree_solver;
   protected:
     int        dim;  // the dimension of the vector
     int        vsize; // size of v-array; dim<=vsize:
     DL_Scalar* v; // the coordinate array
+    DL_Scalar  vbuf[DL_LARGEVECTOR_INLINE]; // v for small vectors
+    boolean    isview; // v is part of another vector's array
+
+  private:
+    // not copied by value (v may point into vbuf, or into another
+    // vector): use the copy constructor taking a pointer, or assign()
+    DL_largevector(const DL_largevector&);
+    void       operator=(const DL_largevector&);
 
   public:
     int        get_dim() { return dim; };
@@ -60,7 +74,10 @@ class DL_largevector {
     void       init(DL_Scalar,DL_Scalar,DL_Scalar,DL_Scalar,DL_Scalar);
     void       init(DL_Scalar,DL_Scalar,DL_Scalar,DL_Scalar,DL_Scalar,DL_Scalar);
     void       resize(int);
+    void       reserve(int);
     void       makezero(void);
+    void       swap(DL_largevector*);
+    void       view(DL_largevector*,int,int);
     
     DL_Scalar  get(int);
     void       set(int,DL_Scalar);
@@ -73,6 +90,7 @@ class DL_largevector {
     void       normalize();
     DL_Scalar  inprod(DL_largevector*);
     void       plusis(DL_largevector*);
+    void       plusistimes(DL_Scalar,DL_largevector*); // self+=f*lv
     void       minusis(DL_largevector*);
     void       timesis(DL_Scalar);
     boolean    equal(DL_largevector*);
@@ -92,19 +110,68 @@ class DL_largevector {
 
 inline DL_largevector::DL_largevector(int dimension) {
   vsize=dim=dimension;
-  if (vsize<6) vsize=6;
-  v=new DL_Scalar[vsize];
+  isview=FALSE;
+  if (vsize<=DL_LARGEVECTOR_INLINE) {
+    vsize=DL_LARGEVECTOR_INLINE;
+    v=vbuf;
+  }
+  else v=new DL_Scalar[vsize];
+}
+
+inline void DL_largevector::reserve(int size) {
+// make sure the vector can grow to size coordinates without
+// reallocating. This loses all info stored in the vector if it
+// has to reallocate!!!
+  if ((size<=vsize) && !isview) return;
+  if ((v!=vbuf) && !isview) delete[] v;
+  isview=FALSE;
+  if (size<=DL_LARGEVECTOR_INLINE) {
+    vsize=DL_LARGEVECTOR_INLINE;
+    v=vbuf;
+  }
+  else {
+    vsize=size;
+    v=new DL_Scalar[vsize];
+  }
 }
 
 inline void DL_largevector::resize(int newdim) {
 // This loses all info stored in the vector!!!
+// The array is only reallocated when it has to grow, so a vector that
+// is resized to the dimensions of the constraints one after the other
+// keeps the array of the largest. A view is resized in place as long
+// as it fits, and gets an array of its own otherwise.
   if (dim==newdim) return;
+  if (newdim>vsize) reserve(newdim);
   dim=newdim;
-  if ((dim>vsize) || ((dim>6) && (2*dim<vsize))) {
-    if (v) delete[] v;
-    vsize=dim;
-    v=new DL_Scalar[vsize];
+}
+
+inline void DL_largevector::swap(DL_largevector* lv) {
+// exchange the contents (and coordinate arrays) of this vector and lv
+// without copying the coordinates, except for those in vbuf.
+// PRE: lv
+  register int i;
+  DL_Scalar tbuf;
+  for (i=0;i<DL_LARGEVECTOR_INLINE;i++) {
+    tbuf=vbuf[i]; vbuf[i]=lv->vbuf[i]; lv->vbuf[i]=tbuf;
   }
+  DL_Scalar *tv=(lv->v==lv->vbuf ? vbuf : lv->v);
+  lv->v=(v==vbuf ? lv->vbuf : v);
+  v=tv;
+  i=dim;     dim=lv->dim;       lv->dim=i;
+  i=vsize;   vsize=lv->vsize;   lv->vsize=i;
+  boolean tview=isview; isview=lv->isview; lv->isview=tview;
+}
+
+inline void DL_largevector::view(DL_largevector* lv, int idx, int n) {
+// make this vector a view on the n coordinates of lv starting at idx:
+// changes to the one are changes to the other. lv should not be
+// resized or destroyed while the view is used.
+// PRE: lv && (idx+n<=lv->dim)
+  if ((v!=vbuf) && !isview) delete[] v;
+  v=lv->v+idx;
+  dim=vsize=n;
+  isview=TRUE;
 }
 
 inline void DL_largevector::assign(DL_largevector* lv) {
@@ -114,12 +181,15 @@ inline void DL_largevector::assign(DL_largevector* lv) {
 }
 
 inline DL_largevector::DL_largevector(DL_largevector* lv) {
-  v=NULL;
+  dim=0;
+  vsize=DL_LARGEVECTOR_INLINE;
+  v=vbuf;
+  isview=FALSE;
   assign(lv);
 }
 
 inline DL_largevector::~DL_largevector() {
-  delete[] v;
+  if ((v!=vbuf) && !isview) delete[] v;
 }
 
 inline void DL_largevector::init(DL_Scalar c0) {
@@ -182,7 +252,11 @@ inline void DL_largevector::normalize() {
 
 inline DL_Scalar DL_largevector::inprod(DL_largevector* lv) {
 // PRE: (lv->dim>=dim)
+#ifdef DL_DUAL_SCALAR
+  DL_Scalar inp=0.0;
+#else
   double inp=0.0;
+#endif
   if (lv) {
     for (register int i=0; i<dim ;i++) inp+=v[i]*lv->v[i];
   }
@@ -235,6 +309,11 @@ inline void DL_largevector::neg(DL_largevector *nlv) {
   for(register int i=0;i<dim;i++) nlv->v[i]=-v[i];
 }
 
+inline void DL_largevector::plusistimes(DL_Scalar f, DL_largevector *lv) {
+// PRE: lv && (lv->dim>=dim)
+  for(register int i=0;i<dim;i++) v[i]+=f*lv->v[i];
+}
+
 inline void DL_largevector::times(DL_Scalar t, DL_largevector *nlv) {
 // PRE: nlv && (nlv->dim>=dim)
   for(register int i=0;i<dim;i++) nlv->v[i]=v[i]*t;
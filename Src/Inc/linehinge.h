@@ -49,8 +49,10 @@ protected:
   DL_vector dpg0w,dpg1w; // velocity of pg? (in wc; used only if !g_is_dyna) 
   boolean g_is_dyna;
   DL_vector l,x,y; // local coordinate system (in wc)
-  DL_largematrix dcdp0, dcdp1; // dc/dp matrices
-  DL_largematrix df0dR, df1dR; // df/dR matrices
+  DL_fixmat<3,3> dcdp0;  // dc/dp matrices
+  DL_fixmat<2,3> dcdp1;
+  DL_fixmat<3,3> df0dR;  // df/dR matrices
+  DL_fixmat<3,2> df1dR;
 
   void getforce0(DL_largevector*,DL_vector*);  // transform restriction vector to forces:
   void getforce1(DL_largevector*,DL_vector*);  // 0: in  p?0; 1: in p?1
@@ -100,33 +102,33 @@ public:
                      // the dyna's that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
@@ -147,6 +149,9 @@ public:
 		     // decide to deactivate itself
   virtual void get_error(DL_largevector*);
                      // calculate the constraint error vector
+  virtual void save_state(DL_snapshot*);
+  virtual void restore_state(DL_snapshot*);
+                     // save/restore the state carried from frame to frame
   virtual void post_processing(void);
                      // post processing
 
@@ -31,6 +31,7 @@
 
 #include <iostream.h>
 #include "pointvector.h"
+#include "simd.h"
 
 class DL_matrix { 
   public:  
@@ -78,4 +79,100 @@ class DL_matrix {
 
 };
 
+// the products below are used by all the constraint Jacobians and
+// the integrators, so they are inline (and use SSE2 if DL_SSE2 is
+// defined, see simd.h). All operands are read before the result is
+// written, so the result may be one of the operands.
+
+inline void DL_matrix::times(DL_vector *v,DL_vector *nv) {
+  DL_Scalar vx=v->x, vy=v->y, vz=v->z;
+#ifdef DL_SSE2
+  DL_Scalar z=c0.z*vx + c1.z*vy + c2.z*vz;
+  _mm_storeu_pd(&(nv->x),DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),vx,vy,vz));
+  nv->z=z;
+#else
+  nv->x=c0.x * vx + c1.x * vy + c2.x * vz;
+  nv->y=c0.y * vx + c1.y * vy + c2.y * vz;
+  nv->z=c0.z * vx + c1.z * vy + c2.z * vz;
+#endif
+}
+
+inline void DL_matrix::times(DL_point *v,DL_point *nv) {
+  DL_Scalar vx=v->x, vy=v->y, vz=v->z;
+#ifdef DL_SSE2
+  DL_Scalar z=c0.z*vx + c1.z*vy + c2.z*vz;
+  _mm_storeu_pd(&(nv->x),DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),vx,vy,vz));
+  nv->z=z;
+#else
+  nv->x=c0.x * vx + c1.x * vy + c2.x * vz;
+  nv->y=c0.y * vx + c1.y * vy + c2.y * vz;
+  nv->z=c0.z * vx + c1.z * vy + c2.z * vz;
+#endif
+}
+
+inline void DL_matrix::transposetimes(DL_vector *v,DL_vector *nv) {
+  DL_Scalar vx=v->x, vy=v->y, vz=v->z;
+  nv->x=c0.x * vx + c0.y * vy + c0.z * vz;
+  nv->y=c1.x * vx + c1.y * vy + c1.z * vz;
+  nv->z=c2.x * vx + c2.y * vy + c2.z * vz;
+}
+
+inline void DL_matrix::times(DL_matrix *m, DL_matrix *nm) {
+// nm=self*m: column j of nm is self times column j of m
+#ifdef DL_SSE2
+  __m128d r0=DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),m->c0.x,m->c0.y,m->c0.z);
+  __m128d r1=DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),m->c1.x,m->c1.y,m->c1.z);
+  __m128d r2=DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),m->c2.x,m->c2.y,m->c2.z);
+  DL_Scalar z0=c0.z * m->c0.x + c1.z * m->c0.y + c2.z * m->c0.z;
+  DL_Scalar z1=c0.z * m->c1.x + c1.z * m->c1.y + c2.z * m->c1.z;
+  DL_Scalar z2=c0.z * m->c2.x + c1.z * m->c2.y + c2.z * m->c2.z;
+  _mm_storeu_pd(&(nm->c0.x),r0); nm->c0.z=z0;
+  _mm_storeu_pd(&(nm->c1.x),r1); nm->c1.z=z1;
+  _mm_storeu_pd(&(nm->c2.x),r2); nm->c2.z=z2;
+#else
+  DL_matrix r;
+  r.c0.x=c0.x * m->c0.x + c1.x * m->c0.y + c2.x * m->c0.z;
+  r.c1.x=c0.x * m->c1.x + c1.x * m->c1.y + c2.x * m->c1.z;
+  r.c2.x=c0.x * m->c2.x + c1.x * m->c2.y + c2.x * m->c2.z;
+
+  r.c0.y=c0.y * m->c0.x + c1.y * m->c0.y + c2.y * m->c0.z;
+  r.c1.y=c0.y * m->c1.x + c1.y * m->c1.y + c2.y * m->c1.z;
+  r.c2.y=c0.y * m->c2.x + c1.y * m->c2.y + c2.y * m->c2.z;
+
+  r.c0.z=c0.z * m->c0.x + c1.z * m->c0.y + c2.z * m->c0.z;
+  r.c1.z=c0.z * m->c1.x + c1.z * m->c1.y + c2.z * m->c1.z;
+  r.c2.z=c0.z * m->c2.x + c1.z * m->c2.y + c2.z * m->c2.z;
+  *nm=r;
+#endif
+}
+
+inline void DL_matrix::timestranspose(DL_matrix *m, DL_matrix *nm) {
+// nm=self*m^T: column j of nm is self times row j of m
+#ifdef DL_SSE2
+  __m128d r0=DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),m->c0.x,m->c1.x,m->c2.x);
+  __m128d r1=DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),m->c0.y,m->c1.y,m->c2.y);
+  __m128d r2=DL_SSE2_LINCOMB(&(c0.x),&(c1.x),&(c2.x),m->c0.z,m->c1.z,m->c2.z);
+  DL_Scalar z0=c0.z * m->c0.x + c1.z * m->c1.x + c2.z * m->c2.x;
+  DL_Scalar z1=c0.z * m->c0.y + c1.z * m->c1.y + c2.z * m->c2.y;
+  DL_Scalar z2=c0.z * m->c0.z + c1.z * m->c1.z + c2.z * m->c2.z;
+  _mm_storeu_pd(&(nm->c0.x),r0); nm->c0.z=z0;
+  _mm_storeu_pd(&(nm->c1.x),r1); nm->c1.z=z1;
+  _mm_storeu_pd(&(nm->c2.x),r2); nm->c2.z=z2;
+#else
+  DL_matrix r;
+  r.c0.x=c0.x * m->c0.x + c1.x * m->c1.x + c2.x * m->c2.x;
+  r.c1.x=c0.x * m->c0.y + c1.x * m->c1.y + c2.x * m->c2.y;
+  r.c2.x=c0.x * m->c0.z + c1.x * m->c1.z + c2.x * m->c2.z;
+
+  r.c0.y=c0.y * m->c0.x + c1.y * m->c1.x + c2.y * m->c2.x;
+  r.c1.y=c0.y * m->c0.y + c1.y * m->c1.y + c2.y * m->c2.y;
+  r.c2.y=c0.y * m->c0.z + c1.y * m->c1.z + c2.y * m->c2.z;
+
+  r.c0.z=c0.z * m->c0.x + c1.z * m->c1.x + c2.z * m->c2.x;
+  r.c1.z=c0.z * m->c0.y + c1.z * m->c1.y + c2.z * m->c2.y;
+  r.c2.z=c0.z * m->c0.z + c1.z * m->c1.z + c2.z * m->c2.z;
+  *nm=r;
+#endif
+}
+
 #endif
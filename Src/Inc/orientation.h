@@ -49,7 +49,8 @@ protected:
   DL_vector w1w,w2w;    // w? in wc (only calculated once if !g_is_dyna)
   DL_vector dw1w,dw2w; // velocity of w? (in wc; used only if !g_is_dyna) 
   boolean g_is_dyna;
-  DL_largematrix dcdv0,dcdv1,dcdw1,dcdw2,dfdr;
+  DL_fixmat<3,3> dcdv0,dcdw2,dfdr;
+  DL_fixmat<1,3> dcdv1,dcdw1;
   
   void gettorque(DL_largevector*,DL_vector*);
 public:
@@ -91,33 +92,33 @@ public:
                      // the dyna's that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
@@ -138,6 +139,10 @@ public:
 		     // decide to deactivate itself
   virtual void get_error(DL_largevector*);
                      // calculate the constraint error vector
+  virtual boolean remappable(void){ return TRUE; }
+  virtual void remap(DL_dyna*, DL_dyna*, DL_matrix*, DL_vector*);
+                     // move the constraint from a dyna to a compound
+		     // (see DL_constraint::remap)
 };
 
 #endif
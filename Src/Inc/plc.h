@@ -53,8 +53,10 @@ protected:
   DL_vector v0,w1,w2; // lc of l in d; x and y in g
   DL_vector w1w,w2w; // wc of w?
   DL_vector dw1w,dw2w; // velocity of w? (in wc; used only if !g_is_dyna)
-  DL_largematrix dcdp,dcdv0,dcdw; // dc/dp matrices
-  DL_largematrix dfdR,dmdR; // df/dR matrices
+  DL_fixmat<1,3> dcdp,dcdw; // dc/dp matrices
+  DL_fixmat<2,3> dcdv0;
+  DL_fixmat<3,1> dfdR;      // df/dR matrices
+  DL_fixmat<3,2> dmdR;
 
   void getforce(DL_largevector*,DL_vector*);  // transform restriction vector
   void gettorque(DL_largevector*,DL_vector*); // to force and torque
@@ -94,33 +96,33 @@ public:
                      // the dyna's that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
@@ -141,6 +143,9 @@ public:
 		     // decide to deactivate itself
   virtual void get_error(DL_largevector*);
                      // calculate the constraint error vector
+  virtual void save_state(DL_snapshot*);
+  virtual void restore_state(DL_snapshot*);
+                     // save/restore the state carried from frame to frame
 };
 
 #endif
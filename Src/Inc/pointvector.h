@@ -36,7 +36,7 @@
 #include <math.h>
 #include "boolean.h"
 #include "scalar.h"
-#include "list.h"
+#include "simd.h"
 
 class DL_point;
 class DL_vector;
@@ -79,7 +79,7 @@ class DL_vector {
 // class DL_point //
 // ************** //
 
-class DL_point : public DL_ListElem {
+class DL_point {
   public:   
     DL_Scalar  x,y,z;
 
@@ -98,10 +98,10 @@ class DL_point : public DL_ListElem {
                DL_point();                  // constructor
 	       DL_point(DL_point*);         // copy constructor
                DL_point(DL_Scalar,DL_Scalar,DL_Scalar); // constructor
-	       ~DL_point(){};               // destructor
+               // (no destructor, so the point is trivially copyable)
 };
 
-inline DL_point::DL_point():DL_ListElem() {
+inline DL_point::DL_point() {
 //  x=y=z=0;
 };
 
@@ -209,22 +209,43 @@ inline void DL_vector::normalize() {
   }
 };
 
+// the arithmetic below is used by all the constraint Jacobians and
+// the integrators, so it uses SSE2 for the x and y components if
+// DL_SSE2 is defined (see simd.h), with the same operations as the
+// plain code. All operands are read before the result is written, so
+// the result may be one of the operands.
+
 inline void DL_vector::plusis(DL_vector* v) { 
+#ifdef DL_SSE2
+  _mm_storeu_pd(&x,_mm_add_pd(_mm_loadu_pd(&x),_mm_loadu_pd(&(v->x))));
+  z = z+v->z;
+#else
     x = x+v->x; 
     y = y+v->y; 
     z = z+v->z;
+#endif
 };
 
 inline void DL_vector::minusis(DL_vector* v) { 
+#ifdef DL_SSE2
+  _mm_storeu_pd(&x,_mm_sub_pd(_mm_loadu_pd(&x),_mm_loadu_pd(&(v->x))));
+  z = z-v->z;
+#else
     x = x-v->x; 
     y = y-v->y; 
     z = z-v->z;
+#endif
 };
 
 inline void DL_vector::timesis(DL_Scalar f) { 
+#ifdef DL_SSE2
+  _mm_storeu_pd(&x,_mm_mul_pd(_mm_loadu_pd(&x),_mm_set1_pd(f)));
+  z = z*f;
+#else
     x = x*f; 
     y = y*f; 
     z = z*f;
+#endif
 };
 
 inline boolean DL_vector::equal(DL_vector* v) {
@@ -253,15 +274,27 @@ inline void DL_vector::set(int r,DL_Scalar f) {
 
 
 inline void DL_vector::plus(DL_vector* v,DL_vector *nv) { 
+#ifdef DL_SSE2
+  DL_Scalar nz=z + v->z;
+  _mm_storeu_pd(&(nv->x),_mm_add_pd(_mm_loadu_pd(&x),_mm_loadu_pd(&(v->x))));
+  nv->z=nz;
+#else
   nv->x=x + v->x;
   nv->y=y + v->y; 
   nv->z=z + v->z;
+#endif
 };
 
 inline void DL_vector::minus(DL_vector *v,DL_vector *nv) { 
+#ifdef DL_SSE2
+  DL_Scalar nz=z - v->z;
+  _mm_storeu_pd(&(nv->x),_mm_sub_pd(_mm_loadu_pd(&x),_mm_loadu_pd(&(v->x))));
+  nv->z=nz;
+#else
   nv->x=x - v->x; 
   nv->y=y - v->y; 
   nv->z=z - v->z;
+#endif
 };
 
 inline void DL_vector::neg(DL_vector *nv) {         
@@ -271,19 +304,42 @@ inline void DL_vector::neg(DL_vector *nv) {
 }
 
 inline void DL_vector::times(DL_Scalar t, DL_vector *nv) {
+#ifdef DL_SSE2
+  DL_Scalar nz=z*t;
+  _mm_storeu_pd(&(nv->x),_mm_mul_pd(_mm_loadu_pd(&x),_mm_set1_pd(t)));
+  nv->z=nz;
+#else
   nv->x=x*t;
   nv->y=y*t;
   nv->z=z*t;
+#endif
 };
 
 inline void DL_vector::crossprod(DL_vector *v,DL_vector *nv) {
-  nv->x=y*v->z - z*v->y;
-  nv->y=z*v->x - x*v->z;
+#ifdef DL_SSE2
+  // (y,z)*(v.z,v.x) - (z,x)*(v.y,v.z) gives the x and y components:
+  __m128d a=_mm_loadu_pd(&y), b=_mm_loadu_pd(&(v->y));
+  __m128d ra=_mm_shuffle_pd(a,_mm_loadu_pd(&x),1);
+  __m128d rb=_mm_shuffle_pd(b,_mm_loadu_pd(&(v->x)),1);
+  DL_Scalar nz=x*v->y - y*v->x;
+  _mm_storeu_pd(&(nv->x),_mm_sub_pd(_mm_mul_pd(a,rb),_mm_mul_pd(ra,b)));
+  nv->z=nz;
+#else
+  DL_Scalar nx=y*v->z - z*v->y;
+  DL_Scalar ny=z*v->x - x*v->z;
   nv->z=x*v->y - y*v->x;
+  nv->x=nx;
+  nv->y=ny;
+#endif
 };
 
 inline DL_Scalar DL_vector::inprod(DL_vector *v) {
+#ifdef DL_SSE2
+  __m128d p=_mm_mul_pd(_mm_loadu_pd(&x),_mm_loadu_pd(&(v->x)));
+  return (_mm_cvtsd_f64(p) + _mm_cvtsd_f64(_mm_unpackhi_pd(p,p))) + z*v->z;
+#else
   return x*v->x + y*v->y + z*v->z;
+#endif
 };
 
 
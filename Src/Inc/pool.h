@@ -0,0 +1,87 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename	: pool.h
+// description	: pool of equally sized memory blocks. Blocks are taken
+//                from big chunks (which are only returned to the system
+//                when the pool is destroyed) and are recycled through a
+//                free list, so allocating and freeing a block are just a
+//                few pointer operations. Used for the objects that are
+//                created and deleted in large numbers every frame or
+//                every rebuild of dCdR (collisions, constraint pairs and
+//                the element arrays of small matrices).
+//
+
+#ifndef DL_POOLH
+#define DL_POOLH
+
+#include <stdlib.h>
+
+// ************* //
+// class DL_pool //
+// ************* //
+
+class DL_pool {
+  protected:
+    struct DL_poolblock { DL_poolblock *next; };
+
+    size_t blocksize;        // size of the blocks (in bytes)
+    int    chunksize;        // number of blocks per chunk
+    DL_poolblock *freelist;  // the free blocks
+    DL_poolblock *chunks;    // the allocated chunks (linked through their
+                             // first block)
+    int    nrused;           // number of blocks currently in use
+
+    void   newchunk(void);   // add a chunk of blocks to the free list
+
+  public:
+    void*  alloc(void);      // get a block
+    void   free(void*);      // return a block (which has to come from alloc)
+    size_t get_blocksize(void){ return blocksize; };
+    int    get_nrused(void){ return nrused; };
+
+           DL_pool(size_t,int=64); // constructor (blocksize, chunksize)
+	   ~DL_pool();             // destructor
+};
+
+inline void* DL_pool::alloc(void) {
+  if (!freelist) newchunk();
+  DL_poolblock *b=freelist;
+  freelist=b->next;
+  nrused++;
+  return (void*)b;
+}
+
+inline void DL_pool::free(void *p) {
+  if (!p) return;
+  DL_poolblock *b=(DL_poolblock*)p;
+  b->next=freelist;
+  freelist=b;
+  nrused--;
+}
+
+#endif
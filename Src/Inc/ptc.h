@@ -56,9 +56,9 @@ class DL_ptc : public DL_constraint {
                    // make the local local coordinate system with d (expressed in
 		   // world coordinates).
   DL_Scalar ddinv;     // 1.0/d->inprod(d)
-  DL_largematrix dcdp; // the matrix dc/dp of which the two rows consist of
+  DL_fixmat<2,3> dcdp; // the matrix dc/dp of which the two rows consist of
                        // x and y
-  DL_largematrix dfdR; // the matrix df/dR of which the two columns consist of
+  DL_fixmat<3,2> dfdR; // the matrix df/dR of which the two columns consist of
                        // x and y
   DL_point csl;   // the curve position for this frame (in local coordinates);
                    // only valid if cg_is_dyna;
@@ -99,33 +99,33 @@ public:
                      // the dyna's that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
@@ -147,6 +147,9 @@ public:
 		     // decide to deactivate itself
   virtual void get_error(DL_largevector*);
                      // calculate the constraint error vector
+  virtual void save_state(DL_snapshot*);
+  virtual void restore_state(DL_snapshot*);
+                     // save/restore the state carried from frame to frame
 };
 
 #endif
@@ -0,0 +1,87 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename	: ptrmap.h
+// description	: hash map from pointers to pointers. Used to find the
+//                DL_geo (or DL_dyna) belonging to a companion in
+//                (expected) constant time. The entries come from a
+//                DL_pool, so inserting and removing do not go through
+//                the heap.
+//
+
+#ifndef DL_PTRMAPH
+#define DL_PTRMAPH
+
+#include "pool.h"
+
+// *************** //
+// class DL_ptrmap //
+// *************** //
+
+class DL_ptrmap {
+  protected:
+    struct DL_ptrmapentry {
+      void *key;
+      void *value;
+      DL_ptrmapentry *next;
+    };
+
+    DL_ptrmapentry **table;  // the buckets (chains of entries)
+    int    tablesize;        // number of buckets (always a power of 2)
+    int    nrelem;           // number of entries in the map
+    DL_pool entries;         // where the entries are allocated
+
+    int    bucket(void*);    // the bucket a key belongs in
+    void   rehash(int);      // resize the table to the given nr of buckets
+
+  public:
+    void*  find(void*);         // return the value for the key (or NULL)
+    void   insert(void*,void*); // set the value for the key
+    void*  remove(void*);       // remove the key, returns its value
+    void   clear(void);         // remove all entries
+    int    length(void){ return nrelem; };
+
+           DL_ptrmap(int=64);  // constructor (initial number of buckets)
+	   ~DL_ptrmap();       // destructor
+};
+
+inline int DL_ptrmap::bucket(void *key) {
+  // pointers are aligned, so skip the lower bits and mix the rest:
+  unsigned long h=((unsigned long)key)>>3;
+  h^=(h>>11)^(h>>19);
+  return (int)(h&(unsigned long)(tablesize-1));
+}
+
+inline void* DL_ptrmap::find(void *key) {
+  DL_ptrmapentry *e=table[bucket(key)];
+  while (e) {
+    if (e->key==key) return e->value;
+    e=e->next;
+  }
+  return NULL;
+}
+
+#endif
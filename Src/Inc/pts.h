@@ -58,8 +58,8 @@ class DL_pts : public DL_constraint {
 	  	   // world coordinates).
   DL_Scalar xxinv;     // 1.0/x->inprod(x)
   DL_Scalar yyinv;     // 1.0/y->inprod(y)
-  DL_largematrix dcdp; // the matrix dc/dp of which the one row consist of n
-  DL_largematrix dfdR; // the matrix df/dR of which the one column consist of n
+  DL_fixmat<1,3> dcdp; // the matrix dc/dp of which the one row consist of n
+  DL_fixmat<3,1> dfdR; // the matrix df/dR of which the one column consist of n
   DL_point sstl; // the surface position for this frame (in local coordinates);
                  // only valid if sg_is_dyna;  
   DL_point sstf; // surface(sf,tf) (in local coordinates)
@@ -100,33 +100,33 @@ public:
                      // the dyna's that testing has ended
 
   // methods for analytical dC/dR determination:
-  virtual boolean dCdRsub(DL_constraint*, DL_largematrix*);
+  virtual boolean dCdRsub(DL_constraint*, DL_subblock*);
                      // return the submatrix of dCdR that shows the
 		     // relation between the restriction value of this
 		     // constraint and the constraint error of
 		     // the constraint supplied as parameter
                      // the dimension of sub is cf->dim x dim;
 		     // Returns if there is any effect at all (!result=>(m==0))
-  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdFq(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a (non-central) force to the point of
 		     // the dyna on the constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdfq has dimensions dim x 3
-  virtual boolean dCdF(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdF(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a central force to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all
 		     // (!result=>(m==0))
                      // dcdf has dimensions dim x 3
-  virtual boolean dCdM(DL_dyna*,DL_largematrix*);
+  virtual boolean dCdM(DL_dyna*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of a torque to the dyna on the
 		     // constraint error of this constraint.
 		     // Returns if there is any effect at all (!result=>(m==0))
                      // dcdm has dimensions dim x 3
-  virtual boolean dCdI(DL_dyna*,DL_point*,DL_largematrix*);
+  virtual boolean dCdI(DL_dyna*,DL_point*,DL_jacblock*);
                      // calculate the matrix that shows the effect of
 		     // application of an impulse to the point of
 		     // the dyna on the constraint error of this constraint.
@@ -148,6 +148,9 @@ public:
 		     // decide to deactivate itself
   virtual void get_error(DL_largevector*);
                      // calculate the constraint error vector
+  virtual void save_state(DL_snapshot*);
+  virtual void restore_state(DL_snapshot*);
+                     // save/restore the state carried from frame to frame
 };
 
 #endif
@@ -0,0 +1,110 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename	: recorder.h
+// description	: records the trajectories of all dynas (and the
+//                restriction values of all constraints) to a trajectory
+//                file (see recording.h for the format and the reader).
+//                Each frame the values are only copied into a ring of
+//                blocks; full blocks are encoded and written by a
+//                separate thread, so the simulation does not wait for
+//                the disk. Define DL_NO_THREADS to have the blocks
+//                written synchronously instead (this is also done on
+//                _WINDOWS).
+//
+
+#ifndef DL_RECORDERH
+#define DL_RECORDERH
+
+#include <stdio.h>
+#include "boolean.h"
+#include "recording.h"
+#include "ptrmap.h"
+
+#if !defined(DL_NO_THREADS) && !defined(_WINDOWS)
+#define DL_RECORDER_THREAD
+#include <pthread.h>
+#endif
+
+#define DL_RECORDER_BLOCKS 4 // number of blocks in the ring
+
+class DL_dyna;
+class DL_constraint;
+
+// ***************** //
+// class DL_recorder //
+// ***************** //
+
+class DL_recorder {
+  protected:
+    FILE *f;
+    DL_recording_header hdr;
+    int  nrdynas;
+    DL_dyna **dynas;             // the recorded dynas
+    int  *cdim;                  // the dimensions of the recorded
+                                 // constraints (when recording started)
+    int  *ccol;                  // and their first columns in a row
+    long *cserial;               // and their serial numbers
+    DL_ptrmap cindex;            // from the recorded constraints to their
+                                 // entry in cdim (they are only looked
+                                 // up, never dereferenced: they may have
+                                 // been deleted since, and a new
+                                 // constraint at the same address is told
+                                 // apart by its serial number)
+    float *ring;                 // DL_RECORDER_BLOCKS blocks of frames
+    int  blockframes[DL_RECORDER_BLOCKS]; // nr of frames in full blocks
+    int  fill;                   // nr of frames in the block being filled
+    int  wblock;                 // the block being filled
+    int  rblock;                 // the next block to be written
+    int  nrfull;                 // number of full blocks waiting
+    int  nrframes;               // number of frames recorded
+    boolean closing;             // no more blocks will follow
+    boolean failed;              // a write has failed (guarded by lock)
+    unsigned char *out;          // the encoded block (writer only)
+#ifdef DL_RECORDER_THREAD
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    static void* writer(void*);  // the writer thread
+#endif
+    void hand_over(void);        // pass the filled block to the writer
+    boolean write_block(int);    // encode and write a full block (returns
+                                 // if it succeeded)
+  public:
+    boolean open(const char*,boolean=FALSE,int=64);
+                                 // start recording to a file (filename,
+                                 // compress, frames per block)
+    void    record(void);        // record the current frame (call after
+                                 // each call of DL_dyna_system::dynamics())
+    void    close(void);         // write what is left and close the file
+    boolean recording(void){ return f!=NULL; };
+    int     frames_recorded(void){ return nrframes; };
+
+            DL_recorder();       // constructor
+	    ~DL_recorder();      // destructor
+};
+
+#endif
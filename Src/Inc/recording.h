@@ -0,0 +1,137 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename	: recording.h
+// description	: reader for trajectory files written by DL_recorder.
+//                A trajectory file consists of a header, the dimensions
+//                of the recorded constraints, and a sequence of blocks of
+//                frames. Within a block the values are stored per column
+//                (all values of one column for all frames of the block
+//                together), optionally delta compressed, so single
+//                columns (one coordinate of one body, say) can be read
+//                without decoding the rest.
+//                Each frame (row) has the following columns:
+//                  0                  : time
+//                  1+7*i .. 3+7*i     : position of dyna i
+//                  4+7*i .. 7+7*i     : orientation (quaternion) of dyna i
+//                  after the dynas    : the restriction values of the
+//                                       constraints (dim values each)
+//                All values are stored as floats, in the byte order of
+//                the machine that wrote the file.
+//
+
+#ifndef DL_RECORDINGH
+#define DL_RECORDINGH
+
+#include <stdio.h>
+#include "boolean.h"
+#include "pointvector.h"
+#include "matrix.h"
+#include "largevector.h"
+
+#define DL_RECORDING_VERSION 1
+
+// the header of a trajectory file:
+struct DL_recording_header {
+  char magic[4];      // "DLTR"
+  int  version;       // DL_RECORDING_VERSION
+  int  nrdynas;       // number of recorded dynas
+  int  nrconstraints; // number of recorded constraints
+  int  width;         // number of columns (values per frame)
+  int  blockframes;   // maximum number of frames per block
+  int  compressed;    // are the columns delta compressed?
+  int  reserved;
+};
+
+// each block starts with:
+struct DL_recording_block {
+  int  nrframes;      // number of frames in this block
+  int  nrbytes;       // size of the rest of the block
+};
+// followed (for compressed blocks only) by the offsets of the columns
+// (width ints, relative to the end of the offset table), and the column
+// data. An uncompressed column is nrframes floats, a compressed column
+// is its first float followed by the bitwise exclusive-or of each value
+// with the previous one, stored as a variable length (7 bits per byte)
+// integer. Values that change little share their sign, exponent and
+// leading mantissa bits with their predecessor, so these integers are
+// small.
+
+// ****************** //
+// class DL_recording //
+// ****************** //
+
+class DL_recording {
+  protected:
+    FILE *f;
+    DL_recording_header hdr;
+    int *dims;           // dimensions of the recorded constraints
+    int *cstart;         // first column of each constraint
+    int  nrblocks;
+    int  nrframes;
+    long *blockpos;      // file position of the data of each block
+    int  *blockstart;    // first frame of each block
+    int  *blocksize;     // number of frames in each block
+    int  *blockbytes;    // size of the data of each block
+    unsigned char *buf;  // raw block data
+    int  bufsize;
+    int  cacheblock;     // the block decoded in cache (-1: none)
+    float *cache;        // decoded block (frame by frame)
+
+    int     find_block(int);              // block containing a frame
+    boolean read_block(int);              // read raw block data into buf
+    boolean decode_block(int);            // decode a block into cache
+    void    decode_column(int,int,float*,int); // decode a column of the
+                                          // block in buf (stride given)
+  public:
+    boolean open(const char*);            // open a trajectory file
+    void    close(void);                  // close it
+
+    int     nr_frames(void){ return nrframes; };
+    int     nr_dynas(void){ return hdr.nrdynas; };
+    int     nr_constraints(void){ return hdr.nrconstraints; };
+    int     constraint_dim(int c){ return dims[c]; };
+    int     width(void){ return hdr.width; };
+
+    int     time_column(void){ return 0; };
+    int     position_column(int d){ return 1+7*d; };
+    int     orientation_column(int d){ return 4+7*d; };
+    int     restriction_column(int c){ return cstart[c]; };
+
+    boolean get_frame(int,float*);        // all values of a frame
+    boolean get_column(int,float*);       // the values of a column for
+                                          // all frames
+    DL_Scalar get_time(int);              // time of a frame
+    boolean get_position(int,int,DL_point*);     // (frame, dyna, position)
+    boolean get_orientation(int,int,DL_matrix*); // (frame, dyna, orientation)
+    boolean get_restriction(int,int,DL_largevector*);
+                                          // (frame, constraint, restriction)
+
+            DL_recording();               // constructor
+	    ~DL_recording();              // destructor
+};
+
+#endif
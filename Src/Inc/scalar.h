@@ -24,6 +24,44 @@
 		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
 */
 
-#ifndef DL_Scalar
-#define DL_Scalar double
+//
+// filename	: scalar.h
+// description	: the scalar type used throughout the library. This is a
+//                double, unless the library (and the application using
+//                it) is compiled with -DDL_SINGLE_PRECISION, which makes
+//                it a float (see the libf target in makefile.dynamo),
+//                or with -DDL_DUAL_SCALAR, which makes it a dual number
+//                carrying derivatives (see dual.h and the libd target).
+//                The tolerances that depend on the precision are
+//                defined here as well.
+//
+
+#ifndef DL_SCALARH
+#define DL_SCALARH
+
+#include <float.h>
+
+#ifdef DL_SINGLE_PRECISION
+typedef float DL_Scalar;
+#define DL_SCALAR_EPSILON FLT_EPSILON // smallest e with 1+e!=1
+#define DL_SCALAR_MAX     FLT_MAX
+#define DL_TINY           1.0e-6f     // singularity threshold
+#elif defined(DL_DUAL_SCALAR)
+#include "dual.h"
+typedef DL_dual DL_Scalar;
+#define DL_SCALAR_EPSILON DBL_EPSILON // smallest e with 1+e!=1
+#define DL_SCALAR_MAX     DBL_MAX
+#define DL_TINY           1.0e-10     // singularity threshold
+#else
+typedef double DL_Scalar;
+#define DL_SCALAR_EPSILON DBL_EPSILON // smallest e with 1+e!=1
+#define DL_SCALAR_MAX     DBL_MAX
+#define DL_TINY           1.0e-10     // singularity threshold
+#endif
+
+#ifndef DL_DUAL_SCALAR
+// the value of a scalar (without derivatives, see dual.h):
+inline double DL_value(DL_Scalar a) { return a; }
+#endif
+
 #endif
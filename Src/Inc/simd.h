@@ -0,0 +1,76 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename	: simd.h
+// description	: build time selection of the SIMD kernels used by
+//                DL_vector, DL_matrix, DL_vector4 and DL_largematrix.
+//                Compile with -DDL_SSE2 to use SSE2 for the vector
+//                arithmetic, the matrix products, the quaternion
+//                operations and the dense matrix kernels;
+//                without it the plain scalar code (the reference
+//                implementation) is used. Both evaluate every
+//                element with the same operations in the same order, so
+//                they give bit-identical results, which is what a build
+//                of each can be verified against.
+//                The vectors keep their packed three-scalar layout, so
+//                unaligned loads are used (two scalars per register; the
+//                third component is done separately).
+//
+
+#ifndef DL_SIMDH
+#define DL_SIMDH
+
+#include "scalar.h"
+
+#ifdef DL_SSE2
+#include <emmintrin.h>
+
+#if defined(DL_SINGLE_PRECISION) || defined(DL_DUAL_SCALAR)
+#error the SSE2 kernels work on double precision scalars only
+#endif
+
+// multiply the (x,y) parts of three columns with three scalars
+// and add them: c0*a + c1*b + c2*c (evaluated from left to right)
+#define DL_SSE2_LINCOMB(c0,c1,c2,a,b,c) \
+  _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(c0),_mm_set1_pd(a)), \
+                        _mm_mul_pd(_mm_loadu_pd(c1),_mm_set1_pd(b))), \
+             _mm_mul_pd(_mm_loadu_pd(c2),_mm_set1_pd(c)))
+#endif
+
+// y[i]+=f*x[i] for 0<=i<n: the inner loop of the dense matrix kernels
+// of DL_largematrix (x and y are rows of row-major matrices)
+inline void DL_plus_times(int n, DL_Scalar f, DL_Scalar *x, DL_Scalar *y) {
+  int i=0;
+#ifdef DL_SSE2
+  __m128d ff=_mm_set1_pd(f);
+  for (;i+1<n;i+=2)
+    _mm_storeu_pd(y+i,_mm_add_pd(_mm_loadu_pd(y+i),
+				 _mm_mul_pd(ff,_mm_loadu_pd(x+i))));
+#endif
+  for (;i<n;i++) y[i]+=f*x[i];
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+//
+// filename	: snapshot.h
+// description	: a snapshot of the state of the whole simulation (all
+//                dynas, the active constraints, the integrator step sizes,
+//                time and frame number), which can be restored later to
+//                roll back the simulation. The state is kept as one
+//                header followed by a flat array of scalars, which is also
+//                exactly the format of the file it can be saved to, so a
+//                saved snapshot can be memory-mapped and attached without
+//                copying or parsing.
+//
+
+#ifndef DL_SNAPSHOTH
+#define DL_SNAPSHOTH
+
+#include "boolean.h"
+#include "supvec.h"
+#include "largevector.h"
+
+#define DL_SNAPSHOT_VERSION 2
+
+// the header of a snapshot image (its size is a multiple of
+// sizeof(DL_Scalar) so the values following it are properly aligned):
+struct DL_snapshot_header {
+  char magic[4];     // "DLSS"
+  int  version;      // DL_SNAPSHOT_VERSION
+  int  scalarsize;   // sizeof(DL_Scalar) of the library that wrote it
+  int  nrdynas;      // number of dynas in the snapshot
+  int  nrconstraints;// number of (active) constraints in the snapshot
+  int  frame_nr;     // the frame number
+  int  nrvalues;     // number of values following the header
+  int  reserved;
+  DL_Scalar time;    // the time
+  DL_Scalar h;       // integrator step size
+  DL_Scalar oldh;    // integrator step size of the previous frame
+};
+
+// ***************** //
+// class DL_snapshot //
+// ***************** //
+
+class DL_snapshot {
+  protected:
+    DL_snapshot_header hdr; // the header (if the image is not attached)
+    DL_snapshot_header *h;  // the header in use
+    DL_Scalar *data;        // the values
+    int maxvalues;          // allocated size of data (0 if attached)
+    int pos;                // read position
+    boolean readerror;      // tried to read beyond the values or
+                            // found mismatching dimensions
+
+    void grow(int);         // make room for at least n values
+    void reset(void);       // empty snapshot
+  public:
+    /// for external (to DL) use:
+    void    take(void);             // record the state of the simulation
+    boolean restore(void);          // put the simulation back in the
+                                    // recorded state
+    boolean save(const char*);      // write the image to a file
+    boolean load(const char*);      // read the image from a file
+    boolean attach(void*,long);     // use an image in memory (for example
+                                    // a memory-mapped file) without copying
+    boolean empty(void){ return h->nrvalues==0 && h->nrdynas==0; };
+    int     frame_number(void){ return h->frame_nr; };
+    DL_Scalar time(void){ return h->time; };
+    long    image_size(void);       // size of the image (in bytes)
+
+            DL_snapshot();          // constructor
+	    ~DL_snapshot();         // destructor
+
+    /// for internal (DL) use only:
+    DL_snapshot_header* header(void){ return h; };
+    void    begin_write(void);      // start recording values
+    void    begin_read(void);       // start reading back values
+    boolean read_ok(void){ return !readerror; };
+    void    fail(void){ readerror=TRUE; };
+
+    void    put(DL_Scalar);
+    void    put(DL_vector*);
+    void    put(DL_point*);
+    void    put(DL_vector4*);
+    void    put(DL_matrix*);
+    void    put(DL_supvec*);
+    void    put(DL_largevector*);
+
+    DL_Scalar get(void);
+    void    get(DL_vector*);
+    void    get(DL_point*);
+    void    get(DL_vector4*);
+    void    get(DL_matrix*);
+    void    get(DL_supvec*);
+    void    get(DL_largevector*);
+};
+
+inline void DL_snapshot::put(DL_Scalar s) {
+  if (h->nrvalues>=maxvalues) grow(h->nrvalues+1);
+  data[h->nrvalues++]=s;
+}
+
+inline DL_Scalar DL_snapshot::get(void) {
+  if (pos>=h->nrvalues) {
+    readerror=TRUE;
+    return 0;
+  }
+  return data[pos++];
+}
+
+inline void DL_snapshot::put(DL_vector *v) {
+  put(v->x); put(v->y); put(v->z);
+}
+
+inline void DL_snapshot::get(DL_vector *v) {
+  v->x=get(); v->y=get(); v->z=get();
+}
+
+inline void DL_snapshot::put(DL_point *p) {
+  put(p->x); put(p->y); put(p->z);
+}
+
+inline void DL_snapshot::get(DL_point *p) {
+  p->x=get(); p->y=get(); p->z=get();
+}
+
+inline void DL_snapshot::put(DL_vector4 *q) {
+  put(q->c[0]); put(q->c[1]); put(q->c[2]); put(q->c[3]);
+}
+
+inline void DL_snapshot::get(DL_vector4 *q) {
+  q->c[0]=get(); q->c[1]=get(); q->c[2]=get(); q->c[3]=get();
+}
+
+inline void DL_snapshot::put(DL_matrix *m) {
+  put(&(m->c0)); put(&(m->c1)); put(&(m->c2));
+}
+
+inline void DL_snapshot::get(DL_matrix *m) {
+  get(&(m->c0)); get(&(m->c1)); get(&(m->c2));
+}
+
+inline void DL_snapshot::put(DL_supvec *s) {
+  put(&(s->z)); put(&(s->v)); put(&(s->q)); put(&(s->w)); put(s->get_A());
+}
+
+inline void DL_snapshot::get(DL_supvec *s) {
+  get(&(s->z)); get(&(s->v)); get(&(s->q)); get(&(s->w)); get(s->get_A());
+}
+
+#endif
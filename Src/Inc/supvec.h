@@ -32,6 +32,9 @@
 //              on the whole vector (init and assign), and the ones used
 //              by the motion integrators of dyna (which only act on the
 //              orrientation)
+//              The orientation matrix A is derived lazily from the
+//              quaternion q: the operations on q only mark A as out of date,
+//              and get_A() recomputes it when it is actually read.
 //              The class is internal to the DL module
 // author: Bart Barenbrug   May '96
 
@@ -56,15 +59,22 @@ class DL_supvec {
     DL_vector  v;
     DL_vector4 q;
     DL_vector  w;
-    DL_matrix  A;
     
     void       init(DL_point*,DL_vector*,DL_vector4*,DL_vector*, DL_matrix*);
     void       assign(DL_supvec*);
 
+    DL_matrix* get_A(void);   // the orientation matrix, up to date with q
+    void       set_A(DL_matrix*);
+
     void       plusis(DL_supvec*);
     void       timesis(DL_Scalar);
     void       times(DL_Scalar,DL_supvec*);       
     void       plus(DL_supvec*,DL_supvec*);
+    // fused versions for the integrator stages (one pass over q and w):
+    void       plustimes(DL_supvec*,DL_Scalar,DL_supvec*);
+                               // self:=y+a*k
+    void       pluslincomb(DL_supvec*,DL_Scalar,int,DL_Scalar*,DL_supvec**);
+                               // self:=y+a*(b[0]*k[0]+...+b[n-1]*k[n-1])
 
     void       q2A(DL_dyna*);
     void       A2q();
@@ -73,8 +83,29 @@ class DL_supvec {
     DL_supvec(DL_point*,DL_vector*,DL_vector4*,DL_vector*,DL_matrix*);
                                                         // constructor
     ~DL_supvec(){};                                     // destructor
+
+  protected:
+    DL_matrix  A;
+    boolean    Adirty;   // TRUE if A has not been derived from q yet
 };
 
+// ******************** //
+// inline member bodies //
+// ******************** //
+
+inline DL_matrix* DL_supvec::get_A(void) {
+  if (Adirty) {
+    q.to_matrix(&A);
+    Adirty=FALSE;
+  }
+  return &A;
+}
+
+inline void DL_supvec::set_A(DL_matrix *nA) {
+  A.assign(nA);
+  Adirty=FALSE;
+}
+
 // handy for debugging:
 #define PRINTSUPVEC(S) \
   Msg("z=(%f,%f,%f)\nv=(%f,%f,%f)\nw=(%f,%f,%f)\nq=(%f,%f,%f,%f)\n  (%f %f %f)\nA=(%f %f %f)\n  (%f %f %f)\n", \
@@ -82,7 +113,7 @@ class DL_supvec {
       S->v.x, S->v.y, S->v.z, \
       S->w.x, S->w.y, S->w.z, \
       S->q.c[0], S->q.c[1], S->q.c[2], S->q.c[3], \
-      S->A.c0->x, S->A.c1->x, S->A.c2->x, \
-      S->A.c0->y, S->A.c1->y, S->A.c2->y, \
-      S->A.c0->z, S->A.c1->z, S->A.c2->z );
+      S->get_A()->c0.x, S->get_A()->c1.x, S->get_A()->c2.x, \
+      S->get_A()->c0.y, S->get_A()->c1.y, S->get_A()->c2.y, \
+      S->get_A()->c0.z, S->get_A()->c1.z, S->get_A()->c2.z );
 #endif
@@ -0,0 +1,123 @@
+/*
+  DYNAMO - Dynamic Motion library
+  Copyright (C) 1996-1999 Bart Barenbrug
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Library General Public
+  License as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Library General Public License for more details.
+
+  You should have received a copy of the GNU Library General Public
+  License along with this library; if not, write to the Free
+  Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+  Please send remarks, questions and bug reports to bartb@win.tue.nl,
+  or write to:
+                  Bart Barenbrug
+		  Department of Mathematics and Computing Science
+		  Eindhoven University of Technology
+		  P.O. Box 513, 5600 MB Eindhoven, The Netherlands
+*/
+
+//
+// filename	: tree_solver.h
+// description	: sparse block elimination of dCdR in tree order.
+//                dCdR has a block for each pair of constraints that
+//                share a dyna. For a tree of dynas and joints (chains,
+//                robot arms) the constraints can be eliminated from the
+//                leaves inward without creating new nonzero blocks, so
+//                decomposing and solving take time linear in the number
+//                of joints instead of the cubic (or bandwidth squared)
+//                time of the LU decomposition of the whole matrix. The
+//                leaves are eliminated first, which takes linear time to
+//                find as well; when there are none left the elimination
+//                order is found greedily (least fill-in first), so loop
+//                closing constraints and contacts are handled as well:
+//                they just cause some fill-in.
+//                A matrix that is already block banded (a chain, after
+//                DL_constraint_manager::sort_constraints) is eliminated
+//                in its own order, which makes this the block version of
+//                the Thomas algorithm for block tridiagonal matrices.
+//
+
+#ifndef DL_TREESOLVERH
+#define DL_TREESOLVERH
+
+#include "scalar.h"
+#include "boolean.h"
+#include "largevector.h"
+#include "largematrix.h"
+
+// ******************** //
+// class DL_tree_solver //
+// ******************** //
+
+class DL_tree_solver {
+  protected:
+    int  n;          // number of blocks
+    int  size;       // total dimension (sum of the block dimensions)
+    int  maxdim;     // largest block dimension
+    int  *bidx;      // row/column index of each block in the matrix
+    int  *bdim;      // dimension of each block
+    int  *blockat;   // block starting at each index (-1: none)
+
+    // block graph (only used during analysis):
+    int  *nrnb, *nbsize; // number of neighbours and size of nb[i]
+    int  **nb;           // neighbours of each block
+
+    // elimination structure:
+    int  *order;     // blocks in elimination order
+    int  *pos;       // position of each block in the elimination order
+    int  *upstart;   // the neighbours of block i that are eliminated
+    int  *up;        //   after it are up[upstart[i]..upstart[i+1]-1]
+    int  nrfill;     // number of block pairs created by fill-in
+
+    // numerical values (all taken from val):
+    DL_Scalar *val;
+    int  valsize;
+    int  *doff;      // offset of the diagonal block of each block
+    int  *uoff;      // offset of the block (i,up[k]) of the upper factor
+    int  *loff;      // offset of the block (up[k],i) of the lower factor
+    DL_Scalar *tmp;  // scratch space (maxdim*maxdim+maxdim elements)
+
+    void      clear(void);
+    void      addnb(int,int);
+    boolean   hasnb(int,int);
+    DL_Scalar *block(int,int);
+    boolean   invert(DL_Scalar*,int);
+
+  public:
+    void      init(int,int);   // start a new structure for a number of
+                               // blocks and the matrix dimension
+    void      setblock(int,int,int); // block number, index, dimension
+    void      connect(int,int);      // the blocks at these indices
+                                     // influence each other
+    int       get_blockband(void);
+                               // the largest distance between the
+                               // numbers of two connected blocks
+    void      analyse(boolean=TRUE);
+                               // determine the elimination order (or keep
+                               // the order of the block numbers if the
+                               // parameter is FALSE) and the structure of
+                               // the factors
+    boolean   factor(DL_largematrix*);
+                               // decompose the matrix. Returns FALSE if
+                               // a (near) singular diagonal block was
+                               // encountered (the decomposition can not
+                               // be used then)
+    void      solve(DL_largevector*,DL_largevector*);
+                               // solve x from Ax=b, using the decomposition
+    int       get_nrfill(void){ return nrfill; };
+                               // the number of fill-in blocks. 0 for
+                               // tree structured constraint graphs
+
+              DL_tree_solver();  // constructor
+              ~DL_tree_solver(); // destructor
+};
+
+#endif
@@ -38,6 +38,7 @@
 #include <math.h>
 #include "pointvector.h"
 #include "matrix.h"
+#include "simd.h"
 
 // **************** //
 // class DL_vector4 //
@@ -76,4 +77,119 @@ class DL_vector4 {
 	       ~DL_vector4(){};                      // destructor
 };
 
+// the operations used by the integrators for every stage of every
+// dyna are inline (and use SSE2 if DL_SSE2 is defined, see simd.h):
+
+inline void DL_vector4::assign(DL_vector4* v) {
+  if (v) {
+#ifdef DL_SSE2
+    _mm_storeu_pd(c,_mm_loadu_pd(v->c));
+    _mm_storeu_pd(c+2,_mm_loadu_pd(v->c+2));
+#else
+    c[0]=v->c[0]; 
+    c[1]=v->c[1]; 
+    c[2]=v->c[2]; 
+    c[3]=v->c[3];
+#endif
+  }
+}
+
+inline void DL_vector4::plusis(DL_vector4* v) { 
+  if (v) {
+#ifdef DL_SSE2
+    _mm_storeu_pd(c,_mm_add_pd(_mm_loadu_pd(c),_mm_loadu_pd(v->c)));
+    _mm_storeu_pd(c+2,_mm_add_pd(_mm_loadu_pd(c+2),_mm_loadu_pd(v->c+2)));
+#else
+    c[0] += v->c[0]; 
+    c[1] += v->c[1]; 
+    c[2] += v->c[2]; 
+    c[3] += v->c[3]; 
+#endif
+  }
+}
+
+inline void DL_vector4::timesis(DL_Scalar f) { 
+#ifdef DL_SSE2
+  __m128d ff=_mm_set1_pd(f);
+  _mm_storeu_pd(c,_mm_mul_pd(_mm_loadu_pd(c),ff));
+  _mm_storeu_pd(c+2,_mm_mul_pd(_mm_loadu_pd(c+2),ff));
+#else
+  c[0] *= f; 
+  c[1] *= f; 
+  c[2] *= f; 
+  c[3] *= f; 
+#endif
+}
+
+inline void DL_vector4::plus(DL_vector4* v,DL_vector4 *nv) { 
+#ifdef DL_SSE2
+  _mm_storeu_pd(nv->c,_mm_add_pd(_mm_loadu_pd(c),_mm_loadu_pd(v->c)));
+  _mm_storeu_pd(nv->c+2,_mm_add_pd(_mm_loadu_pd(c+2),_mm_loadu_pd(v->c+2)));
+#else
+  nv->c[0]=c[0] + v->c[0];
+  nv->c[1]=c[1] + v->c[1];
+  nv->c[2]=c[2] + v->c[2];
+  nv->c[3]=c[3] + v->c[3];
+#endif
+}
+
+inline void DL_vector4::minus(DL_vector4 *v,DL_vector4 *nv) { 
+#ifdef DL_SSE2
+  _mm_storeu_pd(nv->c,_mm_sub_pd(_mm_loadu_pd(c),_mm_loadu_pd(v->c)));
+  _mm_storeu_pd(nv->c+2,_mm_sub_pd(_mm_loadu_pd(c+2),_mm_loadu_pd(v->c+2)));
+#else
+  nv->c[0]=c[0] - v->c[0];
+  nv->c[1]=c[1] - v->c[1];
+  nv->c[2]=c[2] - v->c[2];
+  nv->c[3]=c[3] - v->c[3];
+#endif
+}
+
+inline void DL_vector4::times(DL_Scalar t, DL_vector4 *nv) {
+#ifdef DL_SSE2
+  __m128d tt=_mm_set1_pd(t);
+  _mm_storeu_pd(nv->c,_mm_mul_pd(_mm_loadu_pd(c),tt));
+  _mm_storeu_pd(nv->c+2,_mm_mul_pd(_mm_loadu_pd(c+2),tt));
+#else
+  nv->c[0]=c[0]*t;
+  nv->c[1]=c[1]*t;
+  nv->c[2]=c[2]*t;
+  nv->c[3]=c[3]*t;
+#endif
+}
+
+inline void DL_vector4::times(DL_vector* w,DL_vector4* nv) {
+  //                  1 ( 0  -w^T )
+  // implements nv:= ---(         ) self  , where w~ is the outer produkt
+  //                  2 ( w  -w~  )         matrix
+  //                    (         )
+  DL_Scalar wx=w->x, wy=w->y, wz=w->z;
+#ifdef DL_SSE2
+  // (nv0,nv1) and (nv2,nv3) each as a sum of three products; a
+  // subtraction is the addition of a negated product, which is exact,
+  // so this gives the same result as the scalar code:
+  __m128d q01=_mm_loadu_pd(c);                     // (c0,c1)
+  __m128d q23=_mm_loadu_pd(c+2);                   // (c2,c3)
+  __m128d q10=_mm_shuffle_pd(q01,q01,1);           // (c1,c0)
+  __m128d q00=_mm_unpacklo_pd(q01,q01);            // (c0,c0)
+  __m128d q11=_mm_unpackhi_pd(q01,q01);            // (c1,c1)
+  __m128d q22=_mm_unpacklo_pd(q23,q23);            // (c2,c2)
+  __m128d q33=_mm_unpackhi_pd(q23,q23);            // (c3,c3)
+  __m128d s01=_mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(wx),q10),
+				    _mm_mul_pd(_mm_set_pd(wz,wy),q22)),
+			 _mm_mul_pd(_mm_set_pd(-wy,wz),q33));
+  __m128d s23=_mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set_pd(wz,wy),q00),
+				    _mm_mul_pd(_mm_set_pd(wy,-wz),q11)),
+			 _mm_mul_pd(_mm_set_pd(-wx,wx),_mm_shuffle_pd(q33,q22,0)));
+  _mm_storeu_pd(nv->c,_mm_mul_pd(_mm_set_pd(0.5,-0.5),s01));
+  _mm_storeu_pd(nv->c+2,_mm_mul_pd(_mm_set1_pd(0.5),s23));
+#else
+  DL_Scalar c0=c[0], c1=c[1], c2=c[2], c3=c[3];
+  nv->c[0] = -0.5*(            wx*c1 + wy*c2 + wz*c3);
+  nv->c[1] =  0.5*(wx*c0             + wz*c2 - wy*c3);
+  nv->c[2] =  0.5*(wy*c0 - wz*c1             + wx*c3);
+  nv->c[3] =  0.5*(wz*c0 + wy*c1 - wx*c2            );
+#endif
+}
+
 #endif